@@ -0,0 +1,222 @@
+#pragma once
+
+#include <stdint.h>
+
+// Pure alert logic: no I/O, so every transition can be driven from a host build.
+// Each tick the sketch feeds AlertInputs in, gets back at most one one-shot cue,
+// and reads the desired steady outputs for the current state.
+
+enum AlertState : uint8_t {
+  ALERT_NO_FIX,
+  ALERT_CRUISING,
+  ALERT_OVERSPEED,
+  ALERT_PROXIMITY,
+  ALERT_MODE_DISPLAY,
+  ALERT_STALE_FIX,  // the receiver reports a fix but no position arrived for a while
+  ALERT_STATE_COUNT,
+  ALERT_ANY = 0xFF  // wildcard in the transition table
+};
+
+struct AlertInputs {
+  bool hasFix;
+  bool fixStale;     // no new position for the stale time (degraded mode)
+  bool inProximity;
+  bool modeDisplay;  // speed limit mode is being shown after a button press
+  int speedKmh;
+  int speedLimit;  // 0 = no limit set
+  bool inZone;     // inside an alert zone (school, roadworks, low emission)
+};
+
+enum AlertLed : uint8_t {
+  ALERT_LED_RED,
+  ALERT_LED_GREEN,
+  ALERT_LED_MODE_BLINK,  // off briefly after the press, then green
+  ALERT_LED_BEEP_WHITE,  // white while the buzzer sounds, off between beeps
+  ALERT_LED_DEGRADED     // positions are stale
+};
+
+enum AlertDisplay : uint8_t {
+  ALERT_DISPLAY_LOADING,
+  ALERT_DISPLAY_SPEED,
+  ALERT_DISPLAY_MODE
+};
+
+enum AlertSound : uint8_t {
+  ALERT_SOUND_NONE,
+  ALERT_SOUND_PROXIMITY,
+  ALERT_SOUND_OVERSPEED_SLOW,    // up to the slow band over (default 1-5 km/h)
+  ALERT_SOUND_OVERSPEED_MEDIUM,  // up to the medium band over (default 6-15 km/h)
+  ALERT_SOUND_OVERSPEED_FAST     // above the medium band
+};
+
+// One-shot sounds fired on transitions
+enum AlertCue : uint8_t {
+  ALERT_CUE_NONE,
+  ALERT_CUE_SIGNAL_FOUND,
+  ALERT_CUE_SIGNAL_LOST,
+  ALERT_CUE_PROXIMITY_EXIT,
+  ALERT_CUE_ZONE_ENTER  // not a state change: fired when no transition cue is due
+};
+
+struct AlertOutputs {
+  AlertLed led;
+  AlertDisplay display;
+  AlertSound sound;
+};
+
+class AlertStateMachine {
+private:
+  // State selection: first matching row wins. Mode display is an overlay row:
+  // it hides the base state but does not take part in cue transitions.
+  typedef bool (*AlertCondition)(const AlertInputs &in);
+
+  struct AlertRule {
+    AlertState state;
+    bool overlay;
+    AlertCondition when;
+  };
+
+  // A stale position cannot put the car near a camera
+  static bool inProximity(const AlertInputs &in) {
+    return in.hasFix && !in.fixStale && in.inProximity;
+  }
+
+  static bool modeDisplay(const AlertInputs &in) {
+    return in.modeDisplay;
+  }
+
+  static bool staleFix(const AlertInputs &in) {
+    return in.hasFix && in.fixStale;
+  }
+
+  static bool noFix(const AlertInputs &in) {
+    return !in.hasFix;
+  }
+
+  static bool overspeed(const AlertInputs &in) {
+    return in.speedLimit > 0 && in.speedKmh > in.speedLimit;
+  }
+
+  static bool always(const AlertInputs &) {
+    return true;
+  }
+
+  // RULES, STATE_OUTPUTS and TRANSITIONS are looped over and indexed with no
+  // out-of-class definition, which needs C++17 inline variables
+  static_assert(__cplusplus >= 201703L, "AlertStateMachine needs C++17");
+
+  static constexpr AlertRule RULES[] = {
+    { ALERT_PROXIMITY, false, inProximity },
+    { ALERT_MODE_DISPLAY, true, modeDisplay },
+    { ALERT_STALE_FIX, false, staleFix },
+    { ALERT_NO_FIX, false, noFix },
+    { ALERT_OVERSPEED, false, overspeed },
+    { ALERT_CRUISING, false, always }
+  };
+
+  // Steady outputs per state (indexed by AlertState)
+  static constexpr AlertOutputs STATE_OUTPUTS[ALERT_STATE_COUNT] = {
+    { ALERT_LED_RED, ALERT_DISPLAY_LOADING, ALERT_SOUND_NONE },          // ALERT_NO_FIX
+    { ALERT_LED_GREEN, ALERT_DISPLAY_SPEED, ALERT_SOUND_NONE },          // ALERT_CRUISING
+    { ALERT_LED_BEEP_WHITE, ALERT_DISPLAY_SPEED, ALERT_SOUND_NONE },     // ALERT_OVERSPEED (sound set per band)
+    { ALERT_LED_BEEP_WHITE, ALERT_DISPLAY_SPEED, ALERT_SOUND_PROXIMITY },// ALERT_PROXIMITY
+    { ALERT_LED_MODE_BLINK, ALERT_DISPLAY_MODE, ALERT_SOUND_NONE },      // ALERT_MODE_DISPLAY
+    { ALERT_LED_DEGRADED, ALERT_DISPLAY_LOADING, ALERT_SOUND_NONE }      // ALERT_STALE_FIX
+  };
+
+  // Cues between base states, first match wins
+  struct AlertTransition {
+    AlertState from;
+    AlertState to;
+    AlertCue cue;
+  };
+
+  // A stale fix sounds like a lost one, without a second cue if the fix then goes
+  static constexpr AlertTransition TRANSITIONS[] = {
+    { ALERT_STALE_FIX, ALERT_NO_FIX, ALERT_CUE_NONE },
+    { ALERT_NO_FIX, ALERT_STALE_FIX, ALERT_CUE_NONE },
+    { ALERT_NO_FIX, ALERT_ANY, ALERT_CUE_SIGNAL_FOUND },
+    { ALERT_STALE_FIX, ALERT_ANY, ALERT_CUE_SIGNAL_FOUND },
+    { ALERT_ANY, ALERT_NO_FIX, ALERT_CUE_SIGNAL_LOST },
+    { ALERT_ANY, ALERT_STALE_FIX, ALERT_CUE_SIGNAL_LOST },
+    { ALERT_PROXIMITY, ALERT_ANY, ALERT_CUE_PROXIMITY_EXIT }
+  };
+
+  AlertState state = ALERT_NO_FIX;      // visible state
+  AlertState baseState = ALERT_NO_FIX;  // state without the overlay
+  AlertSound overspeedSound = ALERT_SOUND_NONE;
+  bool inZone = false;  // zone entry was announced
+  int slowBandKmh = 5;
+  int mediumBandKmh = 15;
+
+  static AlertState select(const AlertInputs &in, bool withOverlay) {
+    for (const AlertRule &rule : RULES) {
+      if ((withOverlay || !rule.overlay) && rule.when(in)) {
+        return rule.state;
+      }
+    }
+    return ALERT_CRUISING;
+  }
+
+  static AlertCue cueFor(AlertState from, AlertState to) {
+    if (from == to) {
+      return ALERT_CUE_NONE;
+    }
+    for (const AlertTransition &t : TRANSITIONS) {
+      if ((t.from == ALERT_ANY || t.from == from) && (t.to == ALERT_ANY || t.to == to)) {
+        return t.cue;
+      }
+    }
+    return ALERT_CUE_NONE;
+  }
+
+  AlertSound overspeedBand(const AlertInputs &in) const {
+    int over = in.speedKmh - in.speedLimit;
+    if (over <= slowBandKmh) return ALERT_SOUND_OVERSPEED_SLOW;
+    if (over <= mediumBandKmh) return ALERT_SOUND_OVERSPEED_MEDIUM;
+    return ALERT_SOUND_OVERSPEED_FAST;
+  }
+
+public:
+  // km/h over the limit up to which the slow / medium warning plays
+  void setOverspeedBands(int slowKmh, int mediumKmh) {
+    slowBandKmh = slowKmh;
+    mediumBandKmh = mediumKmh;
+  }
+
+  // Evaluate one tick, returns the cue for this tick's transition (if any)
+  AlertCue step(const AlertInputs &in) {
+    AlertState nextBase = select(in, false);
+    AlertCue cue = cueFor(baseState, nextBase);
+
+    // Only a live fix can enter a zone, as with proximity. The entry cue
+    // waits a tick if a transition cue is due.
+    if (!(in.inZone && in.hasFix && !in.fixStale)) {
+      inZone = false;
+    } else if (!inZone && cue == ALERT_CUE_NONE) {
+      cue = ALERT_CUE_ZONE_ENTER;
+      inZone = true;
+    }
+
+    baseState = nextBase;
+    state = select(in, true);
+    overspeedSound = state == ALERT_OVERSPEED ? overspeedBand(in) : ALERT_SOUND_NONE;
+    return cue;
+  }
+
+  AlertOutputs outputs() const {
+    AlertOutputs out = STATE_OUTPUTS[state];
+    if (state == ALERT_OVERSPEED) {
+      out.sound = overspeedSound;
+    }
+    return out;
+  }
+
+  AlertState getState() const {
+    return state;
+  }
+
+  AlertState getBaseState() const {
+    return baseState;
+  }
+};
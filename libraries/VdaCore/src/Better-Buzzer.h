@@ -0,0 +1,167 @@
+#pragma once
+
+#include "OutputShadow.h"
+
+// One step of a buzzer pattern: sound frequency (0 = rest) for durationMs, then stay silent for gapMs
+struct BuzzerNote {
+  uint16_t frequency;
+  uint16_t durationMs;
+  uint16_t gapMs;
+};
+
+struct BuzzerPattern {
+  const BuzzerNote *notes;
+  uint8_t count;
+  bool loop;
+};
+
+// Build a pattern from a constexpr note table
+template<size_t N>
+constexpr BuzzerPattern buzzerPattern(const BuzzerNote (&notes)[N], bool loop = false) {
+  return { notes, (uint8_t)N, loop };
+}
+
+// Higher priorities preempt lower ones; lower ones are dropped while a higher one plays
+enum BuzzerPriority : uint8_t {
+  BUZZER_IDLE = 0,
+  BUZZER_UI = 1,
+  BUZZER_OVERSPEED = 2,
+  BUZZER_PROXIMITY = 3
+};
+
+class BetterBuzzer {
+private:
+  uint8_t PIN;
+
+  static const unsigned long MAX_CATCH_UP_MS = 50;
+
+  const BuzzerPattern *pattern = nullptr;
+  uint8_t priority = BUZZER_IDLE;
+  uint8_t noteIndex = 0;
+  bool inGap = false;
+  unsigned long stepStart = 0;
+  unsigned long stepLength = 0;
+
+  // Frequency currently on the pin (0 = silent)
+  OutputShadow<uint16_t> toneShadow;
+  OutputStats outputStats;
+
+  void writeTone(uint16_t frequency) {
+    if (!toneShadow.update(frequency, outputStats)) return;
+
+    if (frequency > 0) {
+      tone(PIN, frequency);
+    } else {
+      noTone(PIN);
+    }
+  }
+
+  void startNote(unsigned long now) {
+    const BuzzerNote &note = pattern->notes[noteIndex];
+    inGap = false;
+    stepStart = now;
+    stepLength = note.durationMs;
+    writeTone(note.frequency);
+  }
+
+  void startGap(unsigned long now) {
+    const BuzzerNote &note = pattern->notes[noteIndex];
+    inGap = true;
+    stepStart = now;
+    stepLength = note.gapMs;
+
+    // A zero gap keeps the tone going into the next note
+    if (stepLength > 0) {
+      writeTone(0);
+    }
+  }
+
+  void finish() {
+    writeTone(0);
+    pattern = nullptr;
+    priority = BUZZER_IDLE;
+  }
+
+public:
+  void begin(uint8_t pin) {
+    PIN = pin;
+    toneShadow.invalidate();
+    writeTone(0);
+  }
+
+  // Start a pattern unless something more important is playing. Returns true if it started.
+  bool play(const BuzzerPattern &newPattern, uint8_t newPriority) {
+    if (pattern != nullptr && newPriority < priority) {
+      return false;
+    }
+
+    pattern = &newPattern;
+    priority = newPriority;
+    noteIndex = 0;
+    startNote(millis());
+    return true;
+  }
+
+  // Stop the current pattern if it was started with this priority
+  void stop(uint8_t stopPriority) {
+    if (pattern != nullptr && priority == stopPriority) {
+      finish();
+    }
+  }
+
+  void stopAll() {
+    finish();
+  }
+
+  bool isPlaying(const BuzzerPattern &candidate) {
+    return pattern == &candidate;
+  }
+
+  bool isBusy() {
+    return pattern != nullptr;
+  }
+
+  // True while a tone is actually sounding (not in a rest or gap)
+  bool isSounding() {
+    return toneShadow.get() > 0;
+  }
+
+  uint8_t activePriority() {
+    return priority;
+  }
+
+  // tone()/noTone() calls done and skipped since begin()
+  const OutputStats &getOutputStats() {
+    return outputStats;
+  }
+
+  // Advance the sequencer, call once per loop
+  void tick() {
+    if (pattern == nullptr) {
+      return;
+    }
+
+    unsigned long now = millis();
+
+    // Step forward through every elapsed step. Small lags are absorbed so the
+    // rhythm does not drift; after a long stall the pattern resumes from now.
+    // The step budget keeps all-zero patterns from spinning.
+    int budget = 2 * pattern->count + 2;
+    while (pattern != nullptr && now - stepStart >= stepLength && budget-- > 0) {
+      unsigned long stepEnd = stepStart + stepLength;
+      unsigned long base = now - stepEnd > MAX_CATCH_UP_MS ? now : stepEnd;
+
+      if (!inGap) {
+        startGap(base);
+      } else if (noteIndex + 1 < pattern->count) {
+        noteIndex++;
+        startNote(base);
+      } else if (pattern->loop) {
+        noteIndex = 0;
+        startNote(base);
+      } else {
+        finish();
+      }
+    }
+  }
+};
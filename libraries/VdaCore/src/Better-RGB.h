@@ -0,0 +1,473 @@
+#pragma once
+
+#include "OutputShadow.h"
+#include "BoardPolicy.h"
+
+struct LedColor {
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+};
+
+// Channel masks
+constexpr uint8_t LED_RED = 0x01;
+constexpr uint8_t LED_GREEN = 0x02;
+constexpr uint8_t LED_BLUE = 0x04;
+constexpr uint8_t LED_ALL = LED_RED | LED_GREEN | LED_BLUE;
+
+// How an effect moves through its keyframes
+enum LedEffectMode : uint8_t {
+  LED_STEP_DIGITAL,  // show each frame for frameMs as on/off
+  LED_STEP_ANALOG,   // show each frame for frameMs as PWM levels
+  LED_FADE           // interpolate between consecutive frames over frameMs each
+};
+
+// Hardware fades through the LEDC peripheral on arduino-esp32 3.x; the
+// ESP8266 core (3.x, also C++17) and the host interpolate in software
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#define BETTER_RGB_LEDC_FADE 1
+#else
+#define BETTER_RGB_LEDC_FADE 0
+#endif
+
+// Board: pins LED_R / LED_G / LED_B (NO_PIN for a missing channel),
+// LED_COMMON_CATHODE and the GPIO backend Io (see BoardPolicy.h)
+template<typename Board>
+class BetterRGB {
+private:
+  typedef typename Board::Io Io;
+
+  static const uint8_t MAX_EFFECTS = 4;
+
+  struct LedEffect {
+    const LedColor *frames;    // keyframes (nullptr = use localFrames)
+    LedColor localFrames[2];   // storage for runtime colors
+    uint8_t frameCount;
+    uint8_t mask;
+    LedEffectMode mode;
+    bool loop;
+    bool offAtEnd;             // clear the channels when a step effect ends
+    int16_t currentFrame;      // frame (or fade segment) last applied, -1 = none; holds every uint8_t index
+    unsigned long start;
+    unsigned long frameMs;
+  };
+
+  // Active effects, compacted: only the first activeCount entries are live
+  LedEffect effects[MAX_EFFECTS];
+  uint8_t activeCount = 0;
+
+  // Pins currently driven by PWM (need pinMode() before digital writes again)
+  uint8_t analogMask = 0;
+
+  // Last level written per channel: 0-255 for PWM, DIGITAL_OFF / DIGITAL_ON for digital
+  static const int16_t DIGITAL_OFF = 0x100;
+  static const int16_t DIGITAL_ON = 0x101;
+  OutputShadow<int16_t> pinShadow[3];
+  OutputStats outputStats;
+
+  static uint8_t channelIndex(uint8_t channel) {
+    return channel >> 1;  // LED_RED, LED_GREEN, LED_BLUE -> 0, 1, 2
+  }
+
+  static constexpr uint8_t pinFor(uint8_t channel) {
+    return channel == LED_RED ? Board::LED_R : channel == LED_GREEN ? Board::LED_G : Board::LED_B;
+  }
+
+  // Output level that lights a channel, and the PWM duty for a brightness
+  static constexpr bool onLevel(bool isOn) {
+    return Board::LED_COMMON_CATHODE ? isOn : !isOn;
+  }
+
+  static constexpr uint8_t duty(int value) {
+    return Board::LED_COMMON_CATHODE ? value : 255 - value;
+  }
+
+  static uint8_t channelValue(const LedColor &color, uint8_t channel) {
+    return channel == LED_RED ? color.red : channel == LED_GREEN ? color.green : color.blue;
+  }
+
+  void writeDigital(uint8_t channel, bool isOn) {
+    if (!pinShadow[channelIndex(channel)].update(isOn ? DIGITAL_ON : DIGITAL_OFF, outputStats)) return;
+
+    if (analogMask & channel) {
+      Io::output(pinFor(channel));  // take the pin back from PWM
+      analogMask &= ~channel;
+    }
+    Io::write(pinMask(pinFor(channel)), onLevel(isOn));
+  }
+
+  void writeAnalog(uint8_t channel, int value) {
+    value = constrain(value, 0, 255);
+    if (!pinShadow[channelIndex(channel)].update(value, outputStats)) return;
+    if (pinFor(channel) == NO_PIN) return;
+
+    Io::analog(pinFor(channel), duty(value));
+    analogMask |= channel;
+  }
+
+  void applyFrame(uint8_t mask, LedEffectMode mode, const LedColor &color) {
+    for (uint8_t channel = LED_RED; channel <= LED_BLUE; channel <<= 1) {
+      if (!(mask & channel)) continue;
+
+      if (mode == LED_STEP_DIGITAL) {
+        writeDigital(channel, channelValue(color, channel) > 0);
+      } else {
+        writeAnalog(channel, channelValue(color, channel));
+      }
+    }
+  }
+
+  void applyOff(uint8_t mask) {
+    for (uint8_t channel = LED_RED; channel <= LED_BLUE; channel <<= 1) {
+      if (mask & channel) writeDigital(channel, false);
+    }
+  }
+
+  // Interpolated level of one channel inside fade segment `segment`
+  static int fadeValue(const LedColor *frames, uint8_t segment, uint8_t channel, unsigned long t, unsigned long length) {
+    int from = channelValue(frames[segment], channel);
+    int to = channelValue(frames[segment + 1], channel);
+    return from + (int)((long)(to - from) * (long)t / (long)length);
+  }
+
+  void startFadeSegment(LedEffect &effect, const LedColor *frames, uint8_t segment) {
+#if BETTER_RGB_LEDC_FADE
+    // Let the LEDC peripheral run the ramp; update() only tracks segment boundaries
+    for (uint8_t channel = LED_RED; channel <= LED_BLUE; channel <<= 1) {
+      if (!(effect.mask & channel)) continue;
+      int from = channelValue(frames[segment], channel);
+      int to = channelValue(frames[segment + 1], channel);
+      if (pinFor(channel) == NO_PIN) continue;
+
+      writeAnalog(channel, from);  // attaches the pin to LEDC if needed
+      ledcFade(pinFor(channel), duty(from), duty(to), effect.frameMs);
+      pinShadow[channelIndex(channel)].invalidate();  // the peripheral moves the level from here
+    }
+#endif
+    effect.currentFrame = segment;
+  }
+
+  // Advance one effect, returns false once it has finished
+  bool runEffect(LedEffect &effect, unsigned long now) {
+    const LedColor *frames = effect.frames ? effect.frames : effect.localFrames;
+    uint8_t steps = effect.mode == LED_FADE ? effect.frameCount - 1 : effect.frameCount;
+    unsigned long total = effect.frameMs * steps;
+    unsigned long elapsed = now - effect.start;
+
+    if (elapsed >= total) {
+      if (effect.loop && total > 0) {
+        effect.start += (elapsed / total) * total;
+        elapsed -= (elapsed / total) * total;
+      } else {
+        if (effect.mode == LED_FADE) {
+          applyFrame(effect.mask, LED_STEP_ANALOG, frames[effect.frameCount - 1]);
+        } else if (effect.offAtEnd) {
+          applyOff(effect.mask);
+        }
+        return false;
+      }
+    }
+
+    uint8_t index = elapsed / effect.frameMs;
+
+    if (effect.mode != LED_FADE) {
+      if (index != effect.currentFrame) {
+        applyFrame(effect.mask, effect.mode, frames[index]);
+        effect.currentFrame = index;
+      }
+      return true;
+    }
+
+    if (index != effect.currentFrame) {
+      startFadeSegment(effect, frames, index);
+    }
+
+#if !BETTER_RGB_LEDC_FADE
+    // Software fade: recompute the level of each channel in this segment
+    unsigned long t = elapsed - (unsigned long)index * effect.frameMs;
+    for (uint8_t channel = LED_RED; channel <= LED_BLUE; channel <<= 1) {
+      if (effect.mask & channel) {
+        writeAnalog(channel, fadeValue(frames, index, channel, t, effect.frameMs));
+      }
+    }
+#endif
+    return true;
+  }
+
+  void removeEffect(uint8_t index) {
+    activeCount--;
+    if (index != activeCount) {
+      effects[index] = effects[activeCount];
+    }
+  }
+
+  // Drop active effects that drive any channel in mask
+  void cancelEffects(uint8_t mask) {
+    for (uint8_t i = 0; i < activeCount;) {
+      if (effects[i].mask & mask) {
+        removeEffect(i);
+      } else {
+        i++;
+      }
+    }
+  }
+
+  LedEffect &addEffect(const LedColor *frames, uint8_t frameCount, unsigned long frameMs, LedEffectMode mode, uint8_t mask, bool loop, bool offAtEnd) {
+    cancelEffects(mask);
+    if (activeCount == MAX_EFFECTS) {
+      removeEffect(0);  // oldest slot goes
+    }
+
+    LedEffect &effect = effects[activeCount++];
+    effect.frames = frames;
+    effect.frameCount = frameCount;
+    effect.mask = mask;
+    effect.mode = mode;
+    effect.loop = loop;
+    effect.offAtEnd = offAtEnd;
+    effect.currentFrame = -1;
+    effect.start = millis();
+    effect.frameMs = frameMs > 0 ? frameMs : 1;
+    return effect;
+  }
+
+  // Start an effect on runtime colors and show its first frame right away
+  void startLocal(LedColor first, LedColor second, uint8_t frameCount, unsigned long frameMs, LedEffectMode mode, uint8_t mask, bool offAtEnd) {
+    LedEffect &effect = addEffect(nullptr, frameCount, frameMs, mode, mask, false, offAtEnd);
+    effect.localFrames[0] = first;
+    effect.localFrames[1] = second;
+    runEffect(effect, effect.start);
+  }
+
+  // Keyframe tables for the built-in effects. playEffect() keeps pointers to
+  // them, so they rely on C++17 inline variables for their storage.
+  static_assert(__cplusplus >= 201703L, "BetterRGB needs C++17");
+  static constexpr LedColor OFF_COLOR = { 0, 0, 0 };
+  static constexpr LedColor WHITE_BLINK_FRAMES[] = { { 0, 0, 0 }, { 255, 255, 255 } };
+  static constexpr LedColor RGB_FRAMES[] = { { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 } };
+  static constexpr LedColor RG_FRAMES[] = { { 255, 0, 0 }, { 0, 255, 0 } };
+  static constexpr LedColor RB_FRAMES[] = { { 255, 0, 0 }, { 0, 0, 255 } };
+  static constexpr LedColor GB_FRAMES[] = { { 0, 255, 0 }, { 0, 0, 255 } };
+  static constexpr LedColor WHITE_FLASH_FRAMES[] = { { 255, 255, 255 }, { 0, 0, 0 } };
+
+  void fade(LedColor from, LedColor to, unsigned int steps, unsigned int delayMs) {
+    startLocal(from, to, 2, (unsigned long)steps * delayMs, LED_FADE, LED_ALL, false);
+  }
+
+public:
+  void begin() {
+    for (uint8_t channel = LED_RED; channel <= LED_BLUE; channel <<= 1) {
+      if (pinFor(channel) != NO_PIN) Io::output(pinFor(channel));
+    }
+
+    for (OutputShadow<int16_t> &shadow : pinShadow) {
+      shadow.invalidate();
+    }
+    analogMask = 0;
+
+    // Initialize all pins to OFF state
+    allOff();
+  }
+
+  // ---------------------------------------------- Simple digital functions ----------------------------------------------
+
+  void setDigitalRed(bool isOn) {
+    writeDigital(LED_RED, isOn);
+  }
+
+  void setDigitalGreen(bool isOn) {
+    writeDigital(LED_GREEN, isOn);
+  }
+
+  void setDigitalBlue(bool isOn) {
+    writeDigital(LED_BLUE, isOn);
+  }
+
+  void allOn() {
+    setDigitalColor(true, true, true);
+  }
+
+  void allOff() {
+    setDigitalColor(false, false, false);
+  }
+
+  void setDigitalColor(bool red, bool green, bool blue) {
+    setDigitalRed(red);
+    setDigitalGreen(green);
+    setDigitalBlue(blue);
+  }
+
+  // ---------------------------------------------- Simple analog functions ----------------------------------------------
+
+  void setAnalogColor(int red, int green, int blue) {
+    writeAnalog(LED_RED, red);
+    writeAnalog(LED_GREEN, green);
+    writeAnalog(LED_BLUE, blue);
+  }
+
+  void setAnalogRed(int redValue) {
+    writeAnalog(LED_RED, redValue);
+  }
+
+  void setAnalogGreen(int greenValue) {
+    writeAnalog(LED_GREEN, greenValue);
+  }
+
+  void setAnalogBlue(int blueValue) {
+    writeAnalog(LED_BLUE, blueValue);
+  }
+
+  // ---------------------------------------------- Effect engine ----------------------------------------------
+
+  // Play a keyframe table on the channels in mask. Effects already driving any
+  // of those channels are replaced; effects on other channels keep running.
+  void playEffect(const LedColor *frames, uint8_t frameCount, unsigned long frameMs, LedEffectMode mode,
+                  uint8_t mask = LED_ALL, bool loop = false, bool offAtEnd = true) {
+    LedEffect &effect = addEffect(frames, frameCount, frameMs, mode, mask, loop, offAtEnd);
+    runEffect(effect, effect.start);
+  }
+
+  // Stop effects on the given channels, leaving the LED as it is
+  void stopEffects(uint8_t mask = LED_ALL) {
+    cancelEffects(mask);
+  }
+
+  bool isPlaying(const LedColor *frames) {
+    for (uint8_t i = 0; i < activeCount; i++) {
+      if (effects[i].frames == frames) return true;
+    }
+    return false;
+  }
+
+  bool isIdle() {
+    return activeCount == 0;
+  }
+
+  // Pin writes done and skipped since boot
+  const OutputStats &getOutputStats() {
+    return outputStats;
+  }
+
+  // ---------------------------------------------- White flashing functions ----------------------------------------------
+
+  void startWhiteFlashing(unsigned long intervalMs = 200) {
+    playEffect(WHITE_BLINK_FRAMES, 2, intervalMs, LED_STEP_DIGITAL, LED_ALL, true);
+  }
+
+  void stopWhiteFlashing() {
+    if (isPlaying(WHITE_BLINK_FRAMES)) {
+      cancelEffects(LED_ALL);
+    }
+    allOff();
+  }
+
+  bool isWhiteFlashing() {
+    return isPlaying(WHITE_BLINK_FRAMES);
+  }
+
+  // ---------------------------------------------- Time based functions ----------------------------------------------
+
+  // Advance active effects, costs nothing when idle
+  void update() {
+    if (activeCount == 0) {
+      return;
+    }
+
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < activeCount;) {
+      if (runEffect(effects[i], now)) {
+        i++;
+      } else {
+        removeEffect(i);
+      }
+    }
+  }
+
+  // ---------------------------------------------- Time based digital functions ----------------------------------------------
+
+  void keepDigitalRedFor(unsigned long ms) {
+    startLocal({ 255, 0, 0 }, OFF_COLOR, 1, ms, LED_STEP_DIGITAL, LED_RED, true);
+  }
+
+  void keepDigitalGreenFor(unsigned long ms) {
+    startLocal({ 0, 255, 0 }, OFF_COLOR, 1, ms, LED_STEP_DIGITAL, LED_GREEN, true);
+  }
+
+  void keepDigitalBlueFor(unsigned long ms) {
+    startLocal({ 0, 0, 255 }, OFF_COLOR, 1, ms, LED_STEP_DIGITAL, LED_BLUE, true);
+  }
+
+  void keepDigitalColorFor(bool red, bool green, bool blue, unsigned long ms) {
+    LedColor color = { (uint8_t)(red ? 255 : 0), (uint8_t)(green ? 255 : 0), (uint8_t)(blue ? 255 : 0) };
+    startLocal(color, OFF_COLOR, 1, ms, LED_STEP_DIGITAL, LED_ALL, true);
+  }
+
+  // ---------------------------------------------- Time based analog functions ----------------------------------------------
+
+  void keepAnalogRedFor(int v, unsigned long ms) {
+    startLocal({ (uint8_t)constrain(v, 0, 255), 0, 0 }, OFF_COLOR, 1, ms, LED_STEP_ANALOG, LED_RED, true);
+  }
+
+  void keepAnalogGreenFor(int v, unsigned long ms) {
+    startLocal({ 0, (uint8_t)constrain(v, 0, 255), 0 }, OFF_COLOR, 1, ms, LED_STEP_ANALOG, LED_GREEN, true);
+  }
+
+  void keepAnalogBlueFor(int v, unsigned long ms) {
+    startLocal({ 0, 0, (uint8_t)constrain(v, 0, 255) }, OFF_COLOR, 1, ms, LED_STEP_ANALOG, LED_BLUE, true);
+  }
+
+  void keepAnalogColorFor(int red, int green, int blue, unsigned long ms) {
+    LedColor color = { (uint8_t)constrain(red, 0, 255), (uint8_t)constrain(green, 0, 255), (uint8_t)constrain(blue, 0, 255) };
+    startLocal(color, OFF_COLOR, 1, ms, LED_STEP_ANALOG, LED_ALL, true);
+  }
+
+  // ---------------------------------------------- Fading functions ----------------------------------------------
+  // Non-blocking: the fade takes steps * delayMs and runs from update()
+
+  void fadeFromRedToBlue(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 255, 0, 0 }, { 0, 0, 255 }, steps, delayMs);
+  }
+
+  void fadeFromRedToGreen(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 255, 0, 0 }, { 0, 255, 0 }, steps, delayMs);
+  }
+
+  void fadeFromGreenToRed(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 0, 255, 0 }, { 255, 0, 0 }, steps, delayMs);
+  }
+
+  void fadeFromGreenToBlue(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 0, 255, 0 }, { 0, 0, 255 }, steps, delayMs);
+  }
+
+  void fadeFromBlueToRed(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 0, 0, 255 }, { 255, 0, 0 }, steps, delayMs);
+  }
+
+  void fadeFromBlueToGreen(unsigned int steps = 50, unsigned int delayMs = 20) {
+    fade({ 0, 0, 255 }, { 0, 255, 0 }, steps, delayMs);
+  }
+
+  // ---------------------------------------------- Flashing functions ----------------------------------------------
+  // Non-blocking: each color shows for delayMs, then the LED turns off
+
+  void flashRGB(unsigned int delayMs = 200) {
+    playEffect(RGB_FRAMES, 3, delayMs, LED_STEP_DIGITAL);
+  }
+
+  void flashRG(unsigned int delayMs = 200) {
+    playEffect(RG_FRAMES, 2, delayMs, LED_STEP_DIGITAL);
+  }
+
+  void flashRB(unsigned int delayMs = 200) {
+    playEffect(RB_FRAMES, 2, delayMs, LED_STEP_DIGITAL);
+  }
+
+  void flashGB(unsigned int delayMs = 200) {
+    playEffect(GB_FRAMES, 2, delayMs, LED_STEP_DIGITAL);
+  }
+
+  void flashWhite(unsigned int delayMs = 200) {
+    playEffect(WHITE_FLASH_FRAMES, 2, delayMs, LED_STEP_DIGITAL);
+  };
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#endif
+
+// Compile-time board policies for the output drivers (BetterRGB, GN1650).
+//
+// A board names its pins, LED polarity and display bus timing as constants
+// and picks a GPIO backend (Io). The drivers are templates on the board, so
+// pin masks and polarity fold into constants and every digital write is a
+// store to the set / clear registers. PWM, pinMode() and delays still go
+// through the Arduino core.
+
+constexpr uint8_t NO_PIN = 0xFF;
+
+constexpr uint32_t pinMask(uint8_t pin) {
+  return pin == NO_PIN ? 0 : 1UL << pin;
+}
+
+// ---------------------------------------------- GPIO backends ----------------------------------------------
+
+#if defined(ARDUINO_ARCH_ESP32)
+// ESP32-C3: GPIO0-21 all sit in the one output / enable register
+struct Esp32C3Gpio {
+  static void output(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+  }
+
+  // Drive the masked pins to level: one store to set, one to clear
+  static inline void write(uint32_t mask, bool level) {
+    REG_WRITE(GPIO_OUT_W1TS_REG, mask & -(uint32_t)level);
+    REG_WRITE(GPIO_OUT_W1TC_REG, mask & ((uint32_t)level - 1));
+  }
+
+  // Output driver off / on again, for open-drain style bus turnarounds
+  static inline void release(uint32_t mask) {
+    REG_WRITE(GPIO_ENABLE_W1TC_REG, mask);
+  }
+
+  static inline void drive(uint32_t mask) {
+    REG_WRITE(GPIO_ENABLE_W1TS_REG, mask);
+  }
+
+  static void analog(uint8_t pin, uint8_t value) {
+    analogWrite(pin, value);
+  }
+
+  static inline void delayUs(uint32_t us) {
+    delayMicroseconds(us);
+  }
+};
+#endif
+
+#if defined(ARDUINO_ARCH_ESP8266)
+// ESP8266: GPIO0-15 (GPIO16 is on the RTC block and not supported here)
+struct Esp8266Gpio {
+  static void output(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+  }
+
+  static inline void write(uint32_t mask, bool level) {
+    GPOS = mask & -(uint32_t)level;
+    GPOC = mask & ((uint32_t)level - 1);
+  }
+
+  static inline void release(uint32_t mask) {
+    GPEC = mask;
+  }
+
+  static inline void drive(uint32_t mask) {
+    GPES = mask;
+  }
+
+  static void analog(uint8_t pin, uint8_t value) {
+    analogWrite(pin, value);
+  }
+
+  static inline void delayUs(uint32_t us) {
+    delayMicroseconds(us);
+  }
+};
+#endif
+
+// Host builds: no hardware, every call is appended to a log that tests can
+// read back and clear. Delays are recorded, not waited.
+enum GpioEventKind : uint8_t {
+  GPIO_EVENT_OUTPUT,   // pin: pinMode(OUTPUT)
+  GPIO_EVENT_WRITE,    // mask, value = level
+  GPIO_EVENT_RELEASE,  // mask
+  GPIO_EVENT_DRIVE,    // mask
+  GPIO_EVENT_ANALOG,   // pin, value = duty 0-255
+  GPIO_EVENT_DELAY     // value = us
+};
+
+struct GpioEvent {
+  GpioEventKind kind;
+  uint8_t pin;
+  uint32_t mask;
+  uint32_t value;
+};
+
+struct HostGpio {
+  static const uint16_t LOG_SIZE = 4096;
+
+  struct Log {
+    GpioEvent events[LOG_SIZE];
+    uint16_t count;
+    uint32_t dropped;  // events after the log filled up
+    uint32_t levels;   // current output levels, bit per pin
+  };
+
+  static Log &log() {
+    static Log instance = {};
+    return instance;
+  }
+
+  static void clear() {
+    Log &l = log();
+    l.count = 0;
+    l.dropped = 0;
+  }
+
+  static void record(GpioEventKind kind, uint8_t pin, uint32_t mask, uint32_t value) {
+    Log &l = log();
+    if (l.count < LOG_SIZE) {
+      l.events[l.count++] = { kind, pin, mask, value };
+    } else {
+      l.dropped++;
+    }
+  }
+
+  static void output(uint8_t pin) {
+    record(GPIO_EVENT_OUTPUT, pin, pinMask(pin), 0);
+  }
+
+  static void write(uint32_t mask, bool level) {
+    Log &l = log();
+    l.levels = level ? l.levels | mask : l.levels & ~mask;
+    record(GPIO_EVENT_WRITE, NO_PIN, mask, level);
+  }
+
+  static void release(uint32_t mask) {
+    record(GPIO_EVENT_RELEASE, NO_PIN, mask, 0);
+  }
+
+  static void drive(uint32_t mask) {
+    record(GPIO_EVENT_DRIVE, NO_PIN, mask, 0);
+  }
+
+  static void analog(uint8_t pin, uint8_t value) {
+    record(GPIO_EVENT_ANALOG, pin, pinMask(pin), value);
+  }
+
+  static void delayUs(uint32_t us) {
+    record(GPIO_EVENT_DELAY, NO_PIN, 0, us);
+  }
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+typedef Esp32C3Gpio NativeGpio;
+#elif defined(ARDUINO_ARCH_ESP8266)
+typedef Esp8266Gpio NativeGpio;
+#else
+typedef HostGpio NativeGpio;
+#endif
+
+// ---------------------------------------------- Boards ----------------------------------------------
+
+// GN1650 bus timing shared by both boards (us): setup / hold per clock
+// phase, start / stop condition edges, pause after each transfer
+struct Gn1650Timing {
+  static constexpr uint8_t BIT_US = 5;
+  static constexpr uint8_t CONDITION_US = 10;
+  static constexpr uint8_t TRANSFER_GAP_US = 100;
+};
+
+// v2: ESP32-C3, common anode RGB LED, GN1650 display
+template<typename GpioBackend = NativeGpio>
+struct V2Board : Gn1650Timing {
+  typedef GpioBackend Io;
+
+  static constexpr uint8_t MODE_SW = 0;
+  static constexpr uint8_t LED_R = 2;
+  static constexpr uint8_t LED_G = 3;
+  static constexpr uint8_t LED_B = 4;
+  static constexpr bool LED_COMMON_CATHODE = false;
+  static constexpr uint8_t GPS_RX = 6;
+  static constexpr uint8_t GPS_TX = 10;
+  static constexpr uint8_t BUZZER = 7;
+  static constexpr uint8_t DISPLAY_DATA = 8;
+  static constexpr uint8_t DISPLAY_CLK = 9;
+  static constexpr bool HAS_DISPLAY = true;
+};
+
+// v1: Wemos D1 mini (ESP8266), common anode red / green LED, no display
+template<typename GpioBackend = NativeGpio>
+struct V1Board : Gn1650Timing {
+  typedef GpioBackend Io;
+
+  static constexpr uint8_t MODE_SW = NO_PIN;
+  static constexpr uint8_t LED_R = 5;  // D1
+  static constexpr uint8_t LED_G = 4;  // D2
+  static constexpr uint8_t LED_B = NO_PIN;
+  static constexpr bool LED_COMMON_CATHODE = false;
+  static constexpr uint8_t GPS_RX = 13;  // D7, the module's TX
+  static constexpr uint8_t GPS_TX = 12;  // D6
+  static constexpr uint8_t BUZZER = 14;  // D5
+  static constexpr uint8_t DISPLAY_DATA = NO_PIN;
+  static constexpr uint8_t DISPLAY_CLK = NO_PIN;
+  static constexpr bool HAS_DISPLAY = false;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpscRing.h"
+
+// Push button input: the pin interrupt timestamps every edge into a queue
+// (producer), poll() debounces the edges and decodes gestures (consumer).
+// All decisions are made on edge timestamps, not on when poll() runs, so a
+// blocked loop delays a gesture but does not lose or re-time it, and a host
+// build can replay an edge list and get the same gestures.
+
+enum ButtonGesture : uint8_t {
+  BUTTON_NONE,
+  BUTTON_SHORT,   // pressed and released, no second press within the double press gap
+  BUTTON_LONG,    // held for the long press time (reported while still held)
+  BUTTON_DOUBLE   // second press within the double press gap (reported on the press)
+};
+
+struct ButtonTiming {
+  uint16_t debounceMs;     // level must be stable this long to count
+  uint16_t longPressMs;
+  uint16_t doublePressMs;  // max release -> press gap of a double press, 0 = off (short reported on release)
+};
+
+struct ButtonEdge {
+  uint32_t timeMs;
+  bool pressed;  // level after the edge
+};
+
+template<size_t QUEUE_SIZE>
+class ButtonInput {
+private:
+  enum Phase : uint8_t {
+    PHASE_IDLE,
+    PHASE_DOWN,      // first press held, long press pending
+    PHASE_RELEASED,  // short press released, waiting for a second press
+    PHASE_HELD       // gesture reported, waiting for the release
+  };
+
+  enum Step : uint8_t {
+    STEP_NONE,
+    STEP_EDGE,
+    STEP_SETTLE,
+    STEP_TIMEOUT
+  };
+
+  ButtonTiming timing;
+  SpscRing<ButtonEdge, QUEUE_SIZE> edges;
+
+  // Edge taken from the queue but not processed yet (a deadline came first)
+  ButtonEdge pending = {};
+  bool hasPending = false;
+
+  // Debouncer: raw level from the last edge and when it changed
+  bool rawPressed = false;
+  uint32_t rawTimeMs = 0;
+  bool pressed = false;
+
+  // Gesture decoder
+  Phase phase = PHASE_IDLE;
+  uint32_t phaseTimeMs = 0;  // press time in PHASE_DOWN, release time in PHASE_RELEASED
+
+  // a is later than b (wrap safe)
+  static bool after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+  }
+
+  bool deadline(uint32_t &at) const {
+    if (phase == PHASE_DOWN) {
+      at = phaseTimeMs + timing.longPressMs;
+      return true;
+    }
+    if (phase == PHASE_RELEASED) {
+      at = phaseTimeMs + timing.doublePressMs;
+      return true;
+    }
+    return false;
+  }
+
+  ButtonGesture onTimeout() {
+    if (phase == PHASE_DOWN) {
+      phase = PHASE_HELD;
+      return BUTTON_LONG;
+    }
+    phase = PHASE_IDLE;
+    return BUTTON_SHORT;
+  }
+
+  ButtonGesture onPress(uint32_t timeMs) {
+    if (phase == PHASE_RELEASED) {
+      phase = PHASE_HELD;
+      return BUTTON_DOUBLE;
+    }
+    phase = PHASE_DOWN;
+    phaseTimeMs = timeMs;
+    return BUTTON_NONE;
+  }
+
+  ButtonGesture onRelease(uint32_t timeMs) {
+    if (phase != PHASE_DOWN) {
+      phase = PHASE_IDLE;
+      return BUTTON_NONE;
+    }
+    if (timing.doublePressMs == 0) {
+      phase = PHASE_IDLE;
+      return BUTTON_SHORT;
+    }
+    phase = PHASE_RELEASED;
+    phaseTimeMs = timeMs;
+    return BUTTON_NONE;
+  }
+
+public:
+  explicit ButtonInput(const ButtonTiming &buttonTiming)
+    : timing(buttonTiming) {}
+
+  // Current level at startup; a button held at boot is ignored until released
+  void begin(bool pressedNow, uint32_t nowMs) {
+    rawPressed = pressed = pressedNow;
+    rawTimeMs = nowMs;
+    phase = pressedNow ? PHASE_HELD : PHASE_IDLE;
+  }
+
+  // ---------------------------------------------- Producer side (pin interrupt) ----------------------------------------------
+
+  void onEdge(bool pressedNow, uint32_t nowMs) {
+    edges.push({ nowMs, pressedNow });
+  }
+
+  // ---------------------------------------------- Consumer side ----------------------------------------------
+
+  // Nothing queued, nothing bouncing and no gesture in progress: poll() would return BUTTON_NONE
+  bool isIdle() const {
+    return !hasPending && edges.isEmpty() && rawPressed == pressed && phase == PHASE_IDLE;
+  }
+
+  // Next gesture decided by nowMs, BUTTON_NONE if there is none (yet).
+  // Call until it returns BUTTON_NONE.
+  ButtonGesture poll(uint32_t nowMs) {
+    for (;;) {
+      if (!hasPending) {
+        hasPending = edges.pop(pending);
+      }
+
+      // Take the earliest due step: the next edge, the level settling or a gesture deadline
+      Step step = STEP_NONE;
+      uint32_t at = nowMs;
+      if (hasPending) {
+        step = STEP_EDGE;
+        at = pending.timeMs;
+      }
+      uint32_t settleAt = rawTimeMs + timing.debounceMs;
+      if (rawPressed != pressed && !after(settleAt, at)) {
+        step = STEP_SETTLE;
+        at = settleAt;
+      }
+      uint32_t deadlineAt;
+      if (deadline(deadlineAt) && !after(deadlineAt, at)) {
+        step = STEP_TIMEOUT;
+      }
+
+      ButtonGesture gesture = BUTTON_NONE;
+      switch (step) {
+        case STEP_NONE:
+          return BUTTON_NONE;
+        case STEP_EDGE:
+          // Edges carry the level, so a dropped edge only costs a debounce period
+          if (pending.pressed != rawPressed) {
+            rawPressed = pending.pressed;
+            rawTimeMs = pending.timeMs;
+          }
+          hasPending = false;
+          break;
+        case STEP_SETTLE:
+          // The debounced edge is dated to the last raw edge
+          pressed = rawPressed;
+          gesture = pressed ? onPress(rawTimeMs) : onRelease(rawTimeMs);
+          break;
+        case STEP_TIMEOUT:
+          gesture = onTimeout();
+          break;
+      }
+      if (gesture != BUTTON_NONE) {
+        return gesture;
+      }
+    }
+  }
+
+  bool isPressed() const {
+    return pressed;
+  }
+
+  // Edges lost to a full queue
+  uint32_t getDroppedEdges() const {
+    return edges.getDroppedCount();
+  }
+};
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpatialGrid.h"
+#include "Progmem.h"
+
+// Compressed camera database, built at compile time from a coordinate table
+// and its region (county) table.
+//
+// Cameras are bucketed per region into 0.25 degree blocks and sorted by
+// (region, block, lat, lon). Each block is encoded on its own:
+//   first camera  varint lat, varint lon offset from the block's south-west corner
+//   next cameras  varint dLat (>= 0, sorted), zigzag varint dLon
+// all in microdegrees, each followed by one byte with the camera's speed
+// limit in km/h (0 = unknown). Each region records its camera bounding box,
+// its slice of the block directory and the regions next to it, so a working
+// set can page in whole regions (see RegionWorkingSet.h).
+//
+// A database instance may be placed with CORE_PROGMEM; the runtime accessors
+// read it through progmemRead(). The block directory stays in flash with the
+// data: decoded cameras are kept in RAM by the region working set, not by a
+// per-block cache, so the directory is only read when a region is paged in.
+// v2/tools/camera_db_bench.cpp prints the size and decode cost for a list.
+
+constexpr int32_t CAMERA_BLOCK_E6 = 250000;  // 0.25 degree, ~28 x 19 km in Hungary
+constexpr uint8_t CAMERA_BLOCK_MAX = 32;     // crowded blocks are split into several entries
+constexpr size_t CAMERA_REGION_MAX = 32;     // regions per database (adjacency is a bit mask)
+
+struct CameraPosition {
+  int32_t latE6;
+  int32_t lonE6;
+  uint8_t limitKmh;  // 0 = unknown
+};
+
+struct CameraBlock {
+  uint32_t key;          // gridKey() of the block at CAMERA_BLOCK_E6
+  uint32_t offset : 24;  // first byte of the block in data[]
+  uint32_t count : 8;
+};
+
+struct CameraRegion {
+  int32_t minLatE6, minLonE6;  // bounding box of the region's cameras
+  int32_t maxLatE6, maxLonE6;
+  uint16_t firstBlock;
+  uint16_t blockCount;
+  uint16_t cameraCount;
+  uint32_t adjacent;  // bit per region whose box is within the adjacency margin (includes itself)
+};
+
+struct CameraDbSize {
+  size_t blocks;
+  size_t bytes;
+  size_t cameras;  // cameras covered by a region (should equal the coordinate count)
+  size_t regions;
+};
+
+template<size_t BLOCKS, size_t BYTES, size_t REGIONS>
+struct CameraDb {
+  static_assert(REGIONS <= CAMERA_REGION_MAX, "adjacency masks hold 32 regions");
+
+  CameraRegion regions[REGIONS];
+  CameraBlock directory[BLOCKS];
+  uint8_t data[BYTES];
+
+  static constexpr size_t regionCount() {
+    return REGIONS;
+  }
+
+  // Most cameras any region and its neighbours hold together (working set capacity)
+  constexpr size_t workingSetSize() const {
+    size_t largest = 0;
+    for (size_t r = 0; r < REGIONS; r++) {
+      size_t total = 0;
+      for (size_t n = 0; n < REGIONS; n++) {
+        if (regions[r].adjacent & (1UL << n)) total += regions[n].cameraCount;
+      }
+      if (total > largest) largest = total;
+    }
+    return largest;
+  }
+
+  CameraRegion region(size_t index) const {
+    return progmemRead(&regions[index]);
+  }
+
+  // Decode one block into out (CAMERA_BLOCK_MAX entries), returns the camera count
+  uint8_t decodeBlock(size_t block, CameraPosition *out) const {
+    CameraBlock entry = progmemRead(&directory[block]);
+    const uint8_t *p = data + entry.offset;
+    int32_t lat = (int32_t)(entry.key >> 16) - 0x8000;
+    int32_t lon = (int32_t)(entry.key & 0xFFFF) - 0x8000;
+    lat *= CAMERA_BLOCK_E6;
+    lon *= CAMERA_BLOCK_E6;
+
+    for (uint8_t i = 0; i < entry.count; i++) {
+      uint32_t dLat = readVarint(p);
+      uint32_t dLon = readVarint(p);
+      lat += (int32_t)dLat;
+      lon += i == 0 ? (int32_t)dLon : (int32_t)(dLon >> 1) ^ -(int32_t)(dLon & 1);
+      out[i] = { lat, lon, progmemByte(p++) };
+    }
+    return entry.count;
+  }
+
+  // Decode all blocks of a region into out (cameraCount entries), returns the count
+  uint16_t decodeRegion(size_t index, CameraPosition *out) const {
+    CameraRegion entry = region(index);
+    uint16_t count = 0;
+    for (uint16_t b = 0; b < entry.blockCount; b++) {
+      count += decodeBlock(entry.firstBlock + b, out + count);
+    }
+    return count;
+  }
+
+  // Distance in meters from a point to a region's bounding box (0 inside)
+  uint32_t distanceToRegion(size_t index, int32_t latE6, int32_t lonE6) const {
+    CameraRegion entry = region(index);
+    int32_t dLat = latE6 < entry.minLatE6 ? entry.minLatE6 - latE6 : latE6 > entry.maxLatE6 ? latE6 - entry.maxLatE6 : 0;
+    int32_t dLon = lonE6 < entry.minLonE6 ? entry.minLonE6 - lonE6 : lonE6 > entry.maxLonE6 ? lonE6 - entry.maxLonE6 : 0;
+
+    int64_t northM = ((int64_t)dLat * GRID_METERS_PER_E6_Q32) >> 32;
+    int64_t eastM = ((int64_t)mulQ30(dLon, sinCos(degreesE6ToAngle(latE6)).cos) * GRID_METERS_PER_E6_Q32) >> 32;
+    return isqrt64(northM * northM + eastM * eastM);
+  }
+
+  static uint32_t readVarint(const uint8_t *&p) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+      uint8_t byte = progmemByte(p++);
+      value |= (uint32_t)(byte & 0x7F) << shift;
+      if (byte < 0x80) return value;
+    }
+  }
+};
+
+// ---------------------------------------------- Compile-time builder ----------------------------------------------
+
+namespace CameraDbBuild {
+
+constexpr uint8_t NO_REGION = 0xFF;
+
+struct Point {
+  uint8_t region;
+  uint32_t key;
+  int32_t latE6;
+  int32_t lonE6;
+  uint8_t limitKmh;
+};
+
+template<size_t N>
+struct Sorted {
+  Point points[N];
+};
+
+constexpr bool before(const Point &a, const Point &b) {
+  return a.region != b.region ? a.region < b.region
+         : a.key != b.key     ? a.key < b.key
+         : a.latE6 != b.latE6 ? a.latE6 < b.latE6
+                              : a.lonE6 < b.lonE6;
+}
+
+template<typename Region, size_t R>
+constexpr uint8_t regionOf(const Region (&regions)[R], size_t index) {
+  for (size_t r = 0; r < R; r++) {
+    if (index >= regions[r].first && index < (size_t)regions[r].first + regions[r].count) return (uint8_t)r;
+  }
+  return NO_REGION;
+}
+
+template<typename Coordinate, size_t N, typename Region, size_t R>
+constexpr Sorted<N> sortPoints(const Coordinate (&coordinates)[N], const Region (&regions)[R]) {
+  Sorted<N> sorted = {};
+  for (size_t i = 0; i < N; i++) {
+    int32_t latE6 = toE6(coordinates[i].lat);
+    int32_t lonE6 = toE6(coordinates[i].lon);
+    Point point = { regionOf(regions, i), gridKey(gridCell(latE6, CAMERA_BLOCK_E6), gridCell(lonE6, CAMERA_BLOCK_E6)), latE6, lonE6,
+                    coordinates[i].limitKmh };
+
+    size_t j = i;
+    while (j > 0 && before(point, sorted.points[j - 1])) {
+      sorted.points[j] = sorted.points[j - 1];
+      j--;
+    }
+    sorted.points[j] = point;
+  }
+  return sorted;
+}
+
+constexpr uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+constexpr size_t varintSize(uint32_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+// cos() for the adjacency margin (not constexpr in the standard library)
+constexpr double cosine(double x) {
+  double term = 1, sum = 1;
+  for (int i = 1; i < 10; i++) {
+    term *= -x * x / ((2 * i - 1) * (2 * i));
+    sum += term;
+  }
+  return sum;
+}
+
+// Walk the sorted points block by block, skipping points outside every region.
+// Emit gets (point, first-in-block, dLat, dLon).
+template<size_t N, typename Emit>
+constexpr void walk(const Sorted<N> &sorted, Emit emit) {
+  uint8_t inBlock = 0;
+  for (size_t i = 0; i < N; i++) {
+    const Point &point = sorted.points[i];
+    if (point.region == NO_REGION) continue;
+
+    const Point &previous = sorted.points[i > 0 ? i - 1 : 0];
+    bool first = i == 0 || point.region != previous.region || point.key != previous.key || inBlock == CAMERA_BLOCK_MAX;
+    inBlock = first ? 1 : inBlock + 1;
+
+    if (first) {
+      int32_t originLat = ((int32_t)(point.key >> 16) - 0x8000) * CAMERA_BLOCK_E6;
+      int32_t originLon = ((int32_t)(point.key & 0xFFFF) - 0x8000) * CAMERA_BLOCK_E6;
+      emit(point, true, (uint32_t)(point.latE6 - originLat), (uint32_t)(point.lonE6 - originLon));
+    } else {
+      emit(point, false, (uint32_t)(point.latE6 - previous.latE6), zigzag(point.lonE6 - previous.lonE6));
+    }
+  }
+}
+
+template<typename Coordinate, size_t N, typename Region, size_t R>
+constexpr CameraDbSize measure(const Coordinate (&coordinates)[N], const Region (&regions)[R]) {
+  CameraDbSize size = { 0, 0, 0, R };
+  walk(sortPoints(coordinates, regions), [&size](const Point &, bool first, uint32_t dLat, uint32_t dLon) {
+    if (first) size.blocks++;
+    size.bytes += varintSize(dLat) + varintSize(dLon) + 1;
+    size.cameras++;
+  });
+  return size;
+}
+
+template<size_t BLOCKS, size_t BYTES, size_t REGIONS>
+constexpr void putVarint(CameraDb<BLOCKS, BYTES, REGIONS> &db, size_t &pos, uint32_t value) {
+  while (value >= 0x80) {
+    db.data[pos++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  db.data[pos++] = (uint8_t)value;
+}
+
+template<size_t BLOCKS, size_t BYTES, size_t REGIONS, typename Coordinate, size_t N, typename Region>
+constexpr CameraDb<BLOCKS, BYTES, REGIONS> build(const Coordinate (&coordinates)[N], const Region (&regionTable)[REGIONS], uint32_t adjacentMarginM) {
+  CameraDb<BLOCKS, BYTES, REGIONS> db = {};
+  size_t block = 0;
+  size_t pos = 0;
+
+  for (CameraRegion &region : db.regions) {
+    region = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN, 0, 0, 0, 0 };
+  }
+
+  walk(sortPoints(coordinates, regionTable), [&](const Point &point, bool first, uint32_t dLat, uint32_t dLon) {
+    CameraRegion &region = db.regions[point.region];
+    if (first) {
+      if (region.blockCount == 0) region.firstBlock = (uint16_t)block;
+      region.blockCount++;
+      db.directory[block++] = { point.key, (uint32_t)pos, 0 };
+    }
+    db.directory[block - 1].count++;
+    putVarint(db, pos, dLat);
+    putVarint(db, pos, dLon);
+    db.data[pos++] = point.limitKmh;
+
+    region.cameraCount++;
+    if (point.latE6 < region.minLatE6) region.minLatE6 = point.latE6;
+    if (point.lonE6 < region.minLonE6) region.minLonE6 = point.lonE6;
+    if (point.latE6 > region.maxLatE6) region.maxLatE6 = point.latE6;
+    if (point.lonE6 > region.maxLonE6) region.maxLonE6 = point.lonE6;
+  });
+
+  // Neighbours: boxes that come within the margin of each other
+  int32_t marginLatE6 = (int32_t)(adjacentMarginM / GRID_METERS_PER_DEGREE * 1e6);
+  for (size_t a = 0; a < REGIONS; a++) {
+    for (size_t b = 0; b < REGIONS; b++) {
+      const CameraRegion &ra = db.regions[a];
+      const CameraRegion &rb = db.regions[b];
+      if (ra.cameraCount == 0 || rb.cameraCount == 0) continue;
+
+      double highestLat = (ra.maxLatE6 > rb.maxLatE6 ? ra.maxLatE6 : rb.maxLatE6) * 1e-6 * M_PI / 180.0;
+      int32_t marginLonE6 = (int32_t)(adjacentMarginM / (GRID_METERS_PER_DEGREE * cosine(highestLat)) * 1e6);
+
+      if (ra.minLatE6 - marginLatE6 <= rb.maxLatE6 && rb.minLatE6 - marginLatE6 <= ra.maxLatE6
+          && ra.minLonE6 - marginLonE6 <= rb.maxLonE6 && rb.minLonE6 - marginLonE6 <= ra.maxLonE6) {
+        db.regions[a].adjacent |= 1UL << b;
+      }
+    }
+  }
+  return db;
+}
+
+}  // namespace CameraDbBuild
+
+// Usage (two steps, the sizes become template arguments):
+//   constexpr CameraDbSize SIZE = measureCameraDb(coordinates, regions);
+//   constexpr CameraDb<SIZE.blocks, SIZE.bytes, SIZE.regions> DB =
+//     buildCameraDb<SIZE.blocks, SIZE.bytes>(coordinates, regions, marginM);
+template<typename Coordinate, size_t N, typename Region, size_t R>
+constexpr CameraDbSize measureCameraDb(const Coordinate (&coordinates)[N], const Region (&regions)[R]) {
+  return CameraDbBuild::measure(coordinates, regions);
+}
+
+template<size_t BLOCKS, size_t BYTES, typename Coordinate, size_t N, typename Region, size_t R>
+constexpr CameraDb<BLOCKS, BYTES, R> buildCameraDb(const Coordinate (&coordinates)[N], const Region (&regions)[R], uint32_t adjacentMarginM) {
+  return CameraDbBuild::build<BLOCKS, BYTES, R>(coordinates, regions, adjacentMarginM);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "GpsFix.h"
+#include "RegionWorkingSet.h"
+#include "ZoneLayer.h"
+#include "AlertStateMachine.h"
+#include "FixLatency.h"
+
+// Detection engine shared by the v1 and v2 sketches: fixes in, proximity
+// results and alert state out. The sketches own the I/O around it (UART,
+// LED, display, buzzer, button) and choose the data: camera database,
+// radius table, road layer and zone layer (NoRoadLayer / NoZoneLayer if the
+// board has none).
+//
+// evaluate() is the proximity stage and step() the alert stage; in task mode
+// they run on different tasks and only exchange ProximityResult values. The
+// alert stage also tracks fix age and fix-to-alert latency (FixLatency.h),
+// and goes to ALERT_STALE_FIX when positions stop arriving.
+
+// Output of the GPS stage: the fix the later stages use (filtered when a
+// filter runs) and the fix as received
+struct FilteredFix {
+  GpsFix fix;
+  GpsFix measured;
+};
+
+// Result of one proximity evaluation, handed from the proximity stage to the alert stage
+struct ProximityResult {
+  GpsFix fix;
+  GpsFix measured;
+  bool inRange;
+  uint8_t cameraLimitKmh;  // limit of the camera in range, 0 = unknown
+  uint8_t roadLimitKmh;    // limit of the road segment under the fix, 0 = unknown
+  uint8_t zoneLimitKmh;    // limit of the alert zone under the fix, 0 = none
+  ZoneKind zone;           // alert zone under the fix, ZONE_NONE outside
+  uint16_t radiusM;        // warning radius used for the fix
+  uint16_t candidates;     // cameras that got the exact distance test
+};
+
+template<typename Db, size_t CAPACITY, typename RadiusTable, typename RoadLayer, typename Zones>
+class DetectorCore {
+private:
+  RegionWorkingSet<Db, CAPACITY> workingSet;
+  const RadiusTable &radius;
+  const RoadLayer &roads;
+  const Zones &zones;
+  uint32_t segmentMatchM;
+  bool autoSpeedLimit;
+  AlertStateMachine alert;
+  FixLatency latency;
+
+  static bool raisesAlert(AlertState state) {
+    return state == ALERT_PROXIMITY || state == ALERT_OVERSPEED;
+  }
+
+  // Cameras of the current and neighbouring counties within the speed
+  // dependent radius; fills inRange, cameraLimitKmh (of the nearest camera),
+  // radiusM and candidates
+  void findCameraInRange(const GpsFix &fix, ProximityResult &result) {
+    uint32_t range = radius.radiusFor(fix.speedKmhX10 / 10);
+    result.radiusM = (uint16_t)range;
+
+    workingSet.update(fix.latE6, fix.lonE6);
+    uint64_t nearest = UINT64_MAX;
+    result.candidates =
+      workingSet.forEachWithin(fix.latE6, fix.lonE6, range, [&](const CameraPosition &camera, uint64_t chordSq) {
+        if (chordSq < nearest) {
+          nearest = chordSq;
+          result.cameraLimitKmh = camera.limitKmh;
+          result.inRange = true;
+        }
+        return false;
+      });
+  }
+
+public:
+  // segmentMatchM: max distance from the fix to a road segment.
+  // autoLimit: with no manual limit, warn against the camera / road limit.
+  // staleFixMs: time without a new position before the fix counts as stale.
+  DetectorCore(const Db &db, const RadiusTable &radiusTable, const RoadLayer &roadLayer, const Zones &zoneLayer,
+               uint32_t segmentMatch, bool autoLimit, uint32_t staleFixMs)
+    : workingSet(db), radius(radiusTable), roads(roadLayer), zones(zoneLayer), segmentMatchM(segmentMatch),
+      autoSpeedLimit(autoLimit), latency(staleFixMs) {}
+
+  // Camera, zone and road limit lookups for one fix (proximity stage)
+  ProximityResult evaluate(const FilteredFix &input) {
+    const GpsFix &fix = input.fix;
+    ProximityResult result = { fix, input.measured, false, 0, 0, 0, ZONE_NONE, 0, 0 };
+
+    if (fix.valid) {
+      findCameraInRange(fix, result);
+      ZoneMatch zone = zones.zoneAt(fix.latE6, fix.lonE6);
+      result.zone = zone.kind;
+      result.zoneLimitKmh = zone.limitKmh;
+      result.roadLimitKmh = roads.limitAt(fix.latE6, fix.lonE6, segmentMatchM);
+    }
+    return result;
+  }
+
+  // Limit the warnings use: a manual limit (> 0) overrides the camera, zone and road limits
+  int speedLimit(const ProximityResult &result, int manualLimitKmh) const {
+    if (manualLimitKmh > 0 || !autoSpeedLimit) {
+      return manualLimitKmh;
+    }
+    if (result.inRange && result.cameraLimitKmh > 0) {
+      return result.cameraLimitKmh;
+    }
+    if (result.zoneLimitKmh > 0) {
+      return result.zoneLimitKmh;
+    }
+    return result.roadLimitKmh;
+  }
+
+  // Advance the alert state on the newest result (alert stage), nowUs from micros()
+  AlertCue step(const ProximityResult &result, bool modeDisplay, int manualLimitKmh, uint32_t nowUs) {
+    bool stale = latency.update(result.fix, nowUs);
+    AlertInputs inputs = { result.fix.valid, stale, result.inRange, modeDisplay, result.fix.speedKmhX10 / 10,
+                           speedLimit(result, manualLimitKmh), result.zone != ZONE_NONE };
+
+    AlertState before = alert.getBaseState();
+    AlertCue cue = alert.step(inputs);
+    if (alert.getBaseState() != before) {
+      if (raisesAlert(alert.getBaseState())) {
+        latency.alertRaised(result.fix);
+      } else {
+        latency.alertCancelled();
+      }
+    }
+    return cue;
+  }
+
+  // The sketch started the first tone of the raised alert at nowUs
+  void alertSounded(uint32_t nowUs) {
+    latency.alertSounded(nowUs);
+  }
+
+  AlertStateMachine &getAlert() {
+    return alert;
+  }
+
+  const FixLatency &getLatency() const {
+    return latency;
+  }
+
+  const RegionWorkingSet<Db, CAPACITY> &getWorkingSet() const {
+    return workingSet;
+  }
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "GpsFix.h"
+
+// Fix age and fix-to-alert latency, measured from GpsFix::rxMicros (when the
+// sentence that completed the position arrived from the UART).
+//
+// The alert stage calls update() every pass: the first pass that acts on a
+// new fix adds an age sample, and a fix with no successor for staleAfterMs
+// makes the stream stale (degraded mode) until the next fix arrives. When an
+// alert is raised, alertRaised() remembers the rxMicros of the fix behind it
+// and alertSounded() closes the sample at the first tone.
+
+// Last N samples, stats on demand
+template<size_t N>
+class RollingStats {
+private:
+  uint32_t samples[N];
+  size_t next = 0;
+  size_t count = 0;
+  uint32_t total = 0;  // samples added since clear(), including overwritten ones
+
+public:
+  void add(uint32_t value) {
+    samples[next] = value;
+    next = (next + 1) % N;
+    if (count < N) count++;
+    total++;
+  }
+
+  void clear() {
+    next = count = 0;
+    total = 0;
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  uint32_t getTotal() const {
+    return total;
+  }
+
+  // Newest sample (0 if none)
+  uint32_t last() const {
+    return count == 0 ? 0 : samples[(next + N - 1) % N];
+  }
+
+  uint32_t mean() const {
+    if (count == 0) return 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) sum += samples[i];
+    return (uint32_t)(sum / count);
+  }
+
+  uint32_t max() const {
+    uint32_t largest = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (samples[i] > largest) largest = samples[i];
+    }
+    return largest;
+  }
+
+  // Smallest sample that at least percent % of the window is at or below (nearest rank)
+  uint32_t percentile(uint8_t percent) const {
+    if (count == 0) return 0;
+    size_t rank = (count * percent + 99) / 100;
+    if (rank == 0) rank = 1;
+
+    // Selection by counting: the windows are small and this runs rarely
+    for (size_t i = 0; i < count; i++) {
+      size_t below = 0, equal = 0;
+      for (size_t j = 0; j < count; j++) {
+        if (samples[j] < samples[i]) below++;
+        else if (samples[j] == samples[i]) equal++;
+      }
+      if (below < rank && rank <= below + equal) return samples[i];
+    }
+    return max();
+  }
+};
+
+class FixLatency {
+private:
+  uint32_t staleAfterUs;
+
+  bool haveFix = false;
+  uint32_t lastRxMicros = 0;
+  bool stale = false;
+  uint32_t staleEvents = 0;
+
+  bool alertPending = false;
+  uint32_t alertRxMicros = 0;
+
+  RollingStats<32> fixAge;
+  RollingStats<16> alertLatency;
+
+public:
+  explicit FixLatency(uint32_t staleAfterMs)
+    : staleAfterUs(staleAfterMs * 1000) {}
+
+  // Alert stage, every pass with the fix it acts on. Returns true while the
+  // fix stream is stale. Only valid fixes count; a receiver reporting no fix
+  // is the no-fix state, not a degraded one.
+  bool update(const GpsFix &fix, uint32_t nowUs) {
+    if (!fix.valid) {
+      haveFix = false;
+      stale = false;
+      return false;
+    }
+
+    if (!haveFix || fix.rxMicros != lastRxMicros) {
+      haveFix = true;
+      lastRxMicros = fix.rxMicros;
+      stale = false;
+      fixAge.add(nowUs - fix.rxMicros);
+    } else if (!stale && nowUs - lastRxMicros > staleAfterUs) {
+      // Latched, so micros() wrapping around cannot make an old fix look fresh
+      stale = true;
+      staleEvents++;
+    }
+    return stale;
+  }
+
+  // The alert stage raised an alert (proximity / overspeed) on this fix
+  void alertRaised(const GpsFix &fix) {
+    alertPending = true;
+    alertRxMicros = fix.rxMicros;
+  }
+
+  // The alert was dropped before it sounded (e.g. the state moved on)
+  void alertCancelled() {
+    alertPending = false;
+  }
+
+  bool isAlertPending() const {
+    return alertPending;
+  }
+
+  // First tone of the pending alert went out at nowUs
+  void alertSounded(uint32_t nowUs) {
+    if (!alertPending) return;
+    alertLatency.add(nowUs - alertRxMicros);
+    alertPending = false;
+  }
+
+  bool isStale() const {
+    return stale;
+  }
+
+  // Times the fix stream went stale
+  uint32_t getStaleEvents() const {
+    return staleEvents;
+  }
+
+  // us from sentence arrival to the first alert-stage pass acting on it
+  const RollingStats<32> &getFixAge() const {
+    return fixAge;
+  }
+
+  // us from arrival of the fix behind an alert to its first tone
+  const RollingStats<16> &getAlertLatency() const {
+    return alertLatency;
+  }
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+
+// Integer trig for cores without an FPU (the ESP32-C3 is RV32IMC, every
+// double sin / cos / atan2 / sqrt is a software library call).
+//
+// Angles are binary angles: a full turn is 2^32, so int32 arithmetic wraps
+// exactly like the circle does (90 degrees = 2^30, one unit = 1.46e-9 rad).
+// Sines, cosines and other unit values are Q30 (1.0 = 2^30). sin / cos and
+// atan2 are 30 CORDIC steps of shifts and adds, within a few LSB of libm.
+
+constexpr int32_t Q30_ONE = 1L << 30;
+constexpr int32_t ANGLE_RIGHT = 1L << 30;    // 90 degrees
+constexpr uint32_t ANGLE_HALF = 1UL << 31;   // 180 degrees
+constexpr uint8_t CORDIC_STEPS = 30;
+
+// atan(2^-i) as binary angles
+constexpr int32_t CORDIC_ATAN[CORDIC_STEPS] = {
+  536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+  2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+  10430, 5215, 2608, 1304, 652, 326, 163, 81, 41, 20, 10, 5, 3, 1
+};
+
+constexpr int32_t CORDIC_GAIN_INV = 652032874;  // prod 1 / sqrt(1 + 2^-2i) in Q30
+
+struct SinCos {
+  int32_t sin, cos;  // Q30
+};
+
+inline int32_t mulQ30(int32_t a, int32_t b) {
+  return (int32_t)(((int64_t)a * b + (1L << 29)) >> 30);
+}
+
+// Microdegrees <-> binary angles (2^32 / 360e6 = 1601279868 / 2^27)
+inline int32_t degreesE6ToAngle(int32_t e6) {
+  return (int32_t)(((int64_t)e6 * 1601279868 + (1L << 26)) >> 27);
+}
+
+inline int32_t angleToDegreesE6(int32_t angle) {
+  return (int32_t)(((int64_t)angle * 360000000 + (1LL << 31)) >> 32);
+}
+
+inline SinCos sinCos(int32_t angle) {
+  // CORDIC converges for +-99 degrees: fold the back half-plane by 180
+  bool flip = angle > ANGLE_RIGHT || angle < -ANGLE_RIGHT;
+  int32_t z = flip ? (int32_t)((uint32_t)angle + ANGLE_HALF) : angle;
+  int32_t x = CORDIC_GAIN_INV, y = 0;
+
+  for (uint8_t i = 0; i < CORDIC_STEPS; i++) {
+    int32_t dx = y >> i, dy = x >> i;
+    if (z >= 0) {
+      x -= dx;
+      y += dy;
+      z -= CORDIC_ATAN[i];
+    } else {
+      x += dx;
+      y -= dy;
+      z += CORDIC_ATAN[i];
+    }
+  }
+  return flip ? SinCos{ -y, -x } : SinCos{ y, x };
+}
+
+// Angle of the vector (x, y), any scale; atan2(0, 0) is 0
+inline int32_t atan2Angle(int32_t y, int32_t x) {
+  if (x == 0 && y == 0) return 0;
+
+  // Work in int64 until the vector is scaled to 2^29..2^30. x only grows
+  // (by the CORDIC gain 1.65 and up to the diagonal 1.41) and stays >= 0,
+  // so it runs unsigned; y only shrinks.
+  int64_t x64 = x, y64 = y;
+  uint32_t z = 0;
+  if (x64 < 0) {
+    x64 = -x64;
+    y64 = -y64;
+    z = ANGLE_HALF;
+  }
+
+  uint64_t span = (uint64_t)x64 | (uint64_t)(y64 < 0 ? -y64 : y64);
+  int shift = 34 - __builtin_clzll(span);  // top bit to bit 29
+  if (shift > 0) {
+    x64 >>= shift;
+    y64 >>= shift;
+  } else {
+    x64 <<= -shift;
+    y64 <<= -shift;
+  }
+
+  uint32_t vx = (uint32_t)x64;
+  int32_t vy = (int32_t)y64;
+  for (uint8_t i = 0; i < CORDIC_STEPS; i++) {
+    int32_t dx = vy >> i, dy = (int32_t)(vx >> i);
+    if (vy > 0) {
+      vx += dx;
+      vy -= dy;
+      z += CORDIC_ATAN[i];
+    } else {
+      vx -= dx;
+      vy += dy;
+      z -= CORDIC_ATAN[i];
+    }
+  }
+  return (int32_t)z;
+}
+
+// Rounded-down square root, one result bit per step
+inline uint32_t isqrt64(uint64_t value) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > value) bit >>= 2;
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+// asin of a Q30 value as a binary angle
+inline int32_t asinAngle(int32_t s) {
+  int64_t rest = (1LL << 60) - (int64_t)s * s;
+  return atan2Angle(s, (int32_t)isqrt64(rest > 0 ? rest : 0));
+}
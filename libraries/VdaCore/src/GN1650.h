@@ -1,11 +1,26 @@
 #pragma once
 
+#include "OutputShadow.h"
+#include "BoardPolicy.h"
+
+// Board: DISPLAY_DATA / DISPLAY_CLK pins, bus timing (BIT_US, CONDITION_US,
+// TRANSFER_GAP_US) and the GPIO backend Io (see BoardPolicy.h)
+template<typename Board>
 class GN1650 {
 private:
-  uint8_t DAT_PIN;
-  uint8_t CLK_PIN;
+  typedef typename Board::Io Io;
+
+  static constexpr uint32_t DAT = pinMask(Board::DISPLAY_DATA);
+  static constexpr uint32_t CLK = pinMask(Board::DISPLAY_CLK);
+
   bool initialized = false;
 
+  // Last data written to DIG1-DIG3 and the last system command, so repeated
+  // frames do not go out on the bus again
+  OutputShadow<uint8_t> digitShadow[3];
+  OutputShadow<uint8_t> controlShadow;
+  OutputStats outputStats;
+
   // System command
   static const uint8_t CMD_SYSTEM = 0x48;
 
@@ -50,30 +65,28 @@ private:
   static const uint8_t SEG_DP = 0x80;  // bit 7
 
   void startCondition() {
-    digitalWrite(CLK_PIN, HIGH);
-    digitalWrite(DAT_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(DAT_PIN, LOW);
-    delayMicroseconds(10);
+    Io::write(CLK | DAT, HIGH);
+    Io::delayUs(Board::CONDITION_US);
+    Io::write(DAT, LOW);
+    Io::delayUs(Board::CONDITION_US);
   }
 
   void stopCondition() {
-    digitalWrite(CLK_PIN, LOW);
-    digitalWrite(DAT_PIN, LOW);
-    delayMicroseconds(10);
-    digitalWrite(CLK_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(DAT_PIN, HIGH);
-    delayMicroseconds(10);
+    Io::write(CLK | DAT, LOW);
+    Io::delayUs(Board::CONDITION_US);
+    Io::write(CLK, HIGH);
+    Io::delayUs(Board::CONDITION_US);
+    Io::write(DAT, HIGH);
+    Io::delayUs(Board::CONDITION_US);
   }
 
   void writeBit(bool bit) {
-    digitalWrite(CLK_PIN, LOW);
-    delayMicroseconds(5);
-    digitalWrite(DAT_PIN, bit ? HIGH : LOW);
-    delayMicroseconds(5);
-    digitalWrite(CLK_PIN, HIGH);
-    delayMicroseconds(5);
+    Io::write(CLK, LOW);
+    Io::delayUs(Board::BIT_US);
+    Io::write(DAT, bit);
+    Io::delayUs(Board::BIT_US);
+    Io::write(CLK, HIGH);
+    Io::delayUs(Board::BIT_US);
   }
 
   void writeByte(uint8_t data) {
@@ -82,31 +95,63 @@ private:
       writeBit((data >> i) & 0x01);
     }
 
-    // ACK bit (9th clock)
-    digitalWrite(CLK_PIN, LOW);
-    pinMode(DAT_PIN, INPUT);
-    delayMicroseconds(5);
-    digitalWrite(CLK_PIN, HIGH);
-    delayMicroseconds(5);
-    pinMode(DAT_PIN, OUTPUT);
-    digitalWrite(CLK_PIN, LOW);
-    delayMicroseconds(5);
+    // ACK bit (9th clock): let go of DAT while the chip pulls it low
+    Io::write(CLK, LOW);
+    Io::release(DAT);
+    Io::delayUs(Board::BIT_US);
+    Io::write(CLK, HIGH);
+    Io::delayUs(Board::BIT_US);
+    Io::drive(DAT);
+    Io::write(CLK, LOW);
+    Io::delayUs(Board::BIT_US);
   }
 
-  void sendCommand(uint8_t cmd1, uint8_t cmd2) {
+  // Returns false when the command was already in effect and nothing was sent
+  bool sendCommand(uint8_t cmd1, uint8_t cmd2) {
+    if (cmd1 == CMD_SYSTEM && !controlShadow.update(cmd2, outputStats)) return false;
+
     startCondition();
     writeByte(cmd1);
     writeByte(cmd2);
     stopCondition();
-    delayMicroseconds(100);
+    Io::delayUs(Board::TRANSFER_GAP_US);
+    return true;
   }
 
   void writeDisplayData(uint8_t addr, uint8_t data) {
+    if (!digitShadow[(addr - 0x68) >> 1].update(data, outputStats)) return;
+
     startCondition();
     writeByte(addr);
     writeByte(data);
     stopCondition();
-    delayMicroseconds(100);
+    Io::delayUs(Board::TRANSFER_GAP_US);
+  }
+
+  // Loading animation sequence: d1a, d1f, d1e, d1d, d2d, d3d, d3c, d3b, d3a, d2a
+  static const int LOADING_STEPS = 10;
+  // Indexed at run time, so an inline variable (C++17)
+  static_assert(__cplusplus >= 201703L, "GN1650 needs C++17");
+  static constexpr uint8_t LOADING_SEQUENCE[LOADING_STEPS][3] = {
+    { SEG_A, 0x00, 0x00 },  // d1a
+    { SEG_F, 0x00, 0x00 },  // d1f
+    { SEG_E, 0x00, 0x00 },  // d1e
+    { SEG_D, 0x00, 0x00 },  // d1d
+    { 0x00, SEG_D, 0x00 },  // d2d
+    { 0x00, 0x00, SEG_D },  // d3d
+    { 0x00, 0x00, SEG_C },  // d3c
+    { 0x00, 0x00, SEG_B },  // d3b
+    { 0x00, 0x00, SEG_A },  // d3a
+    { 0x00, SEG_A, 0x00 }   // d2a
+  };
+
+  int loadingStep = -1;
+  unsigned long loadingStepTime = 0;
+
+  void writeLoadingStep(int step) {
+    writeDisplayData(0x68, LOADING_SEQUENCE[step][0]);
+    writeDisplayData(0x6A, LOADING_SEQUENCE[step][1]);
+    writeDisplayData(0x6C, LOADING_SEQUENCE[step][2]);
   }
 
   void setDigit(uint8_t digitIndex, uint8_t value, bool decimalPoint = false) {
@@ -131,14 +176,18 @@ private:
 
 public:
   // Initialize the GN1650 driver (Common Cathode displays only)
-  void begin(uint8_t datPin, uint8_t clkPin, uint8_t brightness = 8) {
-    DAT_PIN = datPin;
-    CLK_PIN = clkPin;
+  void begin(uint8_t brightness = 8) {
+    static_assert(Board::HAS_DISPLAY, "board has no GN1650");
 
-    pinMode(DAT_PIN, OUTPUT);
-    pinMode(CLK_PIN, OUTPUT);
-    digitalWrite(DAT_PIN, HIGH);
-    digitalWrite(CLK_PIN, HIGH);
+    Io::output(Board::DISPLAY_DATA);
+    Io::output(Board::DISPLAY_CLK);
+    Io::write(DAT | CLK, HIGH);
+
+    // Chip state is unknown until the first full write
+    for (OutputShadow<uint8_t> &shadow : digitShadow) {
+      shadow.invalidate();
+    }
+    controlShadow.invalidate();
 
     delay(200);
 
@@ -204,28 +253,24 @@ public:
   void loading(uint16_t delayMs = 100) {
     if (!initialized) return;
 
-    // Loading animation sequence: d1a, d1f, d1e, d1d, d2d, d3d, d3c, d3b, d3a, d2a
-    const uint8_t sequence[][3] = {
-      { SEG_A, 0x00, 0x00 },  // d1a
-      { SEG_F, 0x00, 0x00 },  // d1f
-      { SEG_E, 0x00, 0x00 },  // d1e
-      { SEG_D, 0x00, 0x00 },  // d1d
-      { 0x00, SEG_D, 0x00 },  // d2d
-      { 0x00, 0x00, SEG_D },  // d3d
-      { 0x00, 0x00, SEG_C },  // d3c
-      { 0x00, 0x00, SEG_B },  // d3b
-      { 0x00, 0x00, SEG_A },  // d3a
-      { 0x00, SEG_A, 0x00 }   // d2a
-    };
-
-    for (int i = 0; i < 10; i++) {
-      writeDisplayData(0x68, sequence[i][0]);
-      writeDisplayData(0x6A, sequence[i][1]);
-      writeDisplayData(0x6C, sequence[i][2]);
+    for (int i = 0; i < LOADING_STEPS; i++) {
+      writeLoadingStep(i);
       delay(delayMs);
     }
   }
 
+  // Non-blocking loading animation: shows the next step once delayMs has passed
+  void updateLoading(uint16_t delayMs = 100) {
+    if (!initialized) return;
+
+    unsigned long now = millis();
+    if (loadingStep >= 0 && now - loadingStepTime < delayMs) return;
+
+    loadingStep = (loadingStep + 1) % LOADING_STEPS;
+    loadingStepTime = now;
+    writeLoadingStep(loadingStep);
+  }
+
   void showDashes() {
     if (!initialized) return;
     // Segment G = bit 6 = 0x40
@@ -239,7 +284,13 @@ public:
     if (level > 8) level = 8;
 
     uint8_t brightCmd = (level == 8) ? BRIGHT_8 : (level << 4);
-    sendCommand(CMD_SYSTEM, SEG_8 | WORK_MODE | brightCmd | DISP_ON);
-    delay(10);
+    if (sendCommand(CMD_SYSTEM, SEG_8 | WORK_MODE | brightCmd | DISP_ON)) {
+      delay(10);
+    }
+  }
+
+  // Bus transfers done and skipped since begin()
+  const OutputStats &getOutputStats() {
+    return outputStats;
   }
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include "FixedTrig.h"
+
+// Spherical earth geodesy on microdegree coordinates in integer math only
+// (see FixedTrig.h). Bearings are binary angles clockwise from north.
+
+constexpr uint32_t GEO_EARTH_CIRCUMFERENCE_M = 40030174;  // 2 pi * 6371 km
+constexpr uint32_t GEO_METERS_TO_ANGLE_Q16 = 7031570;    // 2^32 / circumference, Q16
+
+struct GeoPoint {
+  int32_t latE6, lonE6;
+};
+
+inline uint32_t geoAngleToMeters(uint32_t angle) {
+  return (uint32_t)(((uint64_t)angle * GEO_EARTH_CIRCUMFERENCE_M + (1ULL << 31)) >> 32);
+}
+
+inline uint32_t geoMetersToAngle(uint32_t meters) {
+  return (uint32_t)(((uint64_t)meters * GEO_METERS_TO_ANGLE_Q16 + (1UL << 15)) >> 16);
+}
+
+// Great circle distance in meters (haversine)
+inline uint32_t geoDistanceM(int32_t lat1E6, int32_t lon1E6, int32_t lat2E6, int32_t lon2E6) {
+  // Differences first, so short distances keep their precision
+  int32_t sinLat = sinCos(degreesE6ToAngle(lat2E6 - lat1E6) / 2).sin;
+  int32_t sinLon = sinCos(degreesE6ToAngle(lon2E6 - lon1E6) / 2).sin;
+  int32_t cosCos = mulQ30(sinCos(degreesE6ToAngle(lat1E6)).cos, sinCos(degreesE6ToAngle(lat2E6)).cos);
+
+  // Square of the half chord in Q60, the half chord in Q30
+  uint64_t a = (int64_t)sinLat * sinLat + (int64_t)mulQ30(cosCos, sinLon) * sinLon;
+  uint32_t halfChord = isqrt64(a);
+  if (halfChord > (uint32_t)Q30_ONE) halfChord = Q30_ONE;
+
+  uint32_t central = 2 * (uint32_t)asinAngle(halfChord);
+  return geoAngleToMeters(central);
+}
+
+// Initial bearing from point 1 towards point 2
+inline int32_t geoBearing(int32_t lat1E6, int32_t lon1E6, int32_t lat2E6, int32_t lon2E6) {
+  int32_t dLon = degreesE6ToAngle(lon2E6 - lon1E6);
+  SinCos from = sinCos(degreesE6ToAngle(lat1E6));
+  SinCos to = sinCos(degreesE6ToAngle(lat2E6));
+  SinCos across = sinCos(dLon);
+  int32_t sinHalfLon = sinCos(dLon / 2).sin;
+
+  // cos1 sin2 - sin1 cos2 cos(dLon), rewritten as sin(dLat) + 2 sin1 cos2
+  // sin^2(dLon / 2) so short legs do not cancel
+  int32_t sinCos2 = mulQ30(from.sin, to.cos);
+  int32_t north = sinCos(degreesE6ToAngle(lat2E6 - lat1E6)).sin
+                  + (int32_t)(((int64_t)mulQ30(sinCos2, sinHalfLon) * sinHalfLon) >> 29);
+  int32_t east = mulQ30(across.sin, to.cos);
+
+  return atan2Angle(east, north);
+}
+
+// Point reached after distanceM along bearing
+inline GeoPoint geoDestination(int32_t latE6, int32_t lonE6, int32_t bearing, uint32_t distanceM) {
+  SinCos start = sinCos(degreesE6ToAngle(latE6));
+  SinCos arc = sinCos((int32_t)geoMetersToAngle(distanceM));
+  SinCos heading = sinCos(bearing);
+
+  // Destination as a unit vector, x towards the start meridian at the equator
+  int32_t along = mulQ30(arc.sin, heading.cos);
+  int32_t z = mulQ30(start.sin, arc.cos) + mulQ30(start.cos, along);
+  int32_t x = mulQ30(start.cos, arc.cos) - mulQ30(start.sin, along);
+  int32_t y = mulQ30(arc.sin, heading.sin);
+  int32_t flat = isqrt64((int64_t)x * x + (int64_t)y * y);
+
+  // Latitude as the start plus the northward turn, less the small part the
+  // eastward turn takes off: the start's own sin/cos error cancels (asin of
+  // z would pass it on, 0.1 m at 47 degrees, and diverge near the poles)
+  int32_t lat = degreesE6ToAngle(latE6) + atan2Angle(along, arc.cos) - (atan2Angle(z, x) - atan2Angle(z, flat));
+  int32_t lon = degreesE6ToAngle(lonE6) + atan2Angle(y, x);  // wraps at 180
+
+  return { angleToDegreesE6(lat), angleToDegreesE6(lon) };
+}
+
+// ---------------------------------------------- Earth-centred unit vectors ----------------------------------------------
+
+// Unit vector from the earth centre, Q30. For nearby points use the squared
+// chord |a - b|^2 rather than the dot product: at 150 m, 1 - cos is 3e-10,
+// below one Q30 step, while the chord components are ~25000 steps each.
+struct GeoVector {
+  int32_t x, y, z;
+};
+
+inline GeoVector geoVector(int32_t latE6, int32_t lonE6) {
+  SinCos lat = sinCos(degreesE6ToAngle(latE6));
+  SinCos lon = sinCos(degreesE6ToAngle(lonE6));
+  return { mulQ30(lat.cos, lon.cos), mulQ30(lat.cos, lon.sin), lat.sin };
+}
+
+// Squared chord between two vectors in Q60 (int32 differences only
+// overflow for nearly antipodal points)
+inline uint64_t geoChordSq(const GeoVector &a, const GeoVector &b) {
+  int32_t dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+  return (int64_t)dx * dx + (int64_t)dy * dy + (int64_t)dz * dz;
+}
+
+constexpr uint32_t GEO_HALF_ARC_Q30_PER_M_Q24 = 1413781079;  // 2^30 / (2 * 6371 km), Q24
+
+// Squared chord of a great circle distance, to compare with geoChordSq.
+// Up to 200 km the half chord is the series t - t^3 / 6 of the exact half
+// arc: CORDIC's absolute sine error (up to 1.7e-8) would be 0.1 m at 150 m.
+inline uint64_t geoChordSqForMeters(uint32_t meters) {
+  uint64_t halfChord;
+  if (meters <= 200000) {
+    uint64_t halfArc = ((uint64_t)meters * GEO_HALF_ARC_Q30_PER_M_Q24 + (1UL << 23)) >> 24;
+    halfChord = halfArc - ((((halfArc * halfArc) >> 30) * halfArc >> 30) + 3) / 6;
+  } else {
+    halfChord = sinCos((int32_t)(geoMetersToAngle(meters) / 2)).sin;
+  }
+  return 4 * halfChord * halfChord;
+}
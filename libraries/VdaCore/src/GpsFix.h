@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include "NmeaParser.h"
+
+constexpr uint16_t GPS_COURSE_UNKNOWN = 0xFFFF;
+
+// Compact fix snapshot handed between tasks / pipeline stages
+struct GpsFix {
+  int32_t latE6;         // latitude in microdegrees
+  int32_t lonE6;         // longitude in microdegrees
+  uint16_t speedKmhX10;  // speed in 0.1 km/h
+  bool valid;
+  uint32_t timestampMs;  // millis() when the snapshot was taken
+  uint16_t courseCdeg;   // course over ground in 0.01 degree, GPS_COURSE_UNKNOWN if not reported
+  uint32_t rxMicros;     // micros() when the sentence that completed the position arrived
+};
+
+// Snapshot of the decoder's current position / speed, taken at nowMs; the
+// position arrived at rxMicros
+inline GpsFix fixFromNmea(const NmeaData &data, uint32_t nowMs, uint32_t rxMicros) {
+  GpsFix fix;
+  fix.valid = data.locationValid;
+  fix.latE6 = data.latE6;
+  fix.lonE6 = data.lonE6;
+  fix.speedKmhX10 = (uint16_t)((data.speedCentiKnots * 1852 + 5000) / 10000);  // 1 kn = 1.852 km/h
+  fix.timestampMs = nowMs;
+  fix.courseCdeg = data.courseValid ? data.courseCentiDeg : GPS_COURSE_UNKNOWN;
+  fix.rxMicros = rxMicros;
+  return fix;
+}
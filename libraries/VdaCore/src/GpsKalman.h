@@ -0,0 +1,233 @@
+#pragma once
+
+#include <stdint.h>
+#include "FixedTrig.h"
+
+// Constant-velocity Kalman filter for GPS fixes, integer only.
+//
+// North and east are filtered independently in a local flat frame around
+// an origin near the vehicle (moved when the vehicle gets 5 km away). Each
+// axis keeps position (cm), velocity (cm/s) and a 2x2 covariance. Every fix
+// is one predict plus two scalar updates per axis: the position, and the
+// velocity from speed and course. Positions whose normalized innovation
+// exceeds the gate are rejected (counted in the stats); a long gap or a
+// jump resets the filter to the measurement.
+
+struct GpsKalmanTuning {
+  uint32_t accelNoiseCmS2;     // process noise: 1 sigma acceleration, cm/s^2
+  uint32_t positionNoiseCm;    // 1 sigma GPS position error per axis, cm
+  uint32_t velocityNoiseCmS;   // 1 sigma GPS velocity error per axis, cm/s
+  uint16_t minCourseSpeedCmS;  // below this the course is ignored
+  uint16_t gateNisX100;        // reject positions with y^2 / S above this (x100)
+  uint32_t resetGapMs;         // restart after this long without a fix
+};
+
+constexpr GpsKalmanTuning DEFAULT_KALMAN_TUNING = { 100, 250, 30, 100, 2500, 5000 };
+
+// Running innovation statistics, cleared with clearStats(). The sums cover
+// the (updates - resets) predicted fixes; per axis, y^2 / S averages 1 when
+// the tuning matches the receiver.
+struct GpsKalmanStats {
+  uint32_t updates;             // fixes filtered
+  uint32_t rejected;            // positions outside the gate
+  uint32_t resets;              // restarts from a measurement
+  uint64_t nisSumX100;          // sum of position y^2 / S of both axes, x100
+  uint64_t innovationSumSqCm2;  // sum of squared position innovations, cm^2
+};
+
+class GpsKalman {
+private:
+  static const uint32_t CM_PER_E6_Q16 = 728727;   // 1 microdegree of latitude = 11.119 cm
+  static const uint32_t E6_PER_CM_Q24 = 1508812;
+  static const int32_t RECENTER_CM = 500000;      // move the origin after 5 km
+
+  struct Axis {
+    int32_t position;  // cm from the origin
+    int32_t velocity;  // cm/s
+    int64_t p00, p01, p11;  // cm^2, cm^2/s, cm^2/s^2
+
+    void predict(int64_t dtQ16, int64_t q) {
+      int64_t dt2 = (dtQ16 * dtQ16) >> 16;
+      int64_t dt3 = (dt2 * dtQ16) >> 16;
+      int64_t a = (p11 * dtQ16) >> 16;
+
+      position += (int32_t)(((int64_t)velocity * dtQ16 + (1 << 15)) >> 16);
+      p00 += ((2 * p01 + a) * dtQ16 >> 16) + ((q * ((dt2 * dt2) >> 16)) >> 18);
+      p01 += a + ((q * dt3) >> 17);
+      p11 += (q * dt2) >> 16;
+    }
+
+    // Scalar update of position (observePosition) or velocity; returns y^2 / S x100
+    uint32_t update(bool observePosition, int32_t z, int64_t r, bool gate, uint32_t gateNisX100, bool &rejected) {
+      int64_t s = (observePosition ? p00 : p11) + r;
+      uint64_t inverse = (1ULL << 46) / (uint64_t)s;
+      int64_t y = (int64_t)z - (observePosition ? position : velocity);
+      if (y > (1 << 24)) y = 1 << 24;
+      if (y < -(1 << 24)) y = -(1 << 24);
+
+      // y / S in Q16, then y^2 / S x100
+      int64_t yOverS = (y * (int64_t)inverse) >> 30;
+      uint32_t nisX100 = (uint32_t)((y * yOverS * 100) >> 16);
+      rejected = gate && nisX100 > gateNisX100;
+      if (rejected) return nisX100;
+
+      // Gains in Q16: K = [p00 p01] / S (position) or [p01 p11] / S (velocity)
+      int64_t k0 = ((observePosition ? p00 : p01) * (int64_t)inverse) >> 30;
+      int64_t k1 = ((observePosition ? p01 : p11) * (int64_t)inverse) >> 30;
+      position += (int32_t)((k0 * y) >> 16);
+      velocity += (int32_t)((k1 * y) >> 16);
+
+      // P -= K H P
+      int64_t h0 = observePosition ? p00 : p01;
+      int64_t h1 = observePosition ? p01 : p11;
+      p00 -= (k0 * h0) >> 16;
+      p01 -= (k0 * h1) >> 16;
+      p11 -= (k1 * h1) >> 16;
+      return nisX100;
+    }
+
+    void reset(int32_t z, int32_t v, int64_t r, int64_t rv) {
+      position = z;
+      velocity = v;
+      p00 = r;
+      p01 = 0;
+      p11 = rv;
+    }
+  };
+
+  GpsKalmanTuning tuning;
+  Axis north = {}, east = {};
+  int32_t originLatE6 = 0, originLonE6 = 0;
+  int32_t cosOrigin = Q30_ONE;   // Q30
+  uint64_t lonE6PerCmQ24 = E6_PER_CM_Q24;
+  uint32_t lastTimeMs = 0;
+  bool running = false;
+  uint8_t rejectedStreak = 0;
+  GpsKalmanStats stats = {};
+
+  void setOrigin(int32_t latE6, int32_t lonE6) {
+    originLatE6 = latE6;
+    originLonE6 = lonE6;
+    cosOrigin = sinCos(degreesE6ToAngle(latE6)).cos;
+    if (cosOrigin < Q30_ONE / 100) cosOrigin = Q30_ONE / 100;
+    lonE6PerCmQ24 = ((uint64_t)E6_PER_CM_Q24 << 30) / (uint32_t)cosOrigin;
+  }
+
+  int32_t northCm(int32_t latE6) const {
+    return (int32_t)(((int64_t)(latE6 - originLatE6) * CM_PER_E6_Q16) >> 16);
+  }
+
+  int32_t eastCm(int32_t lonE6) const {
+    return (int32_t)(((int64_t)mulQ30(lonE6 - originLonE6, cosOrigin) * CM_PER_E6_Q16) >> 16);
+  }
+
+  void recenter() {
+    int32_t latE6 = getLatE6(), lonE6 = getLonE6();
+    int32_t dNorth = north.position, dEast = east.position;
+    setOrigin(latE6, lonE6);
+    north.position -= dNorth;
+    east.position -= dEast;
+  }
+
+  void restart(int32_t latE6, int32_t lonE6, int32_t vNorth, int32_t vEast) {
+    int64_t r = (int64_t)tuning.positionNoiseCm * tuning.positionNoiseCm;
+    int64_t rv = (int64_t)tuning.velocityNoiseCmS * tuning.velocityNoiseCmS;
+    setOrigin(latE6, lonE6);
+    north.reset(0, vNorth, r, rv);
+    east.reset(0, vEast, r, rv);
+    running = true;
+    stats.resets++;
+  }
+
+public:
+  explicit GpsKalman(const GpsKalmanTuning &filterTuning = DEFAULT_KALMAN_TUNING)
+    : tuning(filterTuning) {}
+
+  // Filter one valid fix. speedKmhX10 / courseCdeg as reported (course in
+  // 0.01 degree, negative when unknown), timeMs when the fix arrived.
+  void update(int32_t latE6, int32_t lonE6, uint16_t speedKmhX10, int32_t courseCdeg, uint32_t timeMs) {
+    // Velocity measurement from speed and course; without a usable course
+    // measure zero with the reported speed as extra uncertainty
+    int32_t speedCmS = (int32_t)speedKmhX10 * 100 / 36;
+    int32_t vNorth = 0, vEast = 0;
+    int64_t rv = (int64_t)tuning.velocityNoiseCmS * tuning.velocityNoiseCmS;
+    if (courseCdeg >= 0 && speedCmS >= tuning.minCourseSpeedCmS) {
+      SinCos heading = sinCos(degreesE6ToAngle(courseCdeg * 10000));
+      vNorth = mulQ30(speedCmS, heading.cos);
+      vEast = mulQ30(speedCmS, heading.sin);
+    } else {
+      rv += (int64_t)speedCmS * speedCmS;
+    }
+
+    uint32_t gapMs = timeMs - lastTimeMs;
+    lastTimeMs = timeMs;
+    stats.updates++;
+    if (!running || gapMs > tuning.resetGapMs) {
+      restart(latE6, lonE6, vNorth, vEast);
+      return;
+    }
+
+    int64_t dtQ16 = ((int64_t)gapMs << 16) / 1000;
+    int64_t q = (int64_t)tuning.accelNoiseCmS2 * tuning.accelNoiseCmS2;
+    north.predict(dtQ16, q);
+    east.predict(dtQ16, q);
+
+    int64_t r = (int64_t)tuning.positionNoiseCm * tuning.positionNoiseCm;
+    bool rejectedNorth, rejectedEast, unused;
+    int32_t zNorth = northCm(latE6), zEast = eastCm(lonE6);
+    int64_t yNorth = zNorth - north.position, yEast = zEast - east.position;
+    stats.innovationSumSqCm2 += (uint64_t)(yNorth * yNorth + yEast * yEast);
+    stats.nisSumX100 += north.update(true, zNorth, r, true, tuning.gateNisX100, rejectedNorth);
+    stats.nisSumX100 += east.update(true, zEast, r, true, tuning.gateNisX100, rejectedEast);
+
+    if (rejectedNorth || rejectedEast) {
+      stats.rejected++;
+      // Several rejections in a row mean the filter lost track: take the measurement
+      if (++rejectedStreak >= 3) {
+        rejectedStreak = 0;
+        restart(latE6, lonE6, vNorth, vEast);
+        return;
+      }
+    } else {
+      rejectedStreak = 0;
+    }
+
+    north.update(false, vNorth, rv, false, 0, unused);
+    east.update(false, vEast, rv, false, 0, unused);
+
+    if (north.position > RECENTER_CM || north.position < -RECENTER_CM || east.position > RECENTER_CM
+        || east.position < -RECENTER_CM) {
+      recenter();
+    }
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+
+  // Forget the track (fix lost)
+  void stop() {
+    running = false;
+  }
+
+  int32_t getLatE6() const {
+    return originLatE6 + (int32_t)(((int64_t)north.position * E6_PER_CM_Q24) >> 24);
+  }
+
+  int32_t getLonE6() const {
+    return originLonE6 + (int32_t)(((int64_t)east.position * (int64_t)lonE6PerCmQ24) >> 24);
+  }
+
+  uint16_t getSpeedKmhX10() const {
+    uint64_t squared = (int64_t)north.velocity * north.velocity + (int64_t)east.velocity * east.velocity;
+    return (uint16_t)((isqrt64(squared) * 36 + 50) / 100);
+  }
+
+  const GpsKalmanStats &getStats() const {
+    return stats;
+  }
+
+  void clearStats() {
+    stats = {};
+  }
+};
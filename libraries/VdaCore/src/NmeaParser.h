@@ -0,0 +1,333 @@
+#pragma once
+
+#include <stdint.h>
+
+// Streaming NMEA 0183 decoder for the two sentences the detector uses: RMC
+// (status, position, speed, course, date, time) and GGA (fix quality, position,
+// altitude, time). Fields are accumulated straight into integers as the bytes arrive
+// (microdegrees, centi-knots, hhmmsscc) while the XOR checksum runs along;
+// nothing is buffered and nothing is allocated. Values are committed only
+// when the checksum matches. Other sentences are skipped to the next '$'.
+
+// encode() result bits
+constexpr uint8_t NMEA_TIME_UPDATED = 0x01;
+constexpr uint8_t NMEA_LOCATION_UPDATED = 0x02;  // position / validity changed (RMC or GGA)
+constexpr uint8_t NMEA_DATE_UPDATED = 0x04;
+
+struct NmeaData {
+  int32_t latE6;             // microdegrees, north positive
+  int32_t lonE6;             // microdegrees, east positive
+  uint32_t speedCentiKnots;  // from RMC
+  uint16_t courseCentiDeg;   // from RMC, true course over ground in 0.01 degree
+  uint32_t time;             // UTC hhmmsscc
+  uint32_t date;             // UTC ddmmyy
+  int32_t altitudeDm;        // from GGA, height above the WGS84 ellipsoid in 0.1 m
+  bool locationValid;        // last RMC status A / GGA quality > 0
+  bool courseValid;          // last RMC had a course (empty when stationary)
+  bool timeValid;
+  bool dateValid;
+
+  uint8_t hour() const { return time / 1000000; }
+  uint8_t minute() const { return time / 10000 % 100; }
+  uint8_t second() const { return time / 100 % 100; }
+  uint8_t centisecond() const { return time % 100; }
+  uint8_t day() const { return date / 10000; }
+  uint8_t month() const { return date / 100 % 100; }
+  uint16_t year() const { return 2000 + date % 100; }
+};
+
+struct NmeaStats {
+  uint32_t sentences;       // RMC / GGA with a good checksum
+  uint32_t checksumErrors;  // RMC / GGA dropped on a bad or missing checksum
+  uint32_t skipped;         // other sentences
+};
+
+class NmeaParser {
+private:
+  enum State : uint8_t { WAIT_START, ADDRESS, FIELD, CHECKSUM_HIGH, CHECKSUM_LOW };
+  enum Sentence : uint8_t { SENTENCE_RMC, SENTENCE_GGA };
+
+  static const uint8_t ADDRESS_LENGTH = 5;  // talker (GP, GN, ...) + type
+  static const uint8_t FRACTION_DIGITS = 6;
+
+  // Values of the sentence being decoded, committed on a good checksum
+  struct Pending {
+    int32_t latE6, lonE6;
+    int32_t altitudeDm, separationDm;
+    uint32_t speedCentiKnots;
+    uint16_t courseCentiDeg;
+    uint32_t time;
+    uint32_t date;
+    bool hasLat, hasLon, hasTime, hasDate, hasAltitude, hasCourse;
+    bool fix;  // status A / quality > 0
+  };
+
+  State state = WAIT_START;
+  Sentence sentence = SENTENCE_RMC;
+  uint8_t checksum = 0;
+  uint8_t receivedChecksum = 0;
+  uint8_t fieldIndex = 0;
+  uint8_t addressLength = 0;
+  char address[ADDRESS_LENGTH];
+
+  // Current field: integer part, up to FRACTION_DIGITS fraction digits, first character
+  uint32_t whole = 0;
+  uint32_t fraction = 0;
+  uint8_t fractionDigits = 0;
+  bool inFraction = false;
+  bool fieldEmpty = true;
+  char fieldFirst = 0;
+
+  Pending pending;
+  NmeaData data = {};
+  NmeaStats stats = {};
+
+  // Indexed at run time: an inline variable (C++17), no definition elsewhere
+  static_assert(__cplusplus >= 201703L, "NmeaParser needs C++17");
+  static constexpr uint32_t POW10[FRACTION_DIGITS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+  static int8_t hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  // Fraction of the current field with exactly digits digits (truncated)
+  uint32_t fractionTo(uint8_t digits) const {
+    return digits >= fractionDigits ? fraction * POW10[digits - fractionDigits] : fraction / POW10[fractionDigits - digits];
+  }
+
+  // dddmm.mmmmmm -> microdegrees
+  int32_t coordinateE6() const {
+    uint32_t minutesE6 = (whole % 100) * 1000000 + fractionTo(6);
+    return (int32_t)((whole / 100) * 1000000 + (minutesE6 + 30) / 60);
+  }
+
+  // Signed field in tenths (altitude)
+  int32_t decimeters() const {
+    int32_t value = (int32_t)(whole * 10 + fractionTo(1));
+    return fieldFirst == '-' ? -value : value;
+  }
+
+  void startField() {
+    whole = fraction = 0;
+    fractionDigits = 0;
+    inFraction = false;
+    fieldEmpty = true;
+    fieldFirst = 0;
+  }
+
+  void startSentence() {
+    state = ADDRESS;
+    checksum = 0;
+    addressLength = 0;
+    fieldIndex = 0;
+    pending = {};
+    startField();
+  }
+
+  // Pick the decoder from the address, false for sentences we skip
+  bool selectSentence() {
+    if (addressLength != ADDRESS_LENGTH) return false;
+    const char *type = address + 2;
+    if (type[0] == 'R' && type[1] == 'M' && type[2] == 'C') {
+      sentence = SENTENCE_RMC;
+    } else if (type[0] == 'G' && type[1] == 'G' && type[2] == 'A') {
+      sentence = SENTENCE_GGA;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  void accumulate(char c) {
+    if (fieldEmpty) fieldFirst = c;
+    fieldEmpty = false;
+
+    if (c >= '0' && c <= '9') {
+      if (!inFraction) {
+        whole = whole * 10 + (c - '0');
+      } else if (fractionDigits < FRACTION_DIGITS) {
+        fraction = fraction * 10 + (c - '0');
+        fractionDigits++;
+      }
+    } else if (c == '.') {
+      inFraction = true;
+    }
+  }
+
+  // Field fieldIndex is complete (1-based, the address is field 0)
+  void endField() {
+    if (fieldEmpty) return;
+
+    // Map GGA onto the RMC layout: time, status, lat, N/S, lon, E/W, speed, course, date
+    uint8_t field = fieldIndex;
+    if (sentence == SENTENCE_GGA) {
+      if (field == 6) {
+        pending.fix = whole > 0;  // quality
+        return;
+      }
+      if (field == 9) {
+        pending.altitudeDm = decimeters();  // above mean sea level
+        pending.hasAltitude = true;
+        return;
+      }
+      if (field == 11) {
+        pending.separationDm = decimeters();  // geoid above the ellipsoid
+        return;
+      }
+      if (field >= 2 && field <= 5) field++;
+      else if (field != 1) return;
+    }
+
+    switch (field) {
+      case 1:
+        pending.time = whole * 100 + fractionTo(2);
+        pending.hasTime = true;
+        break;
+      case 2: pending.fix = fieldFirst == 'A'; break;
+      case 3:
+        pending.latE6 = coordinateE6();
+        pending.hasLat = true;
+        break;
+      case 4:
+        if (fieldFirst == 'S') pending.latE6 = -pending.latE6;
+        break;
+      case 5:
+        pending.lonE6 = coordinateE6();
+        pending.hasLon = true;
+        break;
+      case 6:
+        if (fieldFirst == 'W') pending.lonE6 = -pending.lonE6;
+        break;
+      case 7: pending.speedCentiKnots = whole * 100 + (fractionTo(3) + 5) / 10; break;
+      case 8:
+        pending.courseCentiDeg = (whole * 100 + fractionTo(2)) % 36000;
+        pending.hasCourse = true;
+        break;
+      case 9:
+        pending.date = whole;
+        pending.hasDate = true;
+        break;
+      default: break;
+    }
+  }
+
+  uint8_t commit() {
+    uint8_t updated = 0;
+    stats.sentences++;
+
+    if (pending.hasTime) {
+      data.time = pending.time;
+      data.timeValid = true;
+      updated |= NMEA_TIME_UPDATED;
+    }
+    if (pending.hasDate) {
+      data.date = pending.date;
+      data.dateValid = true;
+      updated |= NMEA_DATE_UPDATED;
+    }
+
+    if (pending.fix && pending.hasLat && pending.hasLon) {
+      data.latE6 = pending.latE6;
+      data.lonE6 = pending.lonE6;
+      if (sentence == SENTENCE_RMC) {
+        data.speedCentiKnots = pending.speedCentiKnots;
+        data.courseCentiDeg = pending.courseCentiDeg;
+        data.courseValid = pending.hasCourse;
+      }
+      if (pending.hasAltitude) data.altitudeDm = pending.altitudeDm + pending.separationDm;
+      data.locationValid = true;
+      updated |= NMEA_LOCATION_UPDATED;
+    } else if (!pending.fix && data.locationValid) {
+      data.locationValid = false;
+      updated |= NMEA_LOCATION_UPDATED;
+    }
+    return updated;
+  }
+
+public:
+  // Feed one byte. Returns NMEA_*_UPDATED bits when it completed a good RMC / GGA, else 0.
+  uint8_t encode(char c) {
+    if (c == '$') {
+      if (state == FIELD || state == CHECKSUM_HIGH || state == CHECKSUM_LOW) {
+        stats.checksumErrors++;  // RMC / GGA cut short
+      }
+      startSentence();
+      return 0;
+    }
+
+    switch (state) {
+      case WAIT_START: return 0;
+
+      case ADDRESS:
+        if (c == ',') {
+          checksum ^= c;
+          if (!selectSentence()) {
+            stats.skipped++;
+            state = WAIT_START;
+            return 0;
+          }
+          state = FIELD;
+          fieldIndex = 1;
+        } else if (addressLength < ADDRESS_LENGTH && c >= 'A' && c <= 'Z') {
+          checksum ^= c;
+          address[addressLength++] = c;
+        } else {
+          stats.skipped++;
+          state = WAIT_START;
+        }
+        return 0;
+
+      case FIELD:
+        if (c == ',' || c == '*') {
+          endField();
+          startField();
+          fieldIndex++;
+          if (c == '*') {
+            state = CHECKSUM_HIGH;
+          } else {
+            checksum ^= c;
+          }
+        } else if (c == '\r' || c == '\n') {
+          stats.checksumErrors++;  // no checksum
+          state = WAIT_START;
+        } else {
+          checksum ^= c;
+          accumulate(c);
+        }
+        return 0;
+
+      case CHECKSUM_HIGH:
+      case CHECKSUM_LOW: {
+        int8_t nibble = hexValue(c);
+        if (nibble < 0) {
+          stats.checksumErrors++;
+          state = WAIT_START;
+          return 0;
+        }
+        if (state == CHECKSUM_HIGH) {
+          receivedChecksum = nibble << 4;
+          state = CHECKSUM_LOW;
+          return 0;
+        }
+        state = WAIT_START;
+        if ((receivedChecksum | nibble) != checksum) {
+          stats.checksumErrors++;
+          return 0;
+        }
+        return commit();
+      }
+    }
+    return 0;
+  }
+
+  const NmeaData &getData() const {
+    return data;
+  }
+
+  const NmeaStats &getStats() const {
+    return stats;
+  }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+// Write counters for one output device (LED pins, display bus, buzzer)
+struct OutputStats {
+  uint32_t written = 0;  // writes that reached the hardware
+  uint32_t elided = 0;   // writes skipped because the value was already there
+};
+
+// Last value written to one pin or register. update() returns true when the
+// new value has to go out. An unknown value (after begin, or after the
+// hardware changed it on its own) always goes out.
+template<typename T>
+class OutputShadow {
+private:
+  T value = T();
+  bool known = false;
+
+public:
+  bool update(T next, OutputStats &stats) {
+    if (known && value == next) {
+      stats.elided++;
+      return false;
+    }
+
+    value = next;
+    known = true;
+    stats.written++;
+    return true;
+  }
+
+  void invalidate() {
+    known = false;
+  }
+
+  bool isKnown() const {
+    return known;
+  }
+
+  T get() const {
+    return value;
+  }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+#include <pgmspace.h>
+#endif
+
+// Constant tables (camera database) go to flash with CORE_PROGMEM and are
+// read through progmemRead(). The ESP8266 keeps const data in RAM unless it
+// is marked PROGMEM, and its flash only takes aligned 32-bit loads, so values
+// are copied out with memcpy_P (pgm_read_float() on a double reads half of
+// it). On the ESP32 and on the host const data is directly addressable.
+#if defined(ARDUINO_ARCH_ESP8266)
+#define CORE_PROGMEM PROGMEM
+#else
+#define CORE_PROGMEM
+#endif
+
+template<typename T>
+inline T progmemRead(const T *p) {
+#if defined(ARDUINO_ARCH_ESP8266)
+  T value;
+  memcpy_P(&value, p, sizeof(T));
+  return value;
+#else
+  return *p;
+#endif
+}
+
+inline uint8_t progmemByte(const uint8_t *p) {
+#if defined(ARDUINO_ARCH_ESP8266)
+  return pgm_read_byte(p);
+#else
+  return *p;
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Warning radius as a function of speed: the distance covered while the
+// driver reacts, plus the distance needed to slow down at a comfortable
+// deceleration, plus a fixed margin for GPS error, clamped to [min, max].
+struct ProximityModel {
+  float reactionTimeS;  // seconds from the first beep to the driver acting
+  float decelMps2;      // comfortable deceleration in m/s^2
+  uint16_t marginM;     // added on top, covers GPS and camera position error
+  uint16_t minRadiusM;
+  uint16_t maxRadiusM;
+};
+
+constexpr uint16_t proximityRadius(const ProximityModel &model, int speedKmh) {
+  float v = speedKmh / 3.6f;  // m/s
+  float radius = v * model.reactionTimeS + v * v / (2.0f * model.decelMps2) + model.marginM;
+
+  if (radius < model.minRadiusM) return model.minRadiusM;
+  if (radius > model.maxRadiusM) return model.maxRadiusM;
+  return (uint16_t)(radius + 0.5f);
+}
+
+// Radius per integer km/h, filled at compile time. Speeds above MAX_KMH use the last entry.
+template<int MAX_KMH>
+struct ProximityTable {
+  uint16_t radiusM[MAX_KMH + 1];
+
+  constexpr uint16_t radiusFor(int speedKmh) const {
+    if (speedKmh < 0) speedKmh = 0;
+    if (speedKmh > MAX_KMH) speedKmh = MAX_KMH;
+    return radiusM[speedKmh];
+  }
+
+  constexpr uint16_t maxRadius() const {
+    uint16_t largest = 0;
+    for (int i = 0; i <= MAX_KMH; i++) {
+      if (radiusM[i] > largest) largest = radiusM[i];
+    }
+    return largest;
+  }
+};
+
+template<int MAX_KMH>
+constexpr ProximityTable<MAX_KMH> buildProximityTable(const ProximityModel &model) {
+  ProximityTable<MAX_KMH> table = {};
+  for (int i = 0; i <= MAX_KMH; i++) {
+    table.radiusM[i] = proximityRadius(model, i);
+  }
+  return table;
+}
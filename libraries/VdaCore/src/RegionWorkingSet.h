@@ -0,0 +1,199 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CameraDb.h"
+#include "Geodesy.h"
+#include "SpatialGrid.h"
+
+// Keeps the cameras of the current region and its neighbours decoded in one
+// compact RAM array. When the vehicle moves into another region, regions that
+// are no longer next to it are dropped and the missing ones are paged in, all
+// in the same update(), so no camera near the boundary is missed on the fix
+// after the crossing. Size CAPACITY with Db::workingSetSize().
+//
+// With an adjacency margin of at least twice the largest query radius, every
+// camera within that radius of the vehicle is in a neighbour of the current
+// region. Loaded cameras are indexed in a GridIndex, so a query only looks
+// at the cells around the point, and each also gets its earth-centred unit
+// vector, so the exact radius test in forEachWithin is a squared chord
+// compare without trig.
+// Not thread safe: update and query from the same task.
+template<typename Db, size_t CAPACITY>
+class RegionWorkingSet {
+private:
+  struct LoadedRegion {
+    uint8_t region;
+    uint16_t offset;  // first camera in cameras[]
+    uint16_t count;
+  };
+
+  const Db &db;
+  CameraPosition cameras[CAPACITY];
+  GeoVector vectors[CAPACITY];  // vectors[i] belongs to cameras[i]
+  GridIndex<CAPACITY> cameraGrid = {};  // items are indices into cameras[]
+  LoadedRegion loaded[Db::regionCount()];
+  uint8_t loadedCount = 0;
+  uint16_t cameraCount = 0;
+  uint32_t loadedMask = 0;
+  uint32_t wantedMask = 0;
+  int currentRegion = -1;
+  uint32_t regionChanges = 0;
+  uint32_t regionLoads = 0;
+
+  static int64_t boxArea(const CameraRegion &region) {
+    return (int64_t)(region.maxLatE6 - region.minLatE6) * (region.maxLonE6 - region.minLonE6);
+  }
+
+  // Stay in the current region while inside its box, else take the smallest
+  // box holding the point, else the nearest box
+  int pickRegion(int32_t latE6, int32_t lonE6) const {
+    if (currentRegion >= 0 && db.distanceToRegion(currentRegion, latE6, lonE6) == 0) {
+      return currentRegion;
+    }
+
+    int best = -1;
+    uint32_t bestDistance = UINT32_MAX;
+    int64_t bestArea = INT64_MAX;
+    for (size_t r = 0; r < Db::regionCount(); r++) {
+      CameraRegion candidate = db.region(r);
+      if (candidate.cameraCount == 0) continue;
+
+      uint32_t distance = db.distanceToRegion(r, latE6, lonE6);
+      int64_t area = boxArea(candidate);
+      if (distance < bestDistance || (distance == 0 && area < bestArea)) {
+        best = r;
+        bestDistance = distance;
+        bestArea = area;
+      }
+    }
+    return best;
+  }
+
+  void evict(uint8_t index) {
+    LoadedRegion gone = loaded[index];
+    uint16_t tail = cameraCount - gone.offset - gone.count;
+    memmove(cameras + gone.offset, cameras + gone.offset + gone.count, tail * sizeof(CameraPosition));
+    memmove(vectors + gone.offset, vectors + gone.offset + gone.count, tail * sizeof(GeoVector));
+    cameraCount -= gone.count;
+    cameraGrid.removeItems(gone.offset, gone.count);
+
+    loadedCount--;
+    memmove(loaded + index, loaded + index + 1, (loadedCount - index) * sizeof(LoadedRegion));
+    for (uint8_t i = index; i < loadedCount; i++) {
+      loaded[i].offset -= gone.count;
+    }
+    loadedMask &= ~(1UL << gone.region);
+  }
+
+  // Page in the nearest wanted region that is not loaded yet; false when
+  // there is none (or it does not fit)
+  bool loadNext(int32_t latE6, int32_t lonE6) {
+    uint32_t missing = wantedMask & ~loadedMask;
+    if (missing == 0) return false;
+
+    int next = -1;
+    uint32_t nextDistance = UINT32_MAX;
+    for (size_t r = 0; r < Db::regionCount(); r++) {
+      if (!(missing & (1UL << r))) continue;
+      uint32_t distance = db.distanceToRegion(r, latE6, lonE6);
+      if (distance < nextDistance) {
+        next = r;
+        nextDistance = distance;
+      }
+    }
+
+    CameraRegion region = db.region(next);
+    if (cameraCount + region.cameraCount > CAPACITY) {
+      return false;  // cannot happen with CAPACITY >= workingSetSize()
+    }
+
+    loaded[loadedCount++] = { (uint8_t)next, cameraCount, region.cameraCount };
+    uint16_t added = db.decodeRegion(next, cameras + cameraCount);
+    for (uint16_t i = cameraCount; i < cameraCount + added; i++) {
+      vectors[i] = geoVector(cameras[i].latE6, cameras[i].lonE6);
+      cameraGrid.insert(gridKey(gridCell(cameras[i].latE6), gridCell(cameras[i].lonE6)), i);
+    }
+    cameraCount += added;
+    loadedMask |= 1UL << next;
+    regionLoads++;
+    return true;
+  }
+
+public:
+  explicit RegionWorkingSet(const Db &database)
+    : db(database) {}
+
+  // Follow the vehicle: on a region change, drop the regions that are no
+  // longer neighbours and page in all the new ones
+  void update(int32_t latE6, int32_t lonE6) {
+    int region = pickRegion(latE6, lonE6);
+    if (region < 0) return;
+
+    if (region != currentRegion) {
+      currentRegion = region;
+      wantedMask = db.region(region).adjacent;
+      regionChanges++;
+
+      for (int i = loadedCount - 1; i >= 0; i--) {
+        if (!(wantedMask & (1UL << loaded[i].region))) evict(i);
+      }
+      while (loadNext(latE6, lonE6)) {}
+    }
+  }
+
+  // Visit every loaded camera inside the square of half-size radiusM around
+  // the point. visit(camera) returns true to stop early. Returns the cameras visited.
+  template<typename Visitor>
+  uint16_t forEachNear(int32_t latE6, int32_t lonE6, uint32_t radiusM, Visitor visit) const {
+    GridWindow window = gridWindow(latE6, lonE6, radiusM);
+    uint16_t visited = 0;
+
+    cameraGrid.forEachInWindow(window, [&](uint16_t item) {
+      const CameraPosition &camera = cameras[item];
+      if (abs(camera.latE6 - latE6) > window.dLatE6 || abs(camera.lonE6 - lonE6) > window.dLonE6) {
+        return false;
+      }
+      visited++;
+      return visit(camera);
+    });
+    return visited;
+  }
+
+  // Visit every loaded camera within radiusM (great circle) of the point.
+  // visit(camera, chordSq) returns true to stop early; chordSq (geoChordSq)
+  // orders the cameras by distance. Returns the candidates from the box
+  // test, i.e. the cameras that got the exact test.
+  template<typename Visitor>
+  uint16_t forEachWithin(int32_t latE6, int32_t lonE6, uint32_t radiusM, Visitor visit) const {
+    GeoVector here = geoVector(latE6, lonE6);
+    uint64_t limit = geoChordSqForMeters(radiusM);
+
+    return forEachNear(latE6, lonE6, radiusM, [&](const CameraPosition &camera) {
+      uint64_t chordSq = geoChordSq(vectors[&camera - cameras], here);
+      return chordSq <= limit && visit(camera, chordSq);
+    });
+  }
+
+  int getCurrentRegion() const {
+    return currentRegion;
+  }
+
+  uint16_t getCameraCount() const {
+    return cameraCount;
+  }
+
+  // True once every neighbour of the current region is paged in
+  bool isComplete() const {
+    return currentRegion >= 0 && loadedMask == wantedMask;
+  }
+
+  uint32_t getRegionChangeCount() const {
+    return regionChanges;
+  }
+
+  uint32_t getRegionLoadCount() const {
+    return regionLoads;
+  }
+};
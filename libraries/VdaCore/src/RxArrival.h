@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpscRing.h"
+
+// Arrival times of bytes moving through a receive ring. The producer adds a
+// mark per captured chunk, { bytes captured up to and including the chunk,
+// time of capture }; the consumer counts the bytes it parses and dates a
+// byte by the mark of the chunk that held it. If marks are lost to a full
+// ring, bytes take the next mark and look younger than they are.
+template<size_t MARKS>
+class RxArrival {
+private:
+  struct Mark {
+    uint32_t byteCount;
+    uint32_t micros;
+  };
+
+  SpscRing<Mark, MARKS> marks;
+  uint32_t capturedBytes = 0;  // producer side
+  uint32_t parsedBytes = 0;    // consumer side
+  Mark current = {};
+  bool hasCurrent = false;
+
+public:
+  // ---------------------------------------------- Producer side ----------------------------------------------
+
+  // count bytes went into the receive ring at nowUs
+  void captured(size_t count, uint32_t nowUs) {
+    capturedBytes += count;
+    marks.push({ capturedBytes, nowUs });
+  }
+
+  // ---------------------------------------------- Consumer side ----------------------------------------------
+
+  // One more byte was taken from the receive ring
+  void parsed() {
+    parsedBytes++;
+  }
+
+  // Arrival of the last byte parsed; nowUs if its mark is not there yet
+  // (the producer publishes bytes before their mark)
+  uint32_t lastArrival(uint32_t nowUs) {
+    while (!hasCurrent || (int32_t)(current.byteCount - parsedBytes) < 0) {
+      hasCurrent = marks.pop(current);
+      if (!hasCurrent) {
+        return nowUs;
+      }
+    }
+    return current.micros;
+  }
+};
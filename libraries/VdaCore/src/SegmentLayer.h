@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpatialGrid.h"
+
+// Road segments with a posted speed limit, looked up through the same sparse
+// grid as the cameras. Every grid cell a segment's bounding box touches gets
+// an index entry, so keep segments short (a few hundred meters).
+
+struct RoadSegment {
+  double lat1, lon1;
+  double lat2, lon2;
+  uint8_t limitKmh;  // 0 = not indexed (placeholder)
+};
+
+struct SegmentLine {
+  int32_t lat1E6, lon1E6;
+  int32_t lat2E6, lon2E6;
+  uint8_t limitKmh;
+};
+
+template<size_t SEGMENTS, size_t ENTRIES>
+struct SegmentLayer {
+  SegmentLine lines[SEGMENTS];
+  GridIndex<ENTRIES> index;
+
+  static const uint32_t CM_PER_E6_Q16 = 728727;  // 1 microdegree of latitude = 11.119 cm
+
+  // To cm before the cosine, so a longitude difference keeps its sub-microdegree part
+  static int32_t toCm(int32_t e6) {
+    return (int32_t)(((int64_t)e6 * CM_PER_E6_Q16 + (1 << 15)) >> 16);
+  }
+
+  // Distance in cm from the point to a segment (flat earth around the point,
+  // integer only like GpsKalman). cosLat is Q30.
+  static uint32_t distanceCm(const SegmentLine &line, int32_t latE6, int32_t lonE6, int32_t cosLat) {
+    int64_t ax = mulQ30(toCm(line.lon1E6 - lonE6), cosLat), ay = toCm(line.lat1E6 - latE6);
+    int64_t bx = mulQ30(toCm(line.lon2E6 - lonE6), cosLat), by = toCm(line.lat2E6 - latE6);
+    int64_t dx = bx - ax, dy = by - ay;
+    int64_t lengthSq = dx * dx + dy * dy;
+
+    // Nearest point a + t (b - a), t = along / lengthSq clamped to 0..1
+    int64_t along = -(ax * dx + ay * dy);
+    int64_t px = ax, py = ay;
+    if (along >= lengthSq) {
+      px = bx;
+      py = by;
+    } else if (along > 0) {
+      px += dx * along / lengthSq;
+      py += dy * along / lengthSq;
+    }
+    return isqrt64((uint64_t)(px * px + py * py));
+  }
+
+  // Limit of the nearest segment within maxDistanceM, 0 if there is none
+  uint8_t limitAt(int32_t latE6, int32_t lonE6, uint32_t maxDistanceM) const {
+    int32_t cosLat = sinCos(degreesE6ToAngle(latE6)).cos;
+    uint32_t bestDistance = maxDistanceM * 100;
+    uint8_t limit = 0;
+
+    index.forEachNear(latE6, lonE6, maxDistanceM, [&](uint16_t item) {
+      uint32_t distance = distanceCm(lines[item], latE6, lonE6, cosLat);
+      if (distance <= bestDistance) {
+        bestDistance = distance;
+        limit = lines[item].limitKmh;
+      }
+      return false;
+    });
+    return limit;
+  }
+};
+
+// Stand-in for boards without a road layer
+struct NoRoadLayer {
+  uint8_t limitAt(int32_t, int32_t, uint32_t) const {
+    return 0;
+  }
+};
+
+// ---------------------------------------------- Compile-time builder ----------------------------------------------
+
+namespace SegmentLayerBuild {
+
+template<typename Visit>
+constexpr void forEachCell(const RoadSegment &segment, Visit visit) {
+  int32_t lat1 = toE6(segment.lat1), lat2 = toE6(segment.lat2);
+  int32_t lon1 = toE6(segment.lon1), lon2 = toE6(segment.lon2);
+  int32_t rowLo = gridCell(lat1 < lat2 ? lat1 : lat2), rowHi = gridCell(lat1 < lat2 ? lat2 : lat1);
+  int32_t colLo = gridCell(lon1 < lon2 ? lon1 : lon2), colHi = gridCell(lon1 < lon2 ? lon2 : lon1);
+
+  for (int32_t row = rowLo; row <= rowHi; row++) {
+    for (int32_t col = colLo; col <= colHi; col++) {
+      visit(gridKey(row, col));
+    }
+  }
+}
+
+}  // namespace SegmentLayerBuild
+
+// Index entries needed for a segment table (at least 1, so an empty layer still compiles)
+template<size_t N>
+constexpr size_t segmentIndexSize(const RoadSegment (&segments)[N]) {
+  size_t entries = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (segments[i].limitKmh == 0) continue;
+    SegmentLayerBuild::forEachCell(segments[i], [&entries](uint32_t) {
+      entries++;
+    });
+  }
+  return entries > 0 ? entries : 1;
+}
+
+template<size_t ENTRIES, size_t N>
+constexpr SegmentLayer<N, ENTRIES> buildSegmentLayer(const RoadSegment (&segments)[N]) {
+  SegmentLayer<N, ENTRIES> layer = {};
+
+  for (size_t i = 0; i < N; i++) {
+    const RoadSegment &segment = segments[i];
+    layer.lines[i] = { toE6(segment.lat1), toE6(segment.lon1), toE6(segment.lat2), toE6(segment.lon2), segment.limitKmh };
+    if (segment.limitKmh == 0) continue;
+
+    // Insertion sort keeps the index ordered by cell key
+    SegmentLayerBuild::forEachCell(segment, [&](uint32_t key) {
+      GridEntry entry = { key, (uint16_t)i };
+      size_t j = layer.index.count++;
+      while (j > 0 && layer.index.entries[j - 1].key > entry.key) {
+        layer.index.entries[j] = layer.index.entries[j - 1];
+        j--;
+      }
+      layer.index.entries[j] = entry;
+    });
+  }
+  return layer;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <stdlib.h>
+#include "FixedTrig.h"
+
+// Sparse lat/lon grid over fixed microdegree cells. Items are stored as
+// (cell key, item id) entries sorted by key, so a cell lookup is a binary
+// search and only occupied cells take space. An item may own several entries
+// (e.g. one per cell its bounding box touches).
+
+constexpr int32_t GRID_CELL_E6 = 10000;               // 0.01 degree, ~1.1 km north-south
+constexpr double GRID_METERS_PER_DEGREE = 111194.93;  // one degree of latitude on a 6371 km sphere
+constexpr uint32_t GRID_E6_PER_METER_Q16 = (uint32_t)(65536e6 / GRID_METERS_PER_DEGREE + 0.5);
+constexpr uint32_t GRID_METERS_PER_E6_Q32 = (uint32_t)(GRID_METERS_PER_DEGREE * 1e-6 * 4294967296.0 + 0.5);
+
+constexpr int32_t toE6(double degrees) {
+  return (int32_t)(degrees * 1e6 + (degrees >= 0 ? 0.5 : -0.5));
+}
+
+// Cell row / column of a coordinate (floor division, also for negative values)
+constexpr int32_t gridCell(int32_t e6, int32_t cellE6 = GRID_CELL_E6) {
+  return e6 >= 0 ? e6 / cellE6 : -((-e6 + cellE6 - 1) / cellE6);
+}
+
+// Row in the high half, column in the low half: a grid row is one contiguous key range
+constexpr uint32_t gridKey(int32_t latCell, int32_t lonCell) {
+  return ((uint32_t)(uint16_t)(latCell + 0x8000) << 16) | (uint16_t)(lonCell + 0x8000);
+}
+
+// Cell rows and columns overlapping the square of half-size radiusM around a point
+struct GridWindow {
+  int32_t latLo, latHi;
+  int32_t lonLo, lonHi;
+  int32_t dLatE6, dLonE6;  // half-size of the square in microdegrees
+};
+
+inline GridWindow gridWindow(int32_t latE6, int32_t lonE6, uint32_t radiusM, int32_t cellE6 = GRID_CELL_E6) {
+  int32_t cosLat = sinCos(degreesE6ToAngle(latE6)).cos;
+  if (cosLat < Q30_ONE / 100) cosLat = Q30_ONE / 100;
+
+  // Rounded up, the square may only grow
+  int64_t northE6 = ((uint64_t)radiusM * GRID_E6_PER_METER_Q16 + 0xFFFF) >> 16;
+  int32_t dLatE6 = (int32_t)northE6 + 1;
+  int32_t dLonE6 = (int32_t)(((northE6 << 30) + cosLat - 1) / cosLat) + 1;
+
+  return { gridCell(latE6 - dLatE6, cellE6), gridCell(latE6 + dLatE6, cellE6),
+           gridCell(lonE6 - dLonE6, cellE6), gridCell(lonE6 + dLonE6, cellE6),
+           dLatE6, dLonE6 };
+}
+
+struct GridEntry {
+  uint32_t key;
+  uint16_t item;
+};
+
+template<size_t N>
+struct GridIndex {
+  GridEntry entries[N];
+  size_t count;
+
+  // First entry with key >= key
+  size_t lowerBound(uint32_t key) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (entries[mid].key < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // Add one entry after those with the same key. Returns false when full.
+  bool insert(uint32_t key, uint16_t item) {
+    if (count == N) return false;
+
+    size_t at = count;
+    while (at > 0 && entries[at - 1].key > key) {
+      entries[at] = entries[at - 1];
+      at--;
+    }
+    entries[at] = { key, item };
+    count++;
+    return true;
+  }
+
+  // Drop the entries of items first..first + n - 1 and renumber the items
+  // after them, to follow an item array that closed the same gap
+  void removeItems(uint16_t first, uint16_t n) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+      GridEntry entry = entries[i];
+      if (entry.item >= first && entry.item - first < n) continue;
+      if (entry.item >= first) entry.item -= n;
+      entries[kept++] = entry;
+    }
+    count = kept;
+  }
+
+  // Visit the items of every cell in the window. visit(item) returns true to
+  // stop early. Returns the number of entries visited.
+  template<typename Visitor>
+  uint16_t forEachInWindow(const GridWindow &window, Visitor visit) const {
+    uint16_t visited = 0;
+
+    for (int32_t row = window.latLo; row <= window.latHi; row++) {
+      uint32_t lastKey = gridKey(row, window.lonHi);
+      for (size_t i = lowerBound(gridKey(row, window.lonLo)); i < count && entries[i].key <= lastKey; i++) {
+        visited++;
+        if (visit(entries[i].item)) {
+          return visited;
+        }
+      }
+    }
+    return visited;
+  }
+
+  // Visit the items of every cell overlapping the square of half-size
+  // radiusM around the point. Same visitor and return as forEachInWindow().
+  template<typename Visitor>
+  uint16_t forEachNear(int32_t latE6, int32_t lonE6, uint32_t radiusM, Visitor visit) const {
+    return forEachInWindow(gridWindow(latE6, lonE6, radiusM), visit);
+  }
+
+  // Visit the items of the one cell holding the point, for items indexed in
+  // every cell they cover (segments, zones). Same return as forEachNear().
+  template<typename Visitor>
+  uint16_t forEachAt(int32_t latE6, int32_t lonE6, Visitor visit) const {
+    uint32_t key = gridKey(gridCell(latE6), gridCell(lonE6));
+    uint16_t visited = 0;
+
+    for (size_t i = lowerBound(key); i < count && entries[i].key == key; i++) {
+      visited++;
+      if (visit(entries[i].item)) {
+        return visited;
+      }
+    }
+    return visited;
+  }
+};
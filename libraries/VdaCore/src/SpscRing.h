@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// The producer (UART receive callback, ISR, another task) only calls push*(),
+// the consumer (loop) only calls pop*(). SIZE must be a power of two.
+template<typename T, size_t SIZE>
+class SpscRing {
+private:
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SpscRing size must be a power of two");
+  static constexpr uint32_t MASK = SIZE - 1;
+
+  T buffer[SIZE];
+
+  // head is written by the producer only, tail by the consumer only
+  std::atomic<uint32_t> head{ 0 };
+  std::atomic<uint32_t> tail{ 0 };
+
+  // Producer-side statistics
+  std::atomic<uint32_t> dropped{ 0 };
+  std::atomic<uint32_t> highWater{ 0 };
+
+  void noteLevel(uint32_t level) {
+    if (level > highWater.load(std::memory_order_relaxed)) {
+      highWater.store(level, std::memory_order_relaxed);
+    }
+  }
+
+public:
+  // ---------------------------------------------- Producer side ----------------------------------------------
+
+  bool push(const T &item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+
+    if (h - t >= SIZE) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    buffer[h & MASK] = item;
+    head.store(h + 1, std::memory_order_release);
+    noteLevel(h + 1 - t);
+    return true;
+  }
+
+  // Push as many items as fit, count the rest as dropped. Returns items stored.
+  size_t pushBurst(const T *items, size_t count) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+
+    size_t space = SIZE - (h - t);
+    size_t n = count < space ? count : space;
+
+    for (size_t i = 0; i < n; i++) {
+      buffer[(h + i) & MASK] = items[i];
+    }
+    head.store(h + n, std::memory_order_release);
+
+    if (n < count) {
+      dropped.fetch_add(count - n, std::memory_order_relaxed);
+    }
+    noteLevel(h + n - t);
+    return n;
+  }
+
+  // Free slots as seen by the producer
+  size_t space() const {
+    return SIZE - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+  }
+
+  // ---------------------------------------------- Consumer side ----------------------------------------------
+
+  bool pop(T &item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+
+    if (h == t) {
+      return false;
+    }
+
+    item = buffer[t & MASK];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pop up to maxCount items into out. Returns items copied.
+  size_t popBatch(T *out, size_t maxCount) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+
+    size_t available = h - t;
+    size_t n = available < maxCount ? available : maxCount;
+
+    for (size_t i = 0; i < n; i++) {
+      out[i] = buffer[(t + i) & MASK];
+    }
+    tail.store(t + n, std::memory_order_release);
+    return n;
+  }
+
+  size_t available() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+  }
+
+  bool isEmpty() const {
+    return available() == 0;
+  }
+
+  // ---------------------------------------------- Statistics ----------------------------------------------
+
+  static constexpr size_t capacity() {
+    return SIZE;
+  }
+
+  uint32_t getDroppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+  uint32_t getHighWater() const {
+    return highWater.load(std::memory_order_relaxed);
+  }
+};
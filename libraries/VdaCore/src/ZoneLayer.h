@@ -0,0 +1,223 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpatialGrid.h"
+
+// Alert zones (school zones, roadworks, low-emission areas) as polygons,
+// looked up through the same sparse grid as the cameras and road segments.
+// Every grid cell a zone's bounding box touches gets an index entry, so a
+// lookup only visits the zones listed for the fix's cell, and only those
+// whose box holds the fix get the point-in-polygon test. A large zone costs
+// index entries (one per 0.01 degree cell), not time per fix.
+
+enum ZoneKind : uint8_t {
+  ZONE_NONE,
+  ZONE_SCHOOL,
+  ZONE_ROADWORKS,
+  ZONE_LOW_EMISSION
+};
+
+struct ZoneVertex {
+  double lat;
+  double lon;
+};
+
+// A polygon over a contiguous range of the vertex table, in either winding,
+// not closed (the last vertex connects back to the first)
+struct AlertZone {
+  ZoneKind kind;
+  uint8_t limitKmh;  // 0 = no limit of its own
+  uint16_t first;
+  uint16_t count;    // < 3 = not indexed (placeholder)
+};
+
+// Compiled edge, ordered south to north. Horizontal edges never cross the
+// test ray and are left out.
+struct ZoneEdge {
+  int32_t latLoE6, lonLoE6;
+  int32_t latHiE6, lonHiE6;
+};
+
+struct ZonePolygon {
+  int32_t latLoE6, latHiE6;  // bounding box
+  int32_t lonLoE6, lonHiE6;
+  uint16_t firstEdge;
+  uint16_t edgeCount;
+  ZoneKind kind;
+  uint8_t limitKmh;
+};
+
+struct ZoneMatch {
+  ZoneKind kind;     // ZONE_NONE outside every zone
+  uint8_t limitKmh;
+  uint16_t tested;   // zones that got the crossing test
+};
+
+template<size_t ZONES, size_t EDGES, size_t ENTRIES>
+struct ZoneLayer {
+  ZonePolygon polygons[ZONES];
+  ZoneEdge edges[EDGES];
+  GridIndex<ENTRIES> index;
+
+  // Crossing number with a ray to the east, integers only. An edge counts
+  // from its south end up to (not including) its north end, so a ray through
+  // a vertex crosses exactly one of the two edges meeting there.
+  bool contains(const ZonePolygon &polygon, int32_t latE6, int32_t lonE6) const {
+    bool inside = false;
+
+    for (uint16_t i = 0; i < polygon.edgeCount; i++) {
+      const ZoneEdge &edge = edges[polygon.firstEdge + i];
+      if (latE6 < edge.latLoE6 || latE6 >= edge.latHiE6) continue;
+
+      // Sign of the cross product: is the crossing east of the point?
+      int64_t crossing = (int64_t)(edge.lonHiE6 - edge.lonLoE6) * (latE6 - edge.latLoE6) -
+                         (int64_t)(lonE6 - edge.lonLoE6) * (edge.latHiE6 - edge.latLoE6);
+      if (crossing > 0) inside = !inside;
+    }
+    return inside;
+  }
+
+  // Zone under the point. Where zones overlap the lowest limit wins, a zone
+  // without a limit only if no other has one.
+  ZoneMatch zoneAt(int32_t latE6, int32_t lonE6) const {
+    ZoneMatch match = { ZONE_NONE, 0, 0 };
+
+    index.forEachAt(latE6, lonE6, [&](uint16_t item) {
+      const ZonePolygon &polygon = polygons[item];
+      if (latE6 < polygon.latLoE6 || latE6 > polygon.latHiE6 || lonE6 < polygon.lonLoE6 || lonE6 > polygon.lonHiE6) {
+        return false;
+      }
+
+      match.tested++;
+      if (contains(polygon, latE6, lonE6) &&
+          (match.kind == ZONE_NONE || (polygon.limitKmh > 0 && (match.limitKmh == 0 || polygon.limitKmh < match.limitKmh)))) {
+        match.kind = polygon.kind;
+        match.limitKmh = polygon.limitKmh;
+      }
+      return false;
+    });
+    return match;
+  }
+};
+
+// Stand-in for boards without zones
+struct NoZoneLayer {
+  ZoneMatch zoneAt(int32_t, int32_t) const {
+    return { ZONE_NONE, 0, 0 };
+  }
+};
+
+// ---------------------------------------------- Compile-time builder ----------------------------------------------
+
+struct ZoneLayerSize {
+  size_t edges;
+  size_t entries;
+};
+
+namespace ZoneLayerBuild {
+
+struct Box {
+  int32_t latLo, latHi;
+  int32_t lonLo, lonHi;
+};
+
+template<size_t V>
+constexpr Box boxOf(const ZoneVertex (&vertices)[V], const AlertZone &zone) {
+  Box box = { toE6(vertices[zone.first].lat), toE6(vertices[zone.first].lat),
+              toE6(vertices[zone.first].lon), toE6(vertices[zone.first].lon) };
+  for (uint16_t i = 1; i < zone.count; i++) {
+    int32_t lat = toE6(vertices[zone.first + i].lat), lon = toE6(vertices[zone.first + i].lon);
+    if (lat < box.latLo) box.latLo = lat;
+    if (lat > box.latHi) box.latHi = lat;
+    if (lon < box.lonLo) box.lonLo = lon;
+    if (lon > box.lonHi) box.lonHi = lon;
+  }
+  return box;
+}
+
+template<typename Visit>
+constexpr void forEachCell(const Box &box, Visit visit) {
+  for (int32_t row = gridCell(box.latLo); row <= gridCell(box.latHi); row++) {
+    for (int32_t col = gridCell(box.lonLo); col <= gridCell(box.lonHi); col++) {
+      visit(gridKey(row, col));
+    }
+  }
+}
+
+// Edges of a zone, south end first, horizontal ones skipped
+template<size_t V, typename Visit>
+constexpr void forEachEdge(const ZoneVertex (&vertices)[V], const AlertZone &zone, Visit visit) {
+  for (uint16_t i = 0; i < zone.count; i++) {
+    const ZoneVertex &a = vertices[zone.first + i];
+    const ZoneVertex &b = vertices[zone.first + (i + 1) % zone.count];
+    ZoneEdge edge = { toE6(a.lat), toE6(a.lon), toE6(b.lat), toE6(b.lon) };
+    if (edge.latLoE6 == edge.latHiE6) continue;
+    if (edge.latLoE6 > edge.latHiE6) {
+      edge = { edge.latHiE6, edge.lonHiE6, edge.latLoE6, edge.lonLoE6 };
+    }
+    visit(edge);
+  }
+}
+
+}  // namespace ZoneLayerBuild
+
+// Edges and index entries needed for a zone table (at least 1 each, so an
+// empty layer still compiles)
+template<size_t V, size_t Z>
+constexpr ZoneLayerSize measureZoneLayer(const ZoneVertex (&vertices)[V], const AlertZone (&zones)[Z]) {
+  ZoneLayerSize size = { 0, 0 };
+  for (size_t i = 0; i < Z; i++) {
+    if (zones[i].count < 3) continue;
+    ZoneLayerBuild::forEachEdge(vertices, zones[i], [&size](const ZoneEdge &) {
+      size.edges++;
+    });
+    ZoneLayerBuild::forEachCell(ZoneLayerBuild::boxOf(vertices, zones[i]), [&size](uint32_t) {
+      size.entries++;
+    });
+  }
+  if (size.edges == 0) size.edges = 1;
+  if (size.entries == 0) size.entries = 1;
+  return size;
+}
+
+// Usage (two steps, the sizes become template arguments):
+//   constexpr ZoneLayerSize SIZE = measureZoneLayer(zoneVertices, zones);
+//   constexpr auto LAYER = buildZoneLayer<SIZE.edges, SIZE.entries>(zoneVertices, zones);
+template<size_t EDGES, size_t ENTRIES, size_t V, size_t Z>
+constexpr ZoneLayer<Z, EDGES, ENTRIES> buildZoneLayer(const ZoneVertex (&vertices)[V], const AlertZone (&zones)[Z]) {
+  ZoneLayer<Z, EDGES, ENTRIES> layer = {};
+  size_t edges = 0;
+
+  for (size_t i = 0; i < Z; i++) {
+    const AlertZone &zone = zones[i];
+    ZonePolygon &polygon = layer.polygons[i];
+    polygon.firstEdge = (uint16_t)edges;
+    polygon.kind = zone.kind;
+    polygon.limitKmh = zone.limitKmh;
+    if (zone.count < 3) continue;
+
+    ZoneLayerBuild::Box box = ZoneLayerBuild::boxOf(vertices, zone);
+    polygon.latLoE6 = box.latLo;
+    polygon.latHiE6 = box.latHi;
+    polygon.lonLoE6 = box.lonLo;
+    polygon.lonHiE6 = box.lonHi;
+
+    ZoneLayerBuild::forEachEdge(vertices, zone, [&](const ZoneEdge &edge) {
+      layer.edges[edges++] = edge;
+    });
+    polygon.edgeCount = (uint16_t)(edges - polygon.firstEdge);
+
+    // Insertion sort keeps the index ordered by cell key
+    ZoneLayerBuild::forEachCell(box, [&](uint32_t key) {
+      GridEntry entry = { key, (uint16_t)i };
+      size_t j = layer.index.count++;
+      while (j > 0 && layer.index.entries[j - 1].key > entry.key) {
+        layer.index.entries[j] = layer.index.entries[j - 1];
+        j--;
+      }
+      layer.index.entries[j] = entry;
+    });
+  }
+  return layer;
+}
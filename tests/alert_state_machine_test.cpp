@@ -0,0 +1,150 @@
+// AlertStateMachine against tables written out here: every base state the
+// machine can be in, every combination of inputs, checked for the next
+// state, the cue and the steady outputs.
+
+#include <Arduino.h>
+#include "test.h"
+#include "AlertStateMachine.h"
+
+namespace {
+
+const AlertState BASE_STATES[] = { ALERT_NO_FIX, ALERT_CRUISING, ALERT_OVERSPEED, ALERT_PROXIMITY, ALERT_STALE_FIX };
+
+// Expected cue for a base state change, [from][to]; the MODE_DISPLAY row and
+// column stay unused, it is never a base state
+const AlertCue NONE = ALERT_CUE_NONE, FOUND = ALERT_CUE_SIGNAL_FOUND, LOST = ALERT_CUE_SIGNAL_LOST,
+               EXIT = ALERT_CUE_PROXIMITY_EXIT;
+const AlertCue CUES[ALERT_STATE_COUNT][ALERT_STATE_COUNT] = {
+  //            NO_FIX  CRUISING  OVERSPEED  PROXIMITY  MODE  STALE
+  /* NO_FIX */ { NONE, FOUND, FOUND, FOUND, NONE, NONE },
+  /* CRUISE */ { LOST, NONE, NONE, NONE, NONE, LOST },
+  /* OVER   */ { LOST, NONE, NONE, NONE, NONE, LOST },
+  /* PROX   */ { LOST, EXIT, EXIT, NONE, NONE, LOST },
+  /* MODE   */ { NONE, NONE, NONE, NONE, NONE, NONE },
+  /* STALE  */ { NONE, FOUND, FOUND, FOUND, NONE, NONE }
+};
+
+// Expected steady outputs per visible state (overspeed sound per band, below)
+const AlertOutputs OUTPUTS[ALERT_STATE_COUNT] = {
+  { ALERT_LED_RED, ALERT_DISPLAY_LOADING, ALERT_SOUND_NONE },
+  { ALERT_LED_GREEN, ALERT_DISPLAY_SPEED, ALERT_SOUND_NONE },
+  { ALERT_LED_BEEP_WHITE, ALERT_DISPLAY_SPEED, ALERT_SOUND_OVERSPEED_FAST },
+  { ALERT_LED_BEEP_WHITE, ALERT_DISPLAY_SPEED, ALERT_SOUND_PROXIMITY },
+  { ALERT_LED_MODE_BLINK, ALERT_DISPLAY_MODE, ALERT_SOUND_NONE },
+  { ALERT_LED_DEGRADED, ALERT_DISPLAY_LOADING, ALERT_SOUND_NONE }
+};
+
+const int LIMIT = 50;
+const int FAST_KMH = 80;  // 30 over: fast band
+const int SLOW_KMH = 40;
+
+AlertInputs inputsFor(unsigned bits) {
+  AlertInputs in = {};
+  in.hasFix = bits & 1;
+  in.fixStale = bits & 2;
+  in.inProximity = bits & 4;
+  in.modeDisplay = bits & 8;
+  in.speedKmh = bits & 16 ? FAST_KMH : SLOW_KMH;
+  in.speedLimit = LIMIT;
+  in.inZone = bits & 32;
+  return in;
+}
+
+AlertState expectedBase(const AlertInputs &in) {
+  if (in.hasFix && !in.fixStale && in.inProximity) return ALERT_PROXIMITY;
+  if (in.hasFix && in.fixStale) return ALERT_STALE_FIX;
+  if (!in.hasFix) return ALERT_NO_FIX;
+  if (in.speedKmh > in.speedLimit) return ALERT_OVERSPEED;
+  return ALERT_CRUISING;
+}
+
+// A machine in the given base state, zone entry not yet announced
+AlertStateMachine machineIn(AlertState state) {
+  AlertStateMachine machine;
+  AlertInputs in = inputsFor(1);
+  if (state == ALERT_NO_FIX) in.hasFix = false;
+  if (state == ALERT_OVERSPEED) in.speedKmh = FAST_KMH;
+  if (state == ALERT_PROXIMITY) in.inProximity = true;
+  if (state == ALERT_STALE_FIX) in.fixStale = true;
+  machine.step(in);
+  return machine;
+}
+
+bool sameOutputs(const AlertOutputs &a, const AlertOutputs &b) {
+  return a.led == b.led && a.display == b.display && a.sound == b.sound;
+}
+
+}  // namespace
+
+TEST(alert_state_machine_every_state_and_input) {
+  unsigned pairs = 0;
+
+  for (AlertState from : BASE_STATES) {
+    for (unsigned bits = 0; bits < 64; bits++) {
+      AlertStateMachine machine = machineIn(from);
+      if (!CHECK_EQ(machine.getBaseState(), from)) continue;
+
+      AlertInputs in = inputsFor(bits);
+      AlertCue cue = machine.step(in);
+
+      AlertState base = expectedBase(in);
+      AlertState visible = in.modeDisplay && base != ALERT_PROXIMITY ? ALERT_MODE_DISPLAY : base;
+      AlertCue expectedCue = CUES[from][base];
+      if (expectedCue == ALERT_CUE_NONE && in.inZone && in.hasFix && !in.fixStale) {
+        expectedCue = ALERT_CUE_ZONE_ENTER;
+      }
+
+      bool ok = CHECK_EQ(machine.getBaseState(), base);
+      ok = CHECK_EQ(machine.getState(), visible) && ok;
+      ok = CHECK_EQ(cue, expectedCue) && ok;
+      ok = CHECK(sameOutputs(machine.outputs(), OUTPUTS[visible])) && ok;
+      if (!ok) printf("    from state %u, inputs 0x%02x\n", from, bits);
+      pairs++;
+    }
+  }
+  CHECK_EQ(pairs, 5u * 64u);
+}
+
+TEST(alert_state_machine_zone_cue_waits_for_a_transition_cue) {
+  AlertStateMachine machine;
+  AlertInputs in = inputsFor(1 | 32);
+
+  CHECK_EQ(machine.step(in), ALERT_CUE_SIGNAL_FOUND);
+  CHECK_EQ(machine.step(in), ALERT_CUE_ZONE_ENTER);
+  CHECK_EQ(machine.step(in), ALERT_CUE_NONE);
+
+  // Leaving and re-entering announces again; a stale fix counts as leaving
+  in.fixStale = true;
+  CHECK_EQ(machine.step(in), ALERT_CUE_SIGNAL_LOST);
+  in.fixStale = false;
+  CHECK_EQ(machine.step(in), ALERT_CUE_SIGNAL_FOUND);
+  CHECK_EQ(machine.step(in), ALERT_CUE_ZONE_ENTER);
+}
+
+TEST(alert_state_machine_overspeed_bands) {
+  AlertStateMachine machine;
+  AlertInputs in = inputsFor(1);
+  const struct {
+    int overKmh;
+    AlertSound sound;
+  } BANDS[] = {
+    { 0, ALERT_SOUND_NONE }, { 1, ALERT_SOUND_OVERSPEED_SLOW }, { 5, ALERT_SOUND_OVERSPEED_SLOW },
+    { 6, ALERT_SOUND_OVERSPEED_MEDIUM }, { 15, ALERT_SOUND_OVERSPEED_MEDIUM }, { 16, ALERT_SOUND_OVERSPEED_FAST }
+  };
+
+  for (const auto &band : BANDS) {
+    in.speedKmh = LIMIT + band.overKmh;
+    machine.step(in);
+    CHECK_EQ(machine.outputs().sound, band.sound);
+  }
+
+  machine.setOverspeedBands(2, 4);
+  in.speedKmh = LIMIT + 3;
+  machine.step(in);
+  CHECK_EQ(machine.outputs().sound, ALERT_SOUND_OVERSPEED_MEDIUM);
+
+  // No limit set: never overspeed
+  in.speedLimit = 0;
+  machine.step(in);
+  CHECK_EQ(machine.getState(), ALERT_CRUISING);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "BoardPolicy.h"
+
+// Board the binary is built for, set by the Makefile (-DTEST_BOARD=V1Board
+// or V2Board). The drivers always run on HostGpio here.
+#ifndef TEST_BOARD
+#error "build with -DTEST_BOARD=V1Board or -DTEST_BOARD=V2Board"
+#endif
+
+typedef TEST_BOARD<HostGpio> Board;
+
+#define TEST_BOARD_STRING(board) #board
+#define TEST_BOARD_NAME_OF(board) TEST_BOARD_STRING(board)
+#define TEST_BOARD_NAME TEST_BOARD_NAME_OF(TEST_BOARD)
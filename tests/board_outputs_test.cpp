@@ -0,0 +1,203 @@
+// The v2 output drivers on the recording GPIO backend: BetterRGB's writes
+// for a common anode LED (masks, levels, PWM duty) and the GN1650 two-wire
+// frames as they go out on DISPLAY_DATA / DISPLAY_CLK.
+
+#include <Arduino.h>
+#include <vector>
+#include "test.h"
+#include "Better-RGB.h"
+#include "GN1650.h"
+
+namespace {
+
+typedef V2Board<HostGpio> V2;
+
+const uint32_t RED = pinMask(V2::LED_R), GREEN = pinMask(V2::LED_G), BLUE = pinMask(V2::LED_B);
+const uint32_t DAT = pinMask(V2::DISPLAY_DATA), CLK = pinMask(V2::DISPLAY_CLK);
+
+bool sameEvent(const GpioEvent &event, GpioEventKind kind, uint8_t pin, uint32_t mask, uint32_t value) {
+  if (event.kind == kind && event.pin == pin && event.mask == mask && event.value == value) return true;
+  printf("    event kind %u pin %u mask 0x%x value %u, expected kind %u pin %u mask 0x%x value %u\n", event.kind, event.pin,
+         event.mask, event.value, kind, pin, mask, value);
+  return false;
+}
+
+bool isWrite(const GpioEvent &event, uint32_t mask, bool level) {
+  return sameEvent(event, GPIO_EVENT_WRITE, NO_PIN, mask, level);
+}
+
+bool isDelay(const GpioEvent &event, uint32_t us) {
+  return sameEvent(event, GPIO_EVENT_DELAY, NO_PIN, 0, us);
+}
+
+// One GN1650 transfer read back from the log: the bytes clocked in on rising
+// CLK edges, with start / stop conditions and ACK clocks checked on the way
+struct Gn1650Frame {
+  std::vector<uint8_t> bytes;
+  bool started = false, stopped = false, acksReleased = true;
+};
+
+Gn1650Frame readFrame(const HostGpio::Log &log, uint16_t &at) {
+  Gn1650Frame frame;
+  uint32_t levels = CLK | DAT;
+  bool released = false;
+  uint8_t bits = 0, value = 0;
+
+  for (; at < log.count && !frame.stopped; at++) {
+    const GpioEvent &event = log.events[at];
+    if (event.kind == GPIO_EVENT_RELEASE && event.mask == DAT) released = true;
+    if (event.kind == GPIO_EVENT_DRIVE && event.mask == DAT) released = false;
+    if (event.kind != GPIO_EVENT_WRITE) continue;
+
+    uint32_t before = levels;
+    levels = event.value ? levels | event.mask : levels & ~event.mask;
+    bool clockHigh = (before & CLK) && (levels & CLK);
+    if (clockHigh && (before & DAT) && !(levels & DAT)) frame.started = true;
+    if (clockHigh && !(before & DAT) && (levels & DAT)) frame.stopped = frame.started;
+
+    // Rising clock: eight data bits, then the ACK clock with DAT let go
+    if (frame.started && !(before & CLK) && (levels & CLK)) {
+      if (bits < 8) {
+        value = value << 1 | ((levels & DAT) ? 1 : 0);
+        bits++;
+      } else {
+        frame.acksReleased = frame.acksReleased && released;
+        frame.bytes.push_back(value);
+        bits = 0;
+        value = 0;
+      }
+    }
+  }
+  return frame;
+}
+
+}  // namespace
+
+TEST(better_rgb_common_anode_masks_and_levels) {
+  BetterRGB<V2> rgb;
+  const HostGpio::Log &log = HostGpio::log();
+
+  // begin(): three outputs, each driven high (off on a common anode)
+  rgb.begin();
+  CHECK_EQ(log.count, 6u);
+  CHECK(sameEvent(log.events[0], GPIO_EVENT_OUTPUT, V2::LED_R, RED, 0));
+  CHECK(sameEvent(log.events[1], GPIO_EVENT_OUTPUT, V2::LED_G, GREEN, 0));
+  CHECK(sameEvent(log.events[2], GPIO_EVENT_OUTPUT, V2::LED_B, BLUE, 0));
+  CHECK(isWrite(log.events[3], RED, HIGH));
+  CHECK(isWrite(log.events[4], GREEN, HIGH));
+  CHECK(isWrite(log.events[5], BLUE, HIGH));
+  CHECK_EQ(log.levels, RED | GREEN | BLUE);
+
+  // Red and blue on: both pulled low, green already off is not written again
+  HostGpio::clear();
+  rgb.setDigitalColor(true, false, true);
+  CHECK_EQ(log.count, 2u);
+  CHECK(isWrite(log.events[0], RED, LOW));
+  CHECK(isWrite(log.events[1], BLUE, LOW));
+  CHECK_EQ(log.levels, GREEN);
+
+  // PWM duty is inverted, and a digital write takes the pin back first
+  HostGpio::clear();
+  rgb.setAnalogRed(64);
+  rgb.setAnalogRed(64);
+  rgb.setDigitalRed(false);
+  CHECK_EQ(log.count, 3u);
+  CHECK(sameEvent(log.events[0], GPIO_EVENT_ANALOG, V2::LED_R, RED, 255 - 64));
+  CHECK(sameEvent(log.events[1], GPIO_EVENT_OUTPUT, V2::LED_R, RED, 0));
+  CHECK(isWrite(log.events[2], RED, HIGH));
+  CHECK_EQ(log.levels, RED | GREEN);
+  CHECK_EQ(log.dropped, 0u);
+}
+
+TEST(better_rgb_long_effect_applies_each_frame_once) {
+  BetterRGB<V2> rgb;
+  rgb.begin();
+
+  // More frames than an int8_t holds: past frame 127 each one still goes out once
+  static LedColor frames[200];
+  for (int i = 0; i < 200; i++) frames[i] = i % 2 ? LedColor{ 255, 0, 0 } : LedColor{ 0, 0, 255 };
+  rgb.playEffect(frames, 200, 10, LED_STEP_DIGITAL);
+
+  HostArduino::advanceMs(1505);
+  rgb.update();
+  OutputStats before = rgb.getOutputStats();
+  for (int i = 0; i < 3; i++) rgb.update();
+  CHECK_EQ(rgb.getOutputStats().written, before.written);
+  CHECK_EQ(rgb.getOutputStats().elided, before.elided);
+
+  HostArduino::advanceMs(10);
+  rgb.update();
+  CHECK(rgb.getOutputStats().written > before.written);
+  CHECK(rgb.isPlaying(frames));
+}
+
+TEST(gn1650_frames_on_the_bus) {
+  GN1650<V2> display;
+  const HostGpio::Log &log = HostGpio::log();
+
+  // begin(): pins out and idle high, three RAM clears, then the system command
+  display.begin();
+  CHECK(sameEvent(log.events[0], GPIO_EVENT_OUTPUT, V2::DISPLAY_DATA, DAT, 0));
+  CHECK(sameEvent(log.events[1], GPIO_EVENT_OUTPUT, V2::DISPLAY_CLK, CLK, 0));
+  CHECK(isWrite(log.events[2], DAT | CLK, HIGH));
+  const uint8_t BEGIN_FRAMES[4][2] = { { 0x68, 0x00 }, { 0x6A, 0x00 }, { 0x6C, 0x00 }, { 0x48, 0x01 } };
+  uint16_t at = 3;
+  for (const auto &expected : BEGIN_FRAMES) {
+    Gn1650Frame frame = readFrame(log, at);
+    CHECK(frame.started && frame.stopped && frame.acksReleased);
+    CHECK_EQ(frame.bytes.size(), 2u);
+    if (frame.bytes.size() == 2) {
+      CHECK_EQ(frame.bytes[0], expected[0]);
+      CHECK_EQ(frame.bytes[1], expected[1]);
+    }
+  }
+  CHECK_EQ(at, log.count - 2);  // condition hold and transfer gap
+
+  // 7: only DIG3 changes, one frame with the exact start, first bit, ACK and
+  // stop sequences
+  HostGpio::clear();
+  display.displayNumber(7);
+  at = 0;
+  Gn1650Frame frame = readFrame(log, at);
+  CHECK_EQ(at, log.count - 2);
+  CHECK_EQ(frame.bytes.size(), 2u);
+  if (frame.bytes.size() == 2) {
+    CHECK_EQ(frame.bytes[0], 0x6C);
+    CHECK_EQ(frame.bytes[1], 0x07);
+  }
+
+  const GpioEvent *e = log.events;
+  CHECK(isWrite(e[0], CLK | DAT, HIGH));  // start: DAT falls while CLK is high
+  CHECK(isDelay(e[1], V2::CONDITION_US));
+  CHECK(isWrite(e[2], DAT, LOW));
+  CHECK(isDelay(e[3], V2::CONDITION_US));
+  CHECK(isWrite(e[4], CLK, LOW));  // bit 7 of 0x6C, clocked on the rising edge
+  CHECK(isDelay(e[5], V2::BIT_US));
+  CHECK(isWrite(e[6], DAT, LOW));
+  CHECK(isDelay(e[7], V2::BIT_US));
+  CHECK(isWrite(e[8], CLK, HIGH));
+  CHECK(isDelay(e[9], V2::BIT_US));
+
+  const GpioEvent *ack = e + 4 + 8 * 6;  // after eight bits
+  CHECK(isWrite(ack[0], CLK, LOW));
+  CHECK(sameEvent(ack[1], GPIO_EVENT_RELEASE, NO_PIN, DAT, 0));
+  CHECK(isDelay(ack[2], V2::BIT_US));
+  CHECK(isWrite(ack[3], CLK, HIGH));
+  CHECK(isDelay(ack[4], V2::BIT_US));
+  CHECK(sameEvent(ack[5], GPIO_EVENT_DRIVE, NO_PIN, DAT, 0));
+
+  const GpioEvent *stop = log.events + log.count - 7;
+  CHECK(isWrite(stop[0], CLK | DAT, LOW));  // stop: DAT rises while CLK is high
+  CHECK(isDelay(stop[1], V2::CONDITION_US));
+  CHECK(isWrite(stop[2], CLK, HIGH));
+  CHECK(isDelay(stop[3], V2::CONDITION_US));
+  CHECK(isWrite(stop[4], DAT, HIGH));
+  CHECK(isDelay(stop[5], V2::CONDITION_US));
+  CHECK(isDelay(stop[6], V2::TRANSFER_GAP_US));
+
+  // Same number again: nothing on the bus
+  HostGpio::clear();
+  display.displayNumber(7);
+  CHECK_EQ(log.count, 0u);
+  CHECK_EQ(log.dropped, 0u);
+}
@@ -0,0 +1,149 @@
+// ButtonInput on replayed edge lists: debouncing, the three gestures, the
+// double press gap switched off, a button held at boot, and a loop that
+// stalls while the edges keep arriving.
+
+#include <Arduino.h>
+#include <vector>
+#include "test.h"
+#include "ButtonInput.h"
+
+namespace {
+
+typedef ButtonInput<32> Button;
+
+const ButtonTiming TIMING = { 30, 800, 300 };  // debounce, long press, double press gap
+
+struct Reported {
+  ButtonGesture gesture;
+  uint32_t atMs;  // poll() that returned it
+};
+
+// Queue each edge when its time comes (the pin interrupt) and poll every
+// pollMs, except that no poll runs from stallFromMs to stallToMs
+std::vector<Reported> replay(Button &button, const std::vector<ButtonEdge> &edges, uint32_t endMs, uint32_t pollMs = 1,
+                             uint32_t stallFromMs = 0, uint32_t stallToMs = 0) {
+  std::vector<Reported> reported;
+  size_t next = 0;
+  for (uint32_t t = 0; t <= endMs; t++) {
+    while (next < edges.size() && edges[next].timeMs <= t) {
+      button.onEdge(edges[next].pressed, edges[next].timeMs);
+      next++;
+    }
+    if (t % pollMs != 0 || (t >= stallFromMs && t < stallToMs)) continue;
+    for (ButtonGesture gesture; (gesture = button.poll(t)) != BUTTON_NONE;) {
+      reported.push_back({ gesture, t });
+    }
+  }
+  return reported;
+}
+
+bool sameGestures(const std::vector<Reported> &reported, const std::vector<ButtonGesture> &expected) {
+  bool same = reported.size() == expected.size();
+  for (size_t i = 0; same && i < expected.size(); i++) same = reported[i].gesture == expected[i];
+  if (same) return true;
+  printf("    got");
+  for (const Reported &r : reported) printf(" %u@%u", r.gesture, r.atMs);
+  printf("\n");
+  return false;
+}
+
+}  // namespace
+
+TEST(button_bounce_burst_is_one_short_press) {
+  Button button(TIMING);
+  button.begin(false, 0);
+
+  // Contact bounce on press and on release
+  std::vector<ButtonEdge> edges = { { 100, true }, { 102, false }, { 104, true }, { 107, false }, { 109, true },
+                                    { 300, false }, { 302, true }, { 304, false } };
+  std::vector<Reported> reported = replay(button, edges, 1000);
+  CHECK(sameGestures(reported, { BUTTON_SHORT }));
+  if (reported.size() == 1) CHECK_EQ(reported[0].atMs, 304u + 300);  // once the double press gap has passed
+  CHECK(button.isIdle());
+}
+
+TEST(button_long_press_is_reported_while_held) {
+  Button button(TIMING);
+  button.begin(false, 0);
+
+  std::vector<ButtonEdge> edges = { { 100, true }, { 2000, false } };
+  std::vector<Reported> reported = replay(button, edges, 950);
+  CHECK(sameGestures(reported, { BUTTON_LONG }));
+  if (reported.size() == 1) CHECK_EQ(reported[0].atMs, 100u + 800);
+  CHECK(button.isPressed());
+
+  // The release after a long press is not a gesture
+  button.onEdge(false, 2000);
+  CHECK_EQ(button.poll(3000), BUTTON_NONE);
+  CHECK(!button.isPressed());
+  CHECK(button.isIdle());
+}
+
+TEST(button_press_in_the_gap_is_a_double) {
+  Button button(TIMING);
+  button.begin(false, 0);
+
+  // Second press 150 ms after the release: one DOUBLE, on the press
+  std::vector<ButtonEdge> edges = { { 100, true }, { 250, false }, { 400, true }, { 500, false } };
+  std::vector<Reported> reported = replay(button, edges, 1500);
+  CHECK(sameGestures(reported, { BUTTON_DOUBLE }));
+  if (reported.size() == 1) CHECK_EQ(reported[0].atMs, 400u + 30);
+
+  // Second press 450 ms after the release: two SHORTs
+  Button slower(TIMING);
+  slower.begin(false, 0);
+  edges = { { 100, true }, { 250, false }, { 700, true }, { 800, false } };
+  CHECK(sameGestures(replay(slower, edges, 1500), { BUTTON_SHORT, BUTTON_SHORT }));
+}
+
+TEST(button_without_double_press_reports_short_on_release) {
+  ButtonTiming timing = TIMING;
+  timing.doublePressMs = 0;
+  Button button(timing);
+  button.begin(false, 0);
+
+  std::vector<ButtonEdge> edges = { { 100, true }, { 250, false }, { 400, true }, { 500, false } };
+  std::vector<Reported> reported = replay(button, edges, 1500);
+  CHECK(sameGestures(reported, { BUTTON_SHORT, BUTTON_SHORT }));
+  if (reported.size() == 2) {
+    CHECK_EQ(reported[0].atMs, 250u + 30);
+    CHECK_EQ(reported[1].atMs, 500u + 30);
+  }
+}
+
+TEST(button_held_at_begin_is_ignored_until_released) {
+  Button button(TIMING);
+  button.begin(true, 0);
+  CHECK(button.isPressed());
+
+  // Held past the long press time, then a normal short press
+  std::vector<ButtonEdge> edges = { { 1500, false }, { 2000, true }, { 2100, false } };
+  CHECK(sameGestures(replay(button, edges, 3000), { BUTTON_SHORT }));
+}
+
+TEST(button_gestures_survive_a_stalled_loop) {
+  // Short, double, long and a bounced short, one after the other
+  const std::vector<ButtonEdge> EDGES = {
+    { 100, true },   { 200, false },                                  // short
+    { 1000, true },  { 1100, false }, { 1250, true }, { 1350, false },  // double
+    { 2000, true },  { 3200, false },                                 // long
+    { 4000, true },  { 4003, false }, { 4006, true },  { 4150, false }, { 4152, true }, { 4155, false }  // bounced short
+  };
+  const std::vector<ButtonGesture> EXPECTED = { BUTTON_SHORT, BUTTON_DOUBLE, BUTTON_LONG, BUTTON_SHORT };
+
+  Button prompt(TIMING);
+  prompt.begin(false, 0);
+  CHECK(sameGestures(replay(prompt, EDGES, 6000), EXPECTED));
+
+  // Polled every 250 ms, and not at all for the first 5 s
+  Button late(TIMING);
+  late.begin(false, 0);
+  CHECK(sameGestures(replay(late, EDGES, 6000, 250), EXPECTED));
+
+  Button stalled(TIMING);
+  stalled.begin(false, 0);
+  std::vector<Reported> reported = replay(stalled, EDGES, 6000, 1, 0, 5000);
+  CHECK(sameGestures(reported, EXPECTED));
+  for (const Reported &r : reported) CHECK_EQ(r.atMs, 5000u);
+  CHECK_EQ(stalled.getDroppedEdges(), 0u);
+}
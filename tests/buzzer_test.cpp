@@ -0,0 +1,163 @@
+// BetterBuzzer tone timeline on the fake clock: tick() once per ms, the
+// tone() / noTone() calls it makes are checked against the expected edges.
+
+#include <Arduino.h>
+#include "board.h"
+#include "test.h"
+#include "Better-Buzzer.h"
+
+namespace {
+
+constexpr BuzzerNote TWO_NOTES[] = { { 1000, 100, 50 }, { 2000, 80, 0 }, { 0, 40, 20 } };
+constexpr BuzzerPattern TWO_NOTES_PATTERN = buzzerPattern(TWO_NOTES);
+constexpr BuzzerNote TIED[] = { { 1500, 50, 0 }, { 1500, 50, 10 } };
+constexpr BuzzerPattern TIED_PATTERN = buzzerPattern(TIED);
+constexpr BuzzerNote BEEP[] = { { 800, 30, 20 } };
+constexpr BuzzerPattern BEEP_LOOP = buzzerPattern(BEEP, true);
+constexpr BuzzerNote ALARM[] = { { 3000, 40, 10 }, { 2500, 40, 10 } };
+constexpr BuzzerPattern ALARM_LOOP = buzzerPattern(ALARM, true);
+
+// Tick every ms up to and including endMs
+void runUntil(BetterBuzzer &buzzer, uint32_t endMs) {
+  while (millis() < endMs) {
+    HostArduino::advanceMs(1);
+    buzzer.tick();
+  }
+}
+
+bool sameTones(const std::vector<HostTone> &expected) {
+  const std::vector<HostTone> &tones = HostArduino::tones;
+  bool same = tones.size() == expected.size();
+  for (size_t i = 0; same && i < tones.size(); i++) {
+    same = tones[i].pin == expected[i].pin && tones[i].frequency == expected[i].frequency
+           && tones[i].atMs == expected[i].atMs;
+  }
+  if (!same) {
+    for (const HostTone &tone : tones) printf("    got pin %u %u Hz at %u ms\n", tone.pin, tone.frequency, tone.atMs);
+  }
+  return same;
+}
+
+BetterBuzzer started() {
+  BetterBuzzer buzzer;
+  buzzer.begin(Board::BUZZER);
+  HostArduino::tones.clear();
+  return buzzer;
+}
+
+}  // namespace
+
+TEST(buzzer_note_and_gap_boundaries) {
+  BetterBuzzer buzzer = started();
+  CHECK(buzzer.play(TWO_NOTES_PATTERN, BUZZER_UI));
+
+  runUntil(buzzer, 99);
+  CHECK(buzzer.isSounding());
+  runUntil(buzzer, 100);
+  CHECK(!buzzer.isSounding());
+  runUntil(buzzer, 149);
+  CHECK(!buzzer.isSounding());
+  runUntil(buzzer, 150);
+  CHECK(buzzer.isSounding());
+
+  // Zero gap after the second note runs straight into the rest note
+  runUntil(buzzer, 289);
+  CHECK(buzzer.isBusy());
+  runUntil(buzzer, 290);
+  CHECK(!buzzer.isBusy());
+  CHECK_EQ(buzzer.activePriority(), BUZZER_IDLE);
+
+  const uint8_t pin = Board::BUZZER;
+  CHECK(sameTones({ { pin, 1000, 0 }, { pin, 0, 100 }, { pin, 2000, 150 }, { pin, 0, 230 } }));
+}
+
+TEST(buzzer_zero_gap_ties_equal_notes) {
+  BetterBuzzer buzzer = started();
+  buzzer.play(TIED_PATTERN, BUZZER_UI);
+  runUntil(buzzer, 200);
+
+  const uint8_t pin = Board::BUZZER;
+  CHECK(sameTones({ { pin, 1500, 0 }, { pin, 0, 100 } }));
+  CHECK(!buzzer.isBusy());
+}
+
+TEST(buzzer_looping_pattern_keeps_its_period) {
+  BetterBuzzer buzzer = started();
+  buzzer.play(BEEP_LOOP, BUZZER_UI);
+  runUntil(buzzer, 249);
+
+  const uint8_t pin = Board::BUZZER;
+  std::vector<HostTone> expected;
+  for (uint32_t start = 0; start < 250; start += 50) {
+    expected.push_back({ pin, 800, start });
+    expected.push_back({ pin, 0, start + 30 });
+  }
+  CHECK(sameTones(expected));
+  CHECK(buzzer.isBusy());
+
+  buzzer.stop(BUZZER_UI);
+  runUntil(buzzer, 400);
+  CHECK(!buzzer.isBusy());
+  CHECK_EQ(HostArduino::tones.size(), expected.size());
+}
+
+TEST(buzzer_short_stall_keeps_the_rhythm) {
+  BetterBuzzer buzzer = started();
+  buzzer.play(TWO_NOTES_PATTERN, BUZZER_UI);
+
+  // 30 ms late: the gap still ends at 150
+  HostArduino::advanceMs(130);
+  buzzer.tick();
+  runUntil(buzzer, 150);
+
+  const uint8_t pin = Board::BUZZER;
+  CHECK(sameTones({ { pin, 1000, 0 }, { pin, 0, 130 }, { pin, 2000, 150 } }));
+}
+
+TEST(buzzer_long_stall_restarts_from_now) {
+  BetterBuzzer buzzer = started();
+  buzzer.play(BEEP_LOOP, BUZZER_UI);
+
+  // 500 ms stall: one step at the stall's end, no burst of catch-up tones
+  HostArduino::advanceMs(500);
+  buzzer.tick();
+  runUntil(buzzer, 550);
+
+  const uint8_t pin = Board::BUZZER;
+  CHECK(sameTones({ { pin, 800, 0 }, { pin, 0, 500 }, { pin, 800, 520 }, { pin, 0, 550 } }));
+}
+
+TEST(buzzer_higher_priority_preempts_and_lower_resumes_after_stop) {
+  BetterBuzzer buzzer = started();
+  const uint8_t pin = Board::BUZZER;
+
+  CHECK(buzzer.play(BEEP_LOOP, BUZZER_OVERSPEED));
+  runUntil(buzzer, 60);  // second beep sounding
+
+  // Proximity takes over mid-note, the overspeed beep cannot come back in
+  CHECK(buzzer.play(ALARM_LOOP, BUZZER_PROXIMITY));
+  CHECK(buzzer.isPlaying(ALARM_LOOP));
+  CHECK_EQ(buzzer.activePriority(), BUZZER_PROXIMITY);
+  runUntil(buzzer, 80);
+  CHECK(!buzzer.play(BEEP_LOOP, BUZZER_OVERSPEED));
+  CHECK(!buzzer.play(TWO_NOTES_PATTERN, BUZZER_UI));
+  CHECK(buzzer.isPlaying(ALARM_LOOP));
+
+  // Stopping another priority leaves it playing
+  buzzer.stop(BUZZER_OVERSPEED);
+  CHECK(buzzer.isPlaying(ALARM_LOOP));
+
+  runUntil(buzzer, 160);
+  buzzer.stop(BUZZER_PROXIMITY);
+  CHECK(!buzzer.isBusy());
+  CHECK(!buzzer.isSounding());
+
+  // The overspeed warning can be started again and begins at its first note
+  runUntil(buzzer, 170);
+  CHECK(buzzer.play(BEEP_LOOP, BUZZER_OVERSPEED));
+  runUntil(buzzer, 230);
+
+  CHECK(sameTones({ { pin, 800, 0 }, { pin, 0, 30 }, { pin, 800, 50 },
+                    { pin, 3000, 60 }, { pin, 0, 100 }, { pin, 2500, 110 }, { pin, 0, 150 },
+                    { pin, 3000, 160 }, { pin, 0, 160 }, { pin, 800, 170 }, { pin, 0, 200 }, { pin, 800, 220 } }));
+}
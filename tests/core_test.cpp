@@ -0,0 +1,225 @@
+// Smoke test of the shared core as a board build wires it up: the board's
+// camera list through DetectorCore, the LED pins on HostGpio, a worker on the
+// TaskRuntime host thread path and the DriveLog RAM flash image.
+
+#include <Arduino.h>
+#include <atomic>
+#include "board.h"
+#include "test.h"
+#include "Better-RGB.h"
+#include "ProximityModel.h"
+#include "CameraDb.h"
+#include "SegmentLayer.h"
+#include "ZoneLayer.h"
+#include "DetectorCore.h"
+#include "SpscRing.h"
+#include "TaskRuntime.h"
+#include "DriveLog.h"
+#include "coordinates.h"
+
+namespace {
+
+constexpr ProximityModel PROXIMITY_MODEL = { 2.0f, 1.0f, 100, 150, 1000 };
+constexpr ProximityTable<200> PROXIMITY_RADIUS = buildProximityTable<200>(PROXIMITY_MODEL);
+constexpr CameraDbSize CAMERA_DB_SIZE = measureCameraDb(coordinates, regions);
+typedef CameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes, CAMERA_DB_SIZE.regions> CameraDatabase;
+constexpr CameraDatabase CAMERA_DB =
+  buildCameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes>(coordinates, regions, 2 * PROXIMITY_RADIUS.maxRadius());
+constexpr NoRoadLayer ROAD_LAYER = {};
+constexpr NoZoneLayer ZONE_LAYER = {};
+
+typedef DetectorCore<CameraDatabase, CAMERA_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), NoRoadLayer, NoZoneLayer> Detector;
+
+// Two cameras 222 m apart on a meridian, both inside the radius between them
+constexpr Coordinate PAIR_COORDINATES[] = { { 47.5000, 19.0000, 50 }, { 47.5020, 19.0000, 90 } };
+constexpr Region PAIR_REGIONS[] = { { "Pair", 0, 2 } };
+constexpr CameraDbSize PAIR_DB_SIZE = measureCameraDb(PAIR_COORDINATES, PAIR_REGIONS);
+typedef CameraDb<PAIR_DB_SIZE.blocks, PAIR_DB_SIZE.bytes, PAIR_DB_SIZE.regions> PairDatabase;
+constexpr PairDatabase PAIR_DB = buildCameraDb<PAIR_DB_SIZE.blocks, PAIR_DB_SIZE.bytes>(
+  PAIR_COORDINATES, PAIR_REGIONS, 2 * PROXIMITY_RADIUS.maxRadius());
+
+GpsFix fixAt(double lat, double lon, uint16_t speedKmh) {
+  GpsFix fix = {};
+  fix.latE6 = toE6(lat);
+  fix.lonE6 = toE6(lon);
+  fix.speedKmhX10 = speedKmh * 10;
+  fix.valid = true;
+  fix.timestampMs = millis();
+  fix.courseCdeg = GPS_COURSE_UNKNOWN;
+  fix.rxMicros = micros();
+  return fix;
+}
+
+}  // namespace
+
+TEST(detector_alerts_at_a_camera_of_the_board_list) {
+  static Detector detector(CAMERA_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, 0, false, 1500);
+
+  GpsFix away = fixAt(48.6, 22.9, 50);  // north-east of the border, no camera near
+  ProximityResult result = detector.evaluate({ away, away });
+  CHECK(!result.inRange);
+  detector.step(result, false, 0, micros());
+  CHECK_EQ(detector.getAlert().getBaseState(), ALERT_CRUISING);
+
+  HostArduino::advanceMs(100);
+  GpsFix atCamera = fixAt(coordinates[0].lat, coordinates[0].lon, 50);
+  result = detector.evaluate({ atCamera, atCamera });
+  CHECK(result.inRange);
+  CHECK(result.candidates >= 1);
+  CHECK_EQ(result.radiusM, PROXIMITY_RADIUS.radiusFor(50));
+  detector.step(result, false, 0, micros());
+  CHECK_EQ(detector.getAlert().getBaseState(), ALERT_PROXIMITY);
+}
+
+TEST(detector_takes_the_limit_of_the_nearest_camera) {
+  static DetectorCore<PairDatabase, PAIR_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), NoRoadLayer, NoZoneLayer>
+    detector(PAIR_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, 0, true, 1500);
+
+  GpsFix nearSecond = fixAt(47.5013, 19.0000, 100);  // 144 m / 78 m
+  ProximityResult result = detector.evaluate({ nearSecond, nearSecond });
+  CHECK(result.radiusM >= 150);
+  CHECK(result.inRange);
+  CHECK_EQ(result.candidates, 2);
+  CHECK_EQ(result.cameraLimitKmh, 90);
+
+  GpsFix nearFirst = fixAt(47.5007, 19.0000, 100);  // 78 m / 144 m
+  result = detector.evaluate({ nearFirst, nearFirst });
+  CHECK(result.inRange);
+  CHECK_EQ(result.cameraLimitKmh, 50);
+  CHECK_EQ(detector.speedLimit(result, 0), 50);
+}
+
+TEST(region_working_set_finds_what_a_full_scan_finds) {
+  static RegionWorkingSet<CameraDatabase, CAMERA_DB.workingSetSize()> workingSet(CAMERA_DB);
+  const uint32_t RADIUS_M = PROXIMITY_RADIUS.maxRadius();
+  const size_t CAMERA_COUNT = sizeof(coordinates) / sizeof(coordinates[0]);
+  uint32_t checked = 0, found = 0;
+
+  // At and around every camera in list order, which jumps between regions,
+  // with offsets up to about the radius
+  const int32_t OFFSETS_E6[][2] = { { 0, 0 }, { 5000, 0 }, { 0, -9000 }, { -8000, 7000 } };
+  for (size_t point = 0; point < CAMERA_COUNT * 4; point++) {
+    int32_t latE6 = toE6(coordinates[point / 4].lat) + OFFSETS_E6[point % 4][0];
+    int32_t lonE6 = toE6(coordinates[point / 4].lon) + OFFSETS_E6[point % 4][1];
+    workingSet.update(latE6, lonE6);  // one update pages in every neighbour
+    if (!CHECK(workingSet.isComplete())) break;
+
+    GeoVector here = geoVector(latE6, lonE6);
+    uint64_t limit = geoChordSqForMeters(RADIUS_M);
+    uint32_t expected = 0, actual = 0;
+    for (size_t c = 0; c < CAMERA_COUNT; c++) {
+      if (geoChordSq(geoVector(toE6(coordinates[c].lat), toE6(coordinates[c].lon)), here) <= limit) expected++;
+    }
+    workingSet.forEachWithin(latE6, lonE6, RADIUS_M, [&](const CameraPosition &, uint64_t) {
+      actual++;
+      return false;
+    });
+
+    if (!CHECK_EQ(actual, expected)) break;
+    checked++;
+    found += expected;
+  }
+
+  printf("  %u points, %u cameras in range, %u region changes\n", checked, found, workingSet.getRegionChangeCount());
+  if (CameraDatabase::regionCount() > 1) CHECK(workingSet.getRegionChangeCount() > 1);  // v1: one region
+}
+
+TEST(leds_are_wired_to_the_board_pins) {
+  BetterRGB<Board> rgb;
+  rgb.begin();
+  rgb.setDigitalColor(true, false, false);
+
+  // Common anode on both boards: a lit channel is driven low
+  const HostGpio::Log &log = HostGpio::log();
+  CHECK_EQ(log.levels & pinMask(Board::LED_R), 0u);
+  CHECK_EQ(log.levels & pinMask(Board::LED_G), pinMask(Board::LED_G));
+  CHECK_EQ(log.events[0].kind, GPIO_EVENT_OUTPUT);
+  CHECK_EQ(log.events[0].pin, Board::LED_R);
+  CHECK_EQ(log.dropped, 0u);
+}
+
+TEST(task_runtime_runs_a_worker_thread) {
+  static SpscRing<uint32_t, 64> ring;
+  static std::atomic<bool> done(false);
+  const uint32_t COUNT = 1000;
+
+  CHECK(startTask("worker", [](void *) {
+    for (uint32_t i = 0; i < COUNT;) {
+      if (ring.push(i)) {
+        i++;
+      } else {
+        taskDelayMs(1);
+      }
+    }
+    done = true;
+  }, nullptr, 4096, 1, TASK_ANY_CORE));
+
+  uint32_t next = 0, value;
+  for (int idle = 0; next < COUNT && idle < 2000;) {
+    if (ring.pop(value)) {
+      CHECK_EQ(value, next);
+      next++;
+      idle = 0;
+    } else {
+      taskDelayMs(1);
+      idle++;
+    }
+  }
+  CHECK_EQ(next, COUNT);
+  while (!done) taskDelayMs(1);
+}
+
+TEST(drive_log_writes_sectors_into_the_host_image) {
+  static DriveLog log;
+  CHECK(log.begin());
+  log.logEvent(0, LOG_EVENT_BOOT, 0);
+  for (uint32_t i = 0; i < 100; i++) {
+    log.logFix(i * 100, 47500000 + i * 10, 19000000 - i * 10, 500, LOG_FLAG_VALID);
+    log.service();
+  }
+  log.sync();
+  for (int i = 0; i < 4; i++) log.service();
+
+  // Blank flash: the first sector gets sequence 1, the boot event comes first
+  const uint8_t *image = log.hostImage();
+  CHECK(log.hostImageSize() >= 4096);
+  CHECK_EQ(image[0] | image[1] << 8 | image[2] << 16 | (uint32_t)image[3] << 24, 0x314C4456u);
+  CHECK_EQ(image[4] | image[5] << 8 | image[6] << 16 | (uint32_t)image[7] << 24, 1u);
+  CHECK_EQ(image[8], LOG_EVENT);
+  CHECK_EQ(image[10], LOG_EVENT_BOOT);
+  CHECK(log.getPagesWritten() >= 2);
+  CHECK_EQ(log.getDroppedCount(), 0u);
+}
+
+TEST(drive_log_leaves_sector_erases_to_the_erase_task) {
+  static DriveLog log;
+  CHECK(log.begin(true));
+
+  // The first page waits in service() until its sector has been erased
+  uint32_t time = 0;
+  for (int i = 0; i < 40; i++, time += 1000) {
+    log.logFix(time, 47500000 + i * 10, 19000000, 500, LOG_FLAG_VALID);
+    log.service();
+  }
+  CHECK_EQ(log.getPagesWritten(), 0u);
+  CHECK(log.eraseAhead());
+  log.service();
+  CHECK_EQ(log.getPagesWritten(), 1u);
+
+  // Writing into a sector asks for the next one, erased once
+  CHECK(log.eraseAhead());
+  CHECK(!log.eraseAhead());
+
+  // A task that keeps up: two full sectors and more, nothing dropped
+  for (int i = 0; i < 1500; i++, time += 1000) {
+    log.logFix(time, 47500000 + i * 10, 19000000 - i * 10, 500, LOG_FLAG_VALID);
+    log.service();
+    if (i % 20 == 0) log.eraseAhead();
+  }
+  CHECK(log.getPagesWritten() > 32);
+  CHECK_EQ(log.getDroppedCount(), 0u);
+
+  const uint8_t *image = log.hostImage();
+  CHECK_EQ(image[4096 + 4], 2);
+  CHECK_EQ(image[2 * 4096 + 4], 3);
+}
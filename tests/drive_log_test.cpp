@@ -0,0 +1,260 @@
+// DriveLog on the RAM flash image: a drive across page and sector
+// boundaries with and without the erase task, records dropped while a page
+// waits for flash, a restart on a wrapped image resuming after the highest
+// sequence, and every image decoded with v2/tools/drivelog_decode.py.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "test.h"
+#include "DriveLog.h"
+
+namespace {
+
+const uint32_t SECTOR_SIZE = 4096;
+const uint32_t SECTOR_COUNT = 16;  // the host image
+
+// One record as drivelog_decode.py writes it to CSV, positions back in microdegrees
+struct Row {
+  uint32_t sequence;
+  uint32_t timeMs;
+  std::string type;
+  int32_t latE6, lonE6;
+  std::string value;  // speed for fixes, value for events, loops for loop stats
+};
+
+bool sameRow(const Row &a, const Row &b) {
+  return a.timeMs == b.timeMs && a.type == b.type && a.latE6 == b.latE6 && a.lonE6 == b.lonE6 && a.value == b.value;
+}
+
+std::vector<std::string> splitCsv(const std::string &line) {
+  std::vector<std::string> fields(1);
+  for (char c : line) {
+    if (c == ',') fields.emplace_back();
+    else if (c != '\n') fields.back() += c;
+  }
+  return fields;
+}
+
+// Run the decoder on the image; false if it could not be run
+bool decodeImage(DriveLog &log, std::vector<Row> &rows) {
+  char path[] = "/tmp/drivelog_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) return false;
+  bool written = write(fd, log.hostImage(), log.hostImageSize()) == (ssize_t)log.hostImageSize();
+  close(fd);
+
+  std::string source = __FILE__;
+  std::string command = "python3 " + source.substr(0, source.find_last_of('/') + 1)
+                        + "../v2/tools/drivelog_decode.py " + path;
+  FILE *out = written ? popen(command.c_str(), "r") : nullptr;
+  if (out == nullptr) {
+    unlink(path);
+    return false;
+  }
+
+  // sequence,page,time_ms,type,lat,lon,speed_kmh,course_deg,flags,value,avg_us,max_us,loops
+  char line[512];
+  bool header = true;
+  rows.clear();
+  while (fgets(line, sizeof(line), out) != nullptr) {
+    if (header) {
+      header = false;
+      continue;
+    }
+    std::vector<std::string> f = splitCsv(line);
+    if (f.size() != 13) continue;
+    Row row = { (uint32_t)atol(f[0].c_str()), (uint32_t)atol(f[2].c_str()), f[3], 0, 0, "" };
+    if (row.type == "fix") {
+      row.latE6 = (int32_t)lround(atof(f[4].c_str()) * 1e6);
+      row.lonE6 = (int32_t)lround(atof(f[5].c_str()) * 1e6);
+      row.value = f[6] + "/" + f[7] + "/" + f[8];
+    } else if (row.type == "loop_stats") {
+      row.value = f[10] + "/" + f[11] + "/" + f[12];
+    } else {
+      row.value = f[9];
+    }
+    rows.push_back(row);
+  }
+  int status = pclose(out);
+  unlink(path);
+  return status == 0 && !header;
+}
+
+// Speed and course as the decoder prints them (Python str() of a float)
+std::string decimal(uint32_t value, uint32_t divisor) {
+  char text[24];
+  snprintf(text, sizeof(text), "%.*f", divisor == 10 ? 1 : 2, (double)value / divisor);
+  std::string out = text;
+  while (out.back() == '0' && out[out.size() - 2] != '.') out.pop_back();
+  return out;
+}
+
+// A drive: boot, then fixes every 100 ms with a loop stats record every
+// second and a speed limit event now and then. Every record is added to
+// expected as the decoder should print it. Flash is serviced every record
+// (and erased ahead when eraseInTask), so nothing is dropped.
+void drive(DriveLog &log, bool eraseInTask, uint32_t fixes, uint32_t startMs, std::vector<Row> &expected) {
+  log.logEvent(startMs, LOG_EVENT_BOOT, 0);
+  expected.push_back({ 0, startMs, "boot", 0, 0, "0" });
+
+  int32_t lat = 47497912, lon = 19040235;
+  for (uint32_t i = 0; i < fixes; i++) {
+    uint32_t timeMs = startMs + 100 * (i + 1);
+    lat += (int32_t)(i * 7919 % 601) - 300;
+    lon -= (int32_t)(i * 104729 % 1201) - 200;
+    uint16_t speed = (uint16_t)(i * 37 % 1400);
+    uint16_t course = (uint16_t)(i * 131 % 36000);
+    uint8_t flags = LOG_FLAG_VALID | (i % 3 == 0 ? LOG_FLAG_COURSE : 0) | (i % 50 < 5 ? LOG_FLAG_PROXIMITY : 0);
+    log.logFix(timeMs, lat, lon, speed, flags, course);
+
+    std::string names = "valid";
+    if (flags & LOG_FLAG_PROXIMITY) names += "|proximity";
+    if (flags & LOG_FLAG_COURSE) names += "|course";
+    expected.push_back({ 0, timeMs, "fix", lat, lon,
+                         decimal(speed, 10) + "/" + (flags & LOG_FLAG_COURSE ? decimal(course, 100) : "") + "/" + names });
+
+    if (i % 10 == 9) {
+      log.logLoopStats(timeMs, 850 + i % 100, 4000 + i, 1000 + i);
+      expected.push_back({ 0, timeMs, "loop_stats", 0, 0,
+                           std::to_string(850 + i % 100) + "/" + std::to_string(4000 + i) + "/" + std::to_string(1000 + i) });
+    }
+    if (i % 97 == 0) {
+      log.logEvent(timeMs, LOG_EVENT_SPEED_LIMIT, -(int32_t)i);  // a negative value for the zigzag
+      expected.push_back({ 0, timeMs, "speed_limit", 0, 0, std::to_string(-(int32_t)i) });
+    }
+
+    if (eraseInTask) log.eraseAhead();
+    log.service();
+  }
+  log.sync();
+  for (int i = 0; i < 4; i++) {
+    if (eraseInTask) log.eraseAhead();
+    log.service();
+  }
+}
+
+uint32_t sectorSequence(DriveLog &log, uint32_t sector) {
+  const uint8_t *header = log.hostImage() + sector * SECTOR_SIZE;
+  if ((header[0] | header[1] << 8 | header[2] << 16 | (uint32_t)header[3] << 24) != 0x314C4456u) return 0;
+  return header[4] | header[5] << 8 | header[6] << 16 | (uint32_t)header[7] << 24;
+}
+
+bool sameRows(const std::vector<Row> &decoded, const std::vector<Row> &expected) {
+  bool same = decoded.size() == expected.size();
+  for (size_t i = 0; same && i < expected.size(); i++) {
+    if (!sameRow(decoded[i], expected[i])) {
+      printf("    row %zu: got %u %s %d %d %s, expected %u %s %d %d %s\n", i, decoded[i].timeMs,
+             decoded[i].type.c_str(), decoded[i].latE6, decoded[i].lonE6, decoded[i].value.c_str(),
+             expected[i].timeMs, expected[i].type.c_str(), expected[i].latE6, expected[i].lonE6,
+             expected[i].value.c_str());
+      same = false;
+    }
+  }
+  if (decoded.size() != expected.size()) printf("    %zu rows, expected %zu\n", decoded.size(), expected.size());
+  return same;
+}
+
+}  // namespace
+
+TEST(drive_log_decodes_across_pages_and_sectors) {
+  for (bool eraseInTask : { false, true }) {
+    DriveLog log;
+    CHECK(log.begin(eraseInTask));
+
+    // About three sectors' worth
+    std::vector<Row> expected;
+    drive(log, eraseInTask, 1100, 5000, expected);
+    CHECK_EQ(log.getDroppedCount(), 0u);
+    CHECK(log.getPagesWritten() > 32);
+    CHECK_EQ(sectorSequence(log, 0), 1u);
+    CHECK_EQ(sectorSequence(log, 2), 3u);
+    CHECK_EQ(sectorSequence(log, 3), 0u);
+
+    std::vector<Row> decoded;
+    if (!CHECK(decodeImage(log, decoded))) return;
+    CHECK(sameRows(decoded, expected));
+  }
+}
+
+TEST(drive_log_counts_records_dropped_while_a_page_waits) {
+  DriveLog log;
+  CHECK(log.begin());
+
+  // No service(): the first page is sealed and waits, the second fills up
+  uint32_t logged = 0;
+  while (log.getDroppedCount() == 0) {
+    log.logFix(logged * 100, 47500000 + logged, 19000000, 500, LOG_FLAG_VALID);
+    logged++;
+  }
+  uint32_t kept = logged - 1;
+  for (int i = 0; i < 9; i++) log.logEvent(logged * 100, LOG_EVENT_ALERT_CUE, 1);
+  CHECK_EQ(log.getDroppedCount(), 10u);
+
+  // Erase, then the waiting page: logging goes on, nothing more dropped
+  log.service();
+  log.service();
+  CHECK_EQ(log.getPagesWritten(), 1u);
+  log.logFix(100000, 47600000, 19100000, 600, LOG_FLAG_VALID);
+  CHECK_EQ(log.getDroppedCount(), 10u);
+  log.sync();
+  log.service();
+  log.sync();
+  log.service();
+  CHECK_EQ(log.getPagesWritten(), 3u);
+
+  // Every record but the dropped ones made it, in order
+  std::vector<Row> decoded;
+  if (!CHECK(decodeImage(log, decoded))) return;
+  if (!CHECK_EQ(decoded.size(), kept + 1)) return;
+  for (uint32_t i = 0; i < kept; i++) CHECK_EQ(decoded[i].timeMs, i * 100);
+  CHECK_EQ(decoded[kept].timeMs, 100000u);
+  CHECK_EQ(decoded[kept].latE6, 47600000);
+}
+
+TEST(drive_log_restart_resumes_after_the_highest_sequence) {
+  DriveLog log;
+  CHECK(log.begin());
+
+  // Past the end of the image: wraps into the oldest sectors
+  std::vector<Row> first;
+  drive(log, false, 7000, 0, first);
+  uint32_t highest = 0, newestSector = 0;
+  for (uint32_t sector = 0; sector < SECTOR_COUNT; sector++) {
+    if (sectorSequence(log, sector) > highest) {
+      highest = sectorSequence(log, sector);
+      newestSector = sector;
+    }
+  }
+  CHECK(highest > SECTOR_COUNT);
+  CHECK_EQ(log.getDroppedCount(), 0u);
+
+  // Reboot: the image stays, begin() finds the newest sector and writes the next one
+  std::vector<Row> second;
+  CHECK(log.begin(true));
+  drive(log, true, 60, 0, second);
+  uint32_t resumed = (newestSector + 1) % SECTOR_COUNT;
+  CHECK_EQ(sectorSequence(log, resumed), highest + 1);
+  CHECK_EQ(sectorSequence(log, newestSector), highest);
+
+  // Oldest first: the rest of the first drive, then the second one last
+  std::vector<Row> decoded;
+  if (!CHECK(decodeImage(log, decoded))) return;
+  if (!CHECK(decoded.size() > second.size())) return;
+  std::vector<Row> tail(decoded.end() - second.size(), decoded.end());
+  CHECK(sameRows(tail, second));
+  for (const Row &row : tail) CHECK_EQ(row.sequence, highest + 1);
+
+  // The first drive's rows that survived are its newest ones, whole and in order
+  std::vector<Row> survived(decoded.begin(), decoded.end() - second.size());
+  size_t from = first.size() - survived.size();
+  bool contiguous = true;
+  for (size_t i = 0; contiguous && i < survived.size(); i++) contiguous = sameRow(survived[i], first[from + i]);
+  CHECK(contiguous);
+  CHECK(survived.size() > first.size() / 2);
+  CHECK(sameRow(survived.back(), first.back()));
+}
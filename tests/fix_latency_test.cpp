@@ -0,0 +1,184 @@
+// RollingStats windows, FixLatency's fix age, stale latch and alert
+// latency on a hand-driven micros(), and RxArrival dating parsed bytes by
+// their capture marks (late and lost ones included).
+
+#include <initializer_list>
+#include "test.h"
+#include "FixLatency.h"
+#include "RxArrival.h"
+
+namespace {
+
+GpsFix fixAt(uint32_t rxMicros, bool valid = true) {
+  GpsFix fix = {};
+  fix.valid = valid;
+  fix.rxMicros = rxMicros;
+  fix.courseCdeg = GPS_COURSE_UNKNOWN;
+  return fix;
+}
+
+}  // namespace
+
+TEST(rolling_stats_window) {
+  RollingStats<4> stats;
+  CHECK_EQ(stats.size(), 0u);
+  CHECK_EQ(stats.last(), 0u);
+  CHECK_EQ(stats.mean(), 0u);
+  CHECK_EQ(stats.max(), 0u);
+  CHECK_EQ(stats.percentile(95), 0u);
+
+  for (uint32_t value : { 40, 10, 30, 20 }) stats.add(value);
+  CHECK_EQ(stats.size(), 4u);
+  CHECK_EQ(stats.last(), 20u);
+  CHECK_EQ(stats.mean(), 25u);
+  CHECK_EQ(stats.max(), 40u);
+  CHECK_EQ(stats.percentile(0), 10u);
+  CHECK_EQ(stats.percentile(25), 10u);
+  CHECK_EQ(stats.percentile(50), 20u);
+  CHECK_EQ(stats.percentile(51), 30u);
+  CHECK_EQ(stats.percentile(100), 40u);
+
+  // Two more overwrite the two oldest (40 and 10)
+  stats.add(5);
+  stats.add(50);
+  CHECK_EQ(stats.size(), 4u);
+  CHECK_EQ(stats.getTotal(), 6u);
+  CHECK_EQ(stats.last(), 50u);
+  CHECK_EQ(stats.mean(), (30u + 20 + 5 + 50) / 4);
+  CHECK_EQ(stats.max(), 50u);
+  CHECK_EQ(stats.percentile(50), 20u);
+
+  // Ties: nearest rank still lands on a sample
+  RollingStats<8> ties;
+  for (uint32_t value : { 7, 7, 7, 1, 9 }) ties.add(value);
+  CHECK_EQ(ties.percentile(20), 1u);
+  CHECK_EQ(ties.percentile(40), 7u);
+  CHECK_EQ(ties.percentile(80), 7u);
+  CHECK_EQ(ties.percentile(81), 9u);
+
+  stats.clear();
+  CHECK_EQ(stats.size(), 0u);
+  CHECK_EQ(stats.getTotal(), 0u);
+  CHECK_EQ(stats.last(), 0u);
+}
+
+TEST(fix_latency_ages_each_fix_once) {
+  FixLatency latency(1500);
+
+  // Three passes on the same fix: one sample, taken on the first
+  CHECK(!latency.update(fixAt(1000), 1800));
+  CHECK(!latency.update(fixAt(1000), 5000));
+  CHECK(!latency.update(fixAt(1000), 90000));
+  CHECK_EQ(latency.getFixAge().getTotal(), 1u);
+  CHECK_EQ(latency.getFixAge().last(), 800u);
+
+  CHECK(!latency.update(fixAt(101000), 103500));
+  CHECK_EQ(latency.getFixAge().getTotal(), 2u);
+  CHECK_EQ(latency.getFixAge().last(), 2500u);
+  CHECK_EQ(latency.getFixAge().max(), 2500u);
+}
+
+TEST(fix_latency_stale_latch_enters_and_exits) {
+  FixLatency latency(1500);
+  uint32_t rx = 0xFFF00000u;  // micros() wraps 1.05 s after this fix
+
+  CHECK(!latency.update(fixAt(rx), rx + 1000));
+  CHECK(!latency.update(fixAt(rx), rx + 1500000));  // at the limit, not past it
+  CHECK(!latency.isStale());
+
+  // Past the limit: stale, counted once however long it lasts
+  CHECK(latency.update(fixAt(rx), rx + 1500001));
+  CHECK(latency.isStale());
+  CHECK_EQ(latency.getStaleEvents(), 1u);
+  CHECK(latency.update(fixAt(rx), rx + 3000000));
+  CHECK(latency.update(fixAt(rx), rx + 0x80000000u));  // an old fix may look fresh to the subtraction
+  CHECK(latency.update(fixAt(rx), rx + 0xFFFFF000u));
+  CHECK_EQ(latency.getStaleEvents(), 1u);
+  CHECK_EQ(latency.getFixAge().getTotal(), 1u);
+
+  // The next fix clears it
+  CHECK(!latency.update(fixAt(rx + 0xFFFFF100u), rx + 0xFFFFF200u));
+  CHECK(!latency.isStale());
+  CHECK_EQ(latency.getFixAge().last(), 0x100u);
+
+  // Going stale again counts a second event
+  CHECK(latency.update(fixAt(rx + 0xFFFFF100u), rx + 0xFFFFF100u + 1600000));
+  CHECK_EQ(latency.getStaleEvents(), 2u);
+
+  // No fix at all is not degraded: it clears the latch, and the first fix after it is a new one
+  CHECK(!latency.update(fixAt(0, false), 7000000));
+  CHECK(!latency.isStale());
+  CHECK(!latency.update(fixAt(0, false), 9000000));
+  CHECK(!latency.update(fixAt(rx + 0xFFFFF100u), 9100000));
+  CHECK_EQ(latency.getFixAge().getTotal(), 3u);
+  CHECK_EQ(latency.getStaleEvents(), 2u);
+}
+
+TEST(fix_latency_alert_from_fix_to_first_tone) {
+  FixLatency latency(1500);
+  latency.alertSounded(5000);  // nothing pending: no sample
+  CHECK_EQ(latency.getAlertLatency().size(), 0u);
+
+  latency.alertRaised(fixAt(10000));
+  CHECK(latency.isAlertPending());
+  latency.alertSounded(14200);
+  CHECK(!latency.isAlertPending());
+  CHECK_EQ(latency.getAlertLatency().last(), 4200u);
+
+  // A second tone of the same alert adds nothing
+  latency.alertSounded(30000);
+  CHECK_EQ(latency.getAlertLatency().size(), 1u);
+
+  // Cancelled before it sounded
+  latency.alertRaised(fixAt(40000));
+  latency.alertCancelled();
+  latency.alertSounded(41000);
+  CHECK_EQ(latency.getAlertLatency().size(), 1u);
+
+  // Across the micros() wrap
+  latency.alertRaised(fixAt(0xFFFFFF00u));
+  latency.alertSounded(0x200);
+  CHECK_EQ(latency.getAlertLatency().last(), 0x300u);
+  CHECK_EQ(latency.getAlertLatency().max(), 4200u);
+}
+
+TEST(rx_arrival_dates_bytes_by_their_chunk) {
+  RxArrival<8> arrival;
+
+  // Nothing captured yet: the byte is as old as now
+  CHECK_EQ(arrival.lastArrival(500), 500u);
+
+  arrival.captured(3, 1000);
+  arrival.captured(2, 2000);
+  for (uint32_t byte = 1; byte <= 5; byte++) {
+    arrival.parsed();
+    CHECK_EQ(arrival.lastArrival(9999), byte <= 3 ? 1000u : 2000u);
+  }
+
+  // The producer publishes bytes before their mark
+  arrival.parsed();
+  CHECK_EQ(arrival.lastArrival(3100), 3100u);
+  arrival.captured(4, 3000);
+  CHECK_EQ(arrival.lastArrival(3200), 3000u);
+  for (int i = 0; i < 3; i++) arrival.parsed();
+  CHECK_EQ(arrival.lastArrival(3300), 3000u);
+
+  // Asking again without parsing keeps the answer
+  CHECK_EQ(arrival.lastArrival(3400), 3000u);
+}
+
+TEST(rx_arrival_lost_marks_make_bytes_look_younger) {
+  RxArrival<4> arrival;
+
+  // Six chunks into four mark slots: the last two marks are lost
+  for (uint32_t chunk = 0; chunk < 6; chunk++) arrival.captured(10, 1000 * (chunk + 1));
+  for (int i = 0; i < 40; i++) arrival.parsed();
+  CHECK_EQ(arrival.lastArrival(9000), 4000u);
+
+  // Bytes of the lost chunks take the next mark that made it
+  arrival.captured(10, 7000);
+  arrival.parsed();
+  CHECK_EQ(arrival.lastArrival(9000), 7000u);
+  for (int i = 0; i < 29; i++) arrival.parsed();
+  CHECK_EQ(arrival.lastArrival(9100), 7000u);
+}
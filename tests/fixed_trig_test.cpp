@@ -0,0 +1,102 @@
+// FixedTrig against libm: sweeps over the whole circle plus random cases,
+// held to the error bounds the integer code was accepted with.
+
+#include <Arduino.h>
+#include <random>
+#include "test.h"
+#include "FixedTrig.h"
+
+namespace {
+
+const double TURN = 4294967296.0;  // binary angle units per turn
+
+double angleToRadians(int64_t angle) {
+  return (double)angle * 2 * M_PI / TURN;
+}
+
+}  // namespace
+
+TEST(fixed_trig_sin_cos_within_1_7e_8) {
+  double worstSin = 0, worstCos = 0;
+
+  // Every 4099th binary angle (odd stride: no alignment with the CORDIC table)
+  for (uint64_t a = 0; a < (1ULL << 32); a += 4099) {
+    int32_t angle = (int32_t)(uint32_t)a;
+    SinCos sc = sinCos(angle);
+    double rad = angleToRadians(angle);
+    worstSin = fmax(worstSin, fabs(sc.sin / (double)Q30_ONE - sin(rad)));
+    worstCos = fmax(worstCos, fabs(sc.cos / (double)Q30_ONE - cos(rad)));
+  }
+
+  // Edges of the 180 degree fold
+  for (int32_t angle : { 0, ANGLE_RIGHT - 1, ANGLE_RIGHT, ANGLE_RIGHT + 1, -ANGLE_RIGHT, -ANGLE_RIGHT - 1, INT32_MIN, INT32_MAX }) {
+    SinCos sc = sinCos(angle);
+    worstSin = fmax(worstSin, fabs(sc.sin / (double)Q30_ONE - sin(angleToRadians(angle))));
+    worstCos = fmax(worstCos, fabs(sc.cos / (double)Q30_ONE - cos(angleToRadians(angle))));
+  }
+
+  printf("  max error sin %.2g cos %.2g\n", worstSin, worstCos);
+  CHECK(worstSin <= 1.7e-8);
+  CHECK(worstCos <= 1.7e-8);
+}
+
+TEST(fixed_trig_atan2_within_2_6e_8_rad) {
+  std::mt19937 random(1);
+  double worst = 0;
+
+  // Directions around the circle at magnitudes from 2^4 to 2^30
+  for (uint64_t a = 0; a < (1ULL << 32); a += 65537) {
+    double rad = angleToRadians((int32_t)(uint32_t)a);
+    for (int bits = 4; bits <= 30; bits += 2) {
+      double r = ldexp(1.0, bits);
+      int32_t x = (int32_t)llround(r * cos(rad)), y = (int32_t)llround(r * sin(rad));
+      if (x == 0 && y == 0) continue;
+      double error = remainder(angleToRadians(atan2Angle(y, x)) - atan2((double)y, (double)x), 2 * M_PI);
+      worst = fmax(worst, fabs(error));
+    }
+  }
+
+  // Random vectors, full int32 range and small ones
+  for (int i = 0; i < 200000; i++) {
+    int32_t y = (int32_t)random(), x = (int32_t)random();
+    if (i % 3 == 0) {
+      y >>= 20;
+      x >>= 12;
+    }
+    if (x == 0 && y == 0) continue;
+    double error = remainder(angleToRadians(atan2Angle(y, x)) - atan2((double)y, (double)x), 2 * M_PI);
+    worst = fmax(worst, fabs(error));
+  }
+
+  printf("  max error %.2g rad\n", worst);
+  CHECK(worst <= 2.6e-8);
+  CHECK_EQ(atan2Angle(0, 0), 0);
+  CHECK(abs((int32_t)((uint32_t)atan2Angle(0, -5) - ANGLE_HALF)) <= 16);  // 180 degrees, a few units off
+}
+
+TEST(fixed_trig_degrees_isqrt_asin) {
+  // Microdegrees round trip through binary angles (-180 may come back as 180)
+  for (int32_t e6 = -180000000; e6 < 180000000; e6 += 999983) {
+    int32_t back = angleToDegreesE6(degreesE6ToAngle(e6));
+    CHECK(abs(back - e6) <= 1 || abs(back - e6) == 360000000);
+  }
+  CHECK_EQ(degreesE6ToAngle(90000000), ANGLE_RIGHT);
+
+  // isqrt64 rounds down, also around perfect squares and at the top
+  std::mt19937_64 random(2);
+  for (int i = 0; i < 100000; i++) {
+    uint64_t value = random() >> (i % 40);
+    uint64_t root = isqrt64(value);
+    if (!CHECK(root * root <= value && (root + 1) * (root + 1) > value)) break;
+  }
+  CHECK_EQ(isqrt64(0), 0u);
+  CHECK_EQ(isqrt64(99), 9u);
+  CHECK_EQ(isqrt64(100), 10u);
+  CHECK_EQ(isqrt64(UINT64_MAX), 0xFFFFFFFFu);
+
+  double worst = 0;
+  for (int32_t s = -Q30_ONE; s <= Q30_ONE; s += 65521) {
+    worst = fmax(worst, fabs(angleToRadians(asinAngle(s)) - asin(s / (double)Q30_ONE)));
+  }
+  CHECK(worst <= 5e-8);
+}
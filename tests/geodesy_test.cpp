@@ -0,0 +1,147 @@
+// Geodesy.h against double precision spherical formulas on the same 6371 km
+// sphere: sweeps over latitude, bearing and leg length, plus random legs
+// around Hungary.
+
+#include <Arduino.h>
+#include <random>
+#include "test.h"
+#include "Geodesy.h"
+
+namespace {
+
+const double EARTH_RADIUS_M = 6371000.0;
+const double TURN = 4294967296.0;
+
+double radians(int32_t e6) {
+  return e6 * 1e-6 * M_PI / 180;
+}
+
+double haversineM(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2) {
+  double dLat = radians(lat2) - radians(lat1), dLon = radians(lon2) - radians(lon1);
+  double a = sin(dLat / 2) * sin(dLat / 2) + cos(radians(lat1)) * cos(radians(lat2)) * sin(dLon / 2) * sin(dLon / 2);
+  return EARTH_RADIUS_M * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+double bearingRad(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2) {
+  double dLon = radians(lon2) - radians(lon1);
+  return atan2(sin(dLon) * cos(radians(lat2)),
+               cos(radians(lat1)) * sin(radians(lat2)) - sin(radians(lat1)) * cos(radians(lat2)) * cos(dLon));
+}
+
+// Destination in double, rounded to microdegrees like the integer version
+GeoPoint destination(int32_t latE6, int32_t lonE6, double bearing, double distanceM) {
+  double lat = radians(latE6), arc = distanceM / EARTH_RADIUS_M;
+  double lat2 = asin(sin(lat) * cos(arc) + cos(lat) * sin(arc) * cos(bearing));
+  double dLon = atan2(sin(bearing) * sin(arc) * cos(lat), cos(arc) - sin(lat) * sin(lat2));
+  return { (int32_t)llround(lat2 * 180 / M_PI * 1e6), (int32_t)llround(lonE6 + dLon * 180 / M_PI * 1e6) };
+}
+
+// Accumulated worst cases over a set of legs
+struct GeoErrors {
+  double distanceM = 0;
+  double bearingDeg = 0;  // legs over 50 m
+  double roundTripM = 0;
+
+  void leg(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2) {
+    double reference = haversineM(lat1, lon1, lat2, lon2);
+    distanceM = fmax(distanceM, fabs(geoDistanceM(lat1, lon1, lat2, lon2) - reference));
+    if (reference > 50) {
+      double bearing = (double)geoBearing(lat1, lon1, lat2, lon2) * 2 * M_PI / TURN;
+      bearingDeg = fmax(bearingDeg, fabs(remainder(bearing - bearingRad(lat1, lon1, lat2, lon2), 2 * M_PI)) * 180 / M_PI);
+    }
+  }
+
+  void roundTrip(int32_t latE6, int32_t lonE6, int32_t bearing, uint32_t distanceM) {
+    GeoPoint to = geoDestination(latE6, lonE6, bearing, distanceM);
+    roundTripM = fmax(roundTripM, fabs(haversineM(latE6, lonE6, to.latE6, to.lonE6) - distanceM));
+  }
+};
+
+}  // namespace
+
+TEST(geodesy_distance_and_bearing_sweep) {
+  GeoErrors errors;
+
+  // Latitude -85..85, 50 bearings, legs from 1.4 m to 13700 km
+  for (int32_t lat = -85000000; lat <= 85000000; lat += 1700000) {
+    for (double bearing = 0.13; bearing < 2 * M_PI; bearing += 2 * M_PI / 50) {
+      for (double distance = 1.37; distance < 2e7; distance *= 10) {
+        GeoPoint to = destination(lat, 19100000, bearing, distance);
+        if (to.lonE6 > 180000000 || to.lonE6 < -180000000) continue;
+        errors.leg(lat, 19100000, to.latE6, to.lonE6);
+      }
+    }
+  }
+
+  printf("  max error distance %.3f m, bearing %.4f deg\n", errors.distanceM, errors.bearingDeg);
+  CHECK(errors.distanceM <= 0.74);
+  CHECK(errors.bearingDeg <= 0.036);
+}
+
+TEST(geodesy_random_legs_around_hungary) {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  GeoErrors errors;
+
+  for (int i = 0; i < 200000; i++) {
+    int32_t lat = (int32_t)(47.15e6 + unit(random) * 1.45e6), lon = (int32_t)(19.5e6 + unit(random) * 3.5e6);
+    double reach = i % 2 ? 2000 : (i % 3 ? 50000 : 5e6);  // microdegrees
+    errors.leg(lat, lon, lat + (int32_t)(unit(random) * reach / 111), lon + (int32_t)(unit(random) * reach / 111));
+    errors.roundTrip(lat, lon, (int32_t)random(), (uint32_t)(fabs(unit(random)) * (i % 2 ? 2000 : 200000)));
+  }
+
+  printf("  max error distance %.3f m, bearing %.4f deg, round trip %.3f m\n", errors.distanceM, errors.bearingDeg,
+         errors.roundTripM);
+  CHECK(errors.distanceM <= 0.74);
+  CHECK(errors.bearingDeg <= 0.036);
+  CHECK(errors.roundTripM <= 0.23);
+}
+
+TEST(geodesy_destination_round_trip_sweep) {
+  GeoErrors errors;
+
+  // Up to 85 degrees latitude, legs up to 2000 km, bearings all around
+  for (int32_t lat = -85000000; lat <= 85000000; lat += 770000) {
+    for (uint32_t step = 0; step < 41; step++) {
+      for (uint32_t distance = 1; distance <= 2000000; distance = distance * 3 + 7) {
+        errors.roundTrip(lat, 19100000, (int32_t)(step * 104755299u + 12345), distance);
+      }
+    }
+  }
+
+  printf("  max error round trip %.3f m\n", errors.roundTripM);
+  CHECK(errors.roundTripM <= 0.23);
+}
+
+TEST(geodesy_chord_test_agrees_with_haversine) {
+  std::mt19937 random(4);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  uint32_t disagreements = 0;
+  double worstMargin = 0;
+
+  // Fix/camera pairs worldwide, radii 150-1000 m, cameras spread around the
+  // radius and half of them within 2 m of it
+  for (int i = 0; i < 2000000; i++) {
+    int32_t lat = (int32_t)(unit(random) * 85e6), lon = (int32_t)(unit(random) * 179e6);
+    uint32_t radius = 150 + (uint32_t)(fabs(unit(random)) * 850);
+    double distance = radius + unit(random) * (i % 2 ? 2 : radius * 0.5);
+    GeoPoint camera = destination(lat, lon, unit(random) * M_PI, distance);
+
+    double reference = haversineM(lat, lon, camera.latE6, camera.lonE6);
+    bool within = geoChordSq(geoVector(lat, lon), geoVector(camera.latE6, camera.lonE6)) <= geoChordSqForMeters(radius);
+    if (within != (reference <= radius)) {
+      disagreements++;
+      worstMargin = fmax(worstMargin, fabs(reference - radius));
+    }
+  }
+
+  printf("  %u disagreements, all within %.3f m of the radius\n", disagreements, worstMargin);
+  CHECK(worstMargin <= 0.14);
+
+  // The threshold itself, in Q30 chord units: within the half chord's
+  // rounding up to 200 km, within CORDIC's sine error beyond
+  for (uint32_t meters : { 1u, 150u, 1000u, 199999u, 200000u, 200001u, 5000000u }) {
+    double chord = 2 * sin(meters / EARTH_RADIUS_M / 2) * Q30_ONE;
+    CHECK_NEAR(sqrt((double)geoChordSqForMeters(meters)), chord, meters <= 200000 ? 2.5 : 2 * 1.7e-8 * Q30_ONE + 2);
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the library and sketch
+// headers use. Time comes from a fake clock that only moves when a test (or
+// delay()) moves it, tone() / noTone() calls are recorded, pin calls are
+// no-ops (the drivers go through HostGpio, see BoardPolicy.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define SERIAL_8N1 0x800001c
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// One tone() (frequency > 0) or noTone() (frequency 0) call
+struct HostTone {
+  uint8_t pin;
+  unsigned int frequency;
+  uint32_t atMs;
+};
+
+namespace HostArduino {
+inline uint64_t clockUs = 0;
+inline std::vector<HostTone> tones;
+
+inline void advanceMs(uint32_t ms) {
+  clockUs += (uint64_t)ms * 1000;
+}
+
+inline void advanceUs(uint32_t us) {
+  clockUs += us;
+}
+
+// Clock back to 0 and the tone log cleared (main.cpp does this before every test)
+inline void reset() {
+  clockUs = 0;
+  tones.clear();
+}
+}
+
+// 32 bit like on the boards, so wrap-around behaves the same
+inline unsigned long millis() {
+  return (uint32_t)(HostArduino::clockUs / 1000);
+}
+
+inline unsigned long micros() {
+  return (uint32_t)HostArduino::clockUs;
+}
+
+inline void delay(unsigned long ms) {
+  HostArduino::advanceMs(ms);
+}
+
+inline void delayMicroseconds(unsigned int us) {
+  HostArduino::advanceUs(us);
+}
+
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+inline int digitalRead(uint8_t) {
+  return HIGH;
+}
+
+inline void analogWrite(uint8_t, int) {}
+
+inline void tone(uint8_t pin, unsigned int frequency, unsigned long = 0) {
+  HostArduino::tones.push_back({ pin, frequency, (uint32_t)millis() });
+}
+
+inline void noTone(uint8_t pin) {
+  HostArduino::tones.push_back({ pin, 0, (uint32_t)millis() });
+}
+
+#include "Stream.h"
+#include "HardwareSerial.h"
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Arduino.h"
+#include <deque>
+#include <functional>
+#include <stdarg.h>
+
+// Host stand-in for the ESP32 core's HardwareSerial. Bytes the code writes
+// are kept in sent(); bytes it reads come from what the test queued with
+// receive(). A responder, if set, runs on every flush() with the bytes
+// written since the previous flush, so a test can script a receiver's replies.
+// Ports register by UART number, since the drivers keep theirs private.
+
+typedef enum {
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+class HardwareSerial {
+private:
+  std::deque<uint8_t> rx;
+  std::vector<uint8_t> tx;
+  size_t flushed = 0;  // tx bytes already handed to the responder
+
+public:
+  std::function<void(HardwareSerial &port, const uint8_t *data, size_t length)> responder;
+
+  static HardwareSerial *&port(int uartNumber) {
+    static HardwareSerial *ports[3] = {};
+    return ports[uartNumber];
+  }
+
+  explicit HardwareSerial(int uartNumber) {
+    port(uartNumber) = this;
+  }
+
+  void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+
+  void end() {}
+
+  size_t setRxBufferSize(size_t size) {
+    return size;
+  }
+
+  void onReceive(std::function<void(void)>, bool = false) {}
+
+  void onReceiveError(std::function<void(hardwareSerial_error_t)>) {}
+
+  int available() {
+    return (int)rx.size();
+  }
+
+  int read() {
+    if (rx.empty()) return -1;
+    uint8_t c = rx.front();
+    rx.pop_front();
+    return c;
+  }
+
+  size_t read(uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && !rx.empty()) {
+      buffer[n++] = rx.front();
+      rx.pop_front();
+    }
+    return n;
+  }
+
+  size_t write(uint8_t c) {
+    tx.push_back(c);
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) {
+    tx.insert(tx.end(), buffer, buffer + size);
+    return size;
+  }
+
+  void flush() {
+    if (responder && flushed < tx.size()) {
+      size_t from = flushed;
+      flushed = tx.size();
+      responder(*this, tx.data() + from, tx.size() - from);
+    }
+  }
+
+  void print(const char *) {}
+
+  void println(const char * = "") {}
+
+  int printf(const char *, ...) {
+    return 0;
+  }
+
+  // ---------------------------------------------- Test side ----------------------------------------------
+
+  void receive(const uint8_t *data, size_t length) {
+    rx.insert(rx.end(), data, data + length);
+  }
+
+  void receive(const char *text) {
+    receive((const uint8_t *)text, strlen(text));
+  }
+
+  const std::vector<uint8_t> &sent() const {
+    return tx;
+  }
+
+  void clearSent() {
+    tx.clear();
+    flushed = 0;
+  }
+};
+
+inline HardwareSerial Serial(0);
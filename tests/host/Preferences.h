@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+
+// Host stand-in for the ESP32 NVS Preferences library. Every instance sees
+// the same in-memory store, which outlives the instances like NVS outlives a
+// reboot; erase() wipes it (a fresh chip).
+
+class Preferences {
+private:
+  typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+  Namespace *space = nullptr;
+
+  static std::map<std::string, Namespace> &store() {
+    static std::map<std::string, Namespace> instance;
+    return instance;
+  }
+
+public:
+  static void erase() {
+    store().clear();
+  }
+
+  bool begin(const char *name, bool = false) {
+    space = &store()[name];
+    return true;
+  }
+
+  void end() {
+    space = nullptr;
+  }
+
+  size_t putBytes(const char *key, const void *value, size_t length) {
+    if (space == nullptr) return 0;
+    const uint8_t *bytes = (const uint8_t *)value;
+    (*space)[key].assign(bytes, bytes + length);
+    return length;
+  }
+
+  size_t getBytesLength(const char *key) {
+    if (space == nullptr || space->count(key) == 0) return 0;
+    return (*space)[key].size();
+  }
+
+  size_t getBytes(const char *key, void *buffer, size_t maxLength) {
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > maxLength) return 0;
+    memcpy(buffer, (*space)[key].data(), length);
+    return length;
+  }
+
+  bool clear() {
+    if (space == nullptr) return false;
+    space->clear();
+    return true;
+  }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Arduino.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+
+// Host stand-in for Stream, as a text console: what a test queued with
+// type() is read back byte by byte, everything printed collects in
+// printed(). HardwareSerial keeps its own byte-level stand-in.
+
+class Stream {
+private:
+  std::string input;
+  size_t readAt = 0;
+  std::string output;
+
+public:
+  int available() {
+    return (int)(input.size() - readAt);
+  }
+
+  int read() {
+    return readAt < input.size() ? (uint8_t)input[readAt++] : -1;
+  }
+
+  void print(const char *text) {
+    output += text;
+  }
+
+  void println(const char *text = "") {
+    output += text;
+    output += "\r\n";
+  }
+
+  int printf(const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    output += buffer;
+    return length;
+  }
+
+  // ---------------------------------------------- Test side ----------------------------------------------
+
+  void type(const char *text) {
+    input += text;
+  }
+
+  const std::string &printed() const {
+    return output;
+  }
+
+  void clearPrinted() {
+    output.clear();
+  }
+};
@@ -0,0 +1,4 @@
+#pragma once
+
+// Better-GPS.h includes the sketch's constants.h, which is not checked in;
+// nothing the host tests reach depends on it.
@@ -0,0 +1,121 @@
+// Hungarian time zone: every hour from 2010 to 2110 (the DST table's
+// 2020-2100 and the runtime fallback on both sides) against a reference
+// built on the C library's calendar and the original field-by-field DST rule.
+
+#include <Arduino.h>
+#include <time.h>
+#include "test.h"
+#include "Better-GPS.h"
+
+namespace {
+
+// Zeller's congruence as the sketch used it; h = 0 is Saturday
+int zeller(int y, int m, int d) {
+  if (m < 3) {
+    m += 12;
+    y -= 1;
+  }
+  int k = y % 100;
+  int j = y / 100;
+  return (d + 13 * (m + 1) / 5 + k + k / 4 + j / 4 + 5 * j) % 7;
+}
+
+// Zeller to 0 = Sunday: the correct mapping, and the one the sketch had
+int weekdayFixed(int y, int m, int d) {
+  return (zeller(y, m, d) + 6) % 7;
+}
+
+int weekdayOld(int y, int m, int d) {
+  return (zeller(y, m, d) + 1) % 7;
+}
+
+// The original rule: CEST from 01:00 UTC on the last Sunday of March to
+// 01:00 UTC on the last Sunday of October
+bool referenceDst(int year, int month, int day, int hour, int (*weekday)(int, int, int)) {
+  if (month < 3 || month > 10) return false;
+  if (month > 3 && month < 10) return true;
+
+  int lastSunday = 31;
+  while (weekday(year, month, lastSunday) != 0) lastSunday--;
+
+  if (month == 3) return day > lastSunday || (day == lastSunday && hour >= 1);
+  return day < lastSunday || (day == lastSunday && hour < 1);
+}
+
+struct tm utcFields(int64_t seconds) {
+  time_t t = (time_t)seconds;
+  struct tm fields;
+  gmtime_r(&t, &fields);
+  return fields;
+}
+
+}  // namespace
+
+TEST(hungarian_time_every_hour_matches_the_reference) {
+  static_assert(sizeof(time_t) >= 8, "needs a 64 bit time_t for years past 2038");
+  const int64_t first = HungarianTime::toEpochSeconds(2010, 1, 1, 0, 0, 0);
+  const int64_t last = HungarianTime::toEpochSeconds(2110, 12, 31, 23, 0, 0);
+  uint32_t hours = 0, offsetMismatches = 0, calendarMismatches = 0, weekdayMismatches = 0, oldRuleWrong = 0;
+  int oldRuleFirstWrongYear = 0;
+
+  for (int64_t utc = first; utc <= last; utc += 3600) {
+    struct tm u = utcFields(utc);
+    int year = u.tm_year + 1900, month = u.tm_mon + 1;
+    hours++;
+
+    if (u.tm_hour == 0 && weekdayFixed(year, month, u.tm_mday) != u.tm_wday) weekdayMismatches++;
+
+    bool dst = referenceDst(year, month, u.tm_mday, u.tm_hour, weekdayFixed);
+    int32_t offset = HungarianTime::utcOffsetSeconds(year, utc);
+    if (offset != (dst ? 7200 : 3600)) {
+      if (offsetMismatches++ < 5) printf("    offset %d at %04d-%02d-%02d %02d:00 UTC\n", offset, year, month, u.tm_mday, u.tm_hour);
+    }
+    if (referenceDst(year, month, u.tm_mday, u.tm_hour, weekdayOld) != dst) {
+      if (oldRuleWrong++ == 0) oldRuleFirstWrongYear = year;
+    }
+
+    // Local calendar fields and weekday the way BetterGPS derives them
+    int64_t local = utc + offset;
+    int32_t days = HungarianTime::floorDiv(local, 86400);
+    int y, m, d;
+    HungarianTime::civilFromDays(days, y, m, d);
+    struct tm l = utcFields(local);
+    if (y != l.tm_year + 1900 || m != l.tm_mon + 1 || d != l.tm_mday || HungarianTime::dayOfWeek(days) != l.tm_wday
+        || HungarianTime::daysFromCivil(y, m, d) != days) {
+      calendarMismatches++;
+    }
+  }
+
+  CHECK_EQ(hours, (uint32_t)((last - first) / 3600 + 1));
+  CHECK_EQ(weekdayMismatches, 0u);
+  CHECK_EQ(offsetMismatches, 0u);
+  CHECK_EQ(calendarMismatches, 0u);
+
+  // The old (f + 1) % 7 mapping finds the wrong Sunday: it is off in most years
+  CHECK(oldRuleWrong > 0);
+  CHECK_EQ(oldRuleFirstWrongYear, 2010);
+}
+
+TEST(hungarian_time_transition_edges) {
+  using namespace HungarianTime;
+
+  // 2024: last Sundays are March 31 and October 27
+  int64_t start = toEpochSeconds(2024, 3, 31, 1, 0, 0);
+  int64_t end = toEpochSeconds(2024, 10, 27, 1, 0, 0);
+  CHECK_EQ(utcOffsetSeconds(2024, start - 1), 3600);
+  CHECK_EQ(utcOffsetSeconds(2024, start), 7200);
+  CHECK_EQ(utcOffsetSeconds(2024, end - 1), 7200);
+  CHECK_EQ(utcOffsetSeconds(2024, end), 3600);
+  CHECK_EQ(lastSundayTransition(2024, 3), start);
+  CHECK_EQ(lastSundayTransition(2024, 10), end);
+
+  // Table rows and the runtime fallback agree at both ends of the table
+  for (int year : { FIRST_YEAR, LAST_YEAR }) {
+    CHECK_EQ((int64_t)DST_TABLE.start[year - FIRST_YEAR], lastSundayTransition(year, 3));
+    CHECK_EQ((int64_t)DST_TABLE.end[year - FIRST_YEAR], lastSundayTransition(year, 10));
+  }
+
+  // Weekday before 1970 (negative day numbers)
+  CHECK_EQ(dayOfWeek(daysFromCivil(1969, 12, 31)), 3);
+  CHECK_EQ(dayOfWeek(daysFromCivil(1969, 12, 28)), 0);
+}
@@ -0,0 +1,31 @@
+#include <Arduino.h>
+#include <string.h>
+#include "board.h"
+#include "test.h"
+
+int main(int argc, char **argv) {
+  const char *filter = argc > 1 ? argv[1] : nullptr;
+  unsigned run = 0, failed = 0;
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  for (TestCase *test = TestRegistry::first; test != nullptr; test = test->next) {
+    if (filter != nullptr && strstr(test->name, filter) == nullptr) continue;
+
+    // Every case starts at t = 0 with empty tone / GPIO logs
+    HostArduino::reset();
+    HostGpio::clear();
+    HostGpio::log().levels = 0;
+    TestRegistry::failures = 0;
+
+    printf("%s\n", test->name);
+    test->run();
+    run++;
+    if (TestRegistry::failures > 0) {
+      printf("  FAILED\n");
+      failed++;
+    }
+  }
+
+  printf("%s: %u of %u tests passed\n", TEST_BOARD_NAME, run - failed, run);
+  return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// NmeaParser on hand-written sentences: RMC and GGA field mapping, southern
+// and western hemispheres, GGA altitude with the geoid separation, bad,
+// missing and truncated checksums with the stats counters, skipped
+// sentences, and an RMC with status V clearing the fix.
+
+#include <string>
+#include "test.h"
+#include "NmeaParser.h"
+
+namespace {
+
+std::string sentence(const char *body) {
+  uint8_t checksum = 0;
+  for (const char *c = body; *c != '\0'; c++) checksum ^= (uint8_t)*c;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  return std::string("$") + body + tail;
+}
+
+// Every byte through encode(), the result bits of all of them
+uint8_t feed(NmeaParser &parser, const std::string &bytes) {
+  uint8_t updated = 0;
+  for (char c : bytes) updated |= parser.encode(c);
+  return updated;
+}
+
+const char *const RMC = "GNRMC,102030.45,A,4729.87472,N,01902.41410,E,27.000,90.00,150624,,,A,V";
+const char *const GGA = "GNGGA,102030.00,4729.87472,N,01902.41410,E,1,12,0.71,120.5,M,40.2,M,,";
+
+}  // namespace
+
+TEST(nmea_rmc_fields) {
+  NmeaParser parser;
+  CHECK_EQ(feed(parser, sentence(RMC)), NMEA_TIME_UPDATED | NMEA_LOCATION_UPDATED | NMEA_DATE_UPDATED);
+
+  const NmeaData &data = parser.getData();
+  CHECK_EQ(data.latE6, 47497912);  // 47 + 29.87472 / 60
+  CHECK_EQ(data.lonE6, 19040235);  // 19 + 2.41410 / 60
+  CHECK_EQ(data.speedCentiKnots, 2700u);
+  CHECK_EQ(data.courseCentiDeg, 9000);
+  CHECK(data.courseValid);
+  CHECK(data.locationValid);
+  CHECK_EQ(data.time, 10203045u);
+  CHECK_EQ(data.hour(), 10);
+  CHECK_EQ(data.minute(), 20);
+  CHECK_EQ(data.second(), 30);
+  CHECK_EQ(data.centisecond(), 45);
+  CHECK_EQ(data.date, 150624u);
+  CHECK_EQ(data.year(), 2024);
+  CHECK_EQ(data.month(), 6);
+  CHECK_EQ(data.day(), 15);
+  CHECK_EQ(parser.getStats().sentences, 1u);
+}
+
+TEST(nmea_southern_and_western_hemispheres) {
+  NmeaParser parser;
+  feed(parser, sentence("GPRMC,235959.00,A,3351.12345,S,15112.54321,W,0.512,,311299,,,A"));
+
+  const NmeaData &data = parser.getData();
+  CHECK_EQ(data.latE6, -33852058);
+  CHECK_EQ(data.lonE6, -151209054);
+  CHECK_EQ(data.speedCentiKnots, 51u);
+  CHECK(!data.courseValid);  // empty course while stationary
+  CHECK_EQ(data.year(), 2099);
+
+  // GGA south-west too, west of Greenwich by less than a degree
+  feed(parser, sentence("GPGGA,000001.00,0030.00000,S,00015.00000,W,1,08,1.0,5.0,M,0.0,M,,"));
+  CHECK_EQ(data.latE6, -500000);
+  CHECK_EQ(data.lonE6, -250000);
+}
+
+TEST(nmea_gga_altitude_adds_the_geoid_separation) {
+  NmeaParser parser;
+  CHECK_EQ(feed(parser, sentence(GGA)), NMEA_TIME_UPDATED | NMEA_LOCATION_UPDATED);
+
+  const NmeaData &data = parser.getData();
+  CHECK_EQ(data.latE6, 47497912);
+  CHECK_EQ(data.lonE6, 19040235);
+  CHECK_EQ(data.altitudeDm, 1205 + 402);
+  CHECK_EQ(data.time, 10203000u);
+  CHECK(!data.dateValid);  // GGA carries no date
+  CHECK_EQ(data.speedCentiKnots, 0u);
+
+  // Below the geoid and a negative separation; GGA leaves the RMC speed alone
+  feed(parser, sentence(RMC));
+  feed(parser, sentence("GNGGA,102031.00,4729.87472,N,01902.41410,E,2,12,0.71,-12.3,M,-3.4,M,,"));
+  CHECK_EQ(data.altitudeDm, -123 - 34);
+  CHECK_EQ(data.speedCentiKnots, 2700u);
+
+  // Quality 0: no fix
+  CHECK_EQ(feed(parser, sentence("GNGGA,102032.00,,,,,0,00,99.99,,,,,,")), NMEA_TIME_UPDATED | NMEA_LOCATION_UPDATED);
+  CHECK(!data.locationValid);
+  CHECK_EQ(data.altitudeDm, -157);
+}
+
+TEST(nmea_checksum_errors_are_counted_and_dropped) {
+  NmeaParser parser;
+  std::string good = sentence(RMC);
+
+  // Wrong checksum
+  std::string bad = good;
+  bad[bad.size() - 3] = bad[bad.size() - 3] == '0' ? '1' : '0';
+  CHECK_EQ(feed(parser, bad), 0);
+
+  // No checksum at all
+  CHECK_EQ(feed(parser, std::string("$") + RMC + "\r\n"), 0);
+
+  // Not hex
+  CHECK_EQ(feed(parser, good.substr(0, good.size() - 4) + "*G0\r\n"), 0);
+
+  // Cut short by the next sentence: in a field, and between the two checksum digits
+  CHECK_EQ(feed(parser, good.substr(0, 30)), 0);
+  CHECK_EQ(feed(parser, good.substr(0, good.size() - 3)), 0);
+
+  const NmeaData &data = parser.getData();
+  CHECK(!data.locationValid);
+  CHECK(!data.timeValid);
+  CHECK_EQ(parser.getStats().checksumErrors, 4u);
+  CHECK_EQ(parser.getStats().sentences, 0u);
+
+  // The sentence that cut the last one short still decodes
+  CHECK_EQ(feed(parser, good), NMEA_TIME_UPDATED | NMEA_LOCATION_UPDATED | NMEA_DATE_UPDATED);
+  CHECK_EQ(parser.getStats().checksumErrors, 5u);
+  CHECK_EQ(parser.getStats().sentences, 1u);
+  CHECK(data.locationValid);
+
+  // Lower case hex digits are accepted
+  std::string lower = sentence(GGA);
+  for (char &c : lower) {
+    if (c >= 'A' && c <= 'F' && &c > &lower[lower.size() - 5]) c = c - 'A' + 'a';
+  }
+  CHECK(feed(parser, lower) & NMEA_LOCATION_UPDATED);
+  CHECK_EQ(parser.getStats().sentences, 2u);
+}
+
+TEST(nmea_unknown_sentences_are_skipped) {
+  NmeaParser parser;
+  std::string stream = sentence("GNVTG,90.00,T,,M,27.000,N,50.004,K,A") +
+                       sentence("GNGSA,A,3,02,05,13,15,18,20,23,24,29,,,,1.21,0.71,0.98,1") +
+                       sentence("GPGSV,3,1,10,02,41,280,38,05,22,047,31,13,67,110,42,15,70,226,44,1") +
+                       sentence("PUBX,00,102030.00,4729.87472,N,01902.41410,E") +  // short address
+                       sentence("GPRMCX,102030.45,A,4729.87472,N,01902.41410,E") +  // long address
+                       sentence("GPTXT,01,01,02,ANTSTATUS=OK") + "garbage between sentences\r\n";
+
+  CHECK_EQ(feed(parser, stream), 0);
+  CHECK_EQ(parser.getStats().skipped, 6u);
+  CHECK_EQ(parser.getStats().sentences, 0u);
+  CHECK_EQ(parser.getStats().checksumErrors, 0u);
+  CHECK(!parser.getData().timeValid);
+
+  // An RMC among them
+  CHECK(feed(parser, sentence("GPGSV,3,3,10,29,55,157,43,30,06,022,,1") + sentence(RMC)) & NMEA_LOCATION_UPDATED);
+  CHECK_EQ(parser.getStats().skipped, 7u);
+  CHECK_EQ(parser.getStats().sentences, 1u);
+  CHECK_EQ(parser.getData().latE6, 47497912);
+}
+
+TEST(nmea_status_v_clears_the_fix) {
+  NmeaParser parser;
+  feed(parser, sentence(RMC));
+  const NmeaData &data = parser.getData();
+  CHECK(data.locationValid);
+
+  // Status V with the last position still in it: the fix is gone, the position kept
+  const char *LOST = "GNRMC,102031.45,V,4730.00000,N,01903.00000,E,0.000,,150624,,,N,V";
+  CHECK_EQ(feed(parser, sentence(LOST)), NMEA_TIME_UPDATED | NMEA_LOCATION_UPDATED | NMEA_DATE_UPDATED);
+  CHECK(!data.locationValid);
+  CHECK_EQ(data.latE6, 47497912);
+  CHECK_EQ(data.lonE6, 19040235);
+  CHECK_EQ(data.time, 10203145u);
+
+  // Still V: nothing new about the location
+  CHECK_EQ(feed(parser, sentence(LOST)), NMEA_TIME_UPDATED | NMEA_DATE_UPDATED);
+
+  // Back to A
+  CHECK(feed(parser, sentence(RMC)) & NMEA_LOCATION_UPDATED);
+  CHECK(data.locationValid);
+}
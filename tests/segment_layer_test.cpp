@@ -0,0 +1,62 @@
+// SegmentLayer's integer point-to-segment distance against the same flat
+// earth formula in double, and the nearest-segment pick in limitAt().
+
+#include <Arduino.h>
+#include <random>
+#include "test.h"
+#include "SegmentLayer.h"
+
+namespace {
+
+typedef SegmentLayer<1, 1> OneSegment;
+
+// The flat earth distance in double, with the exact cosine
+double referenceM(const SegmentLine &line, int32_t latE6, int32_t lonE6) {
+  double scale = GRID_METERS_PER_DEGREE * 1e-6, cosLat = cos(latE6 * 1e-6 * M_PI / 180.0);
+  double ax = (line.lon1E6 - lonE6) * scale * cosLat, ay = (line.lat1E6 - latE6) * scale;
+  double bx = (line.lon2E6 - lonE6) * scale * cosLat, by = (line.lat2E6 - latE6) * scale;
+  double dx = bx - ax, dy = by - ay;
+  double lengthSq = dx * dx + dy * dy;
+
+  double t = lengthSq > 0 ? -(ax * dx + ay * dy) / lengthSq : 0;
+  t = t < 0 ? 0 : t > 1 ? 1 : t;
+  return hypot(ax + t * dx, ay + t * dy);
+}
+
+constexpr RoadSegment ROADS[] = {
+  { 47.5000, 19.0000, 47.5000, 19.0040, 50 },  // east-west, 300 m
+  { 47.5010, 19.0000, 47.5010, 19.0040, 90 },  // parallel, 111 m north
+  { 47.4900, 19.0100, 47.4930, 19.0100, 0 },   // placeholder, never matched
+};
+constexpr auto ROAD_LAYER = buildSegmentLayer<segmentIndexSize(ROADS)>(ROADS);
+
+}  // namespace
+
+TEST(segment_layer_distance_matches_double) {
+  std::mt19937 random(5);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  double worst = 0;
+
+  // Segments up to ~600 m, points up to ~600 m away, across the latitudes in use
+  for (int i = 0; i < 200000; i++) {
+    int32_t latE6 = (int32_t)(46e6 + fabs(unit(random)) * 2.6e6), lonE6 = (int32_t)(19e6 + unit(random) * 3e6);
+    SegmentLine line = { latE6 + (int32_t)(unit(random) * 4000), lonE6 + (int32_t)(unit(random) * 6000),
+                         latE6 + (int32_t)(unit(random) * 4000), lonE6 + (int32_t)(unit(random) * 6000), 50 };
+    if (i % 10 == 0) line.lat2E6 = line.lat1E6, line.lon2E6 = line.lon1E6;  // zero length
+
+    int32_t cosLat = sinCos(degreesE6ToAngle(latE6)).cos;
+    worst = fmax(worst, fabs(OneSegment::distanceCm(line, latE6, lonE6, cosLat) / 100.0 - referenceM(line, latE6, lonE6)));
+  }
+
+  printf("  max error %.3f m\n", worst);
+  CHECK(worst <= 0.03);
+}
+
+TEST(segment_layer_picks_the_nearest_segment) {
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.5002), toE6(19.0020), 30), 50);  // 22 m from the first
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.5007), toE6(19.0020), 60), 90);  // 33 m from the second
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.5005), toE6(19.0020), 20), 0);   // 56 m from both
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.5000), toE6(19.0050), 70), 0);   // 75 m past the end
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.5000), toE6(19.0050), 80), 50);
+  CHECK_EQ(ROAD_LAYER.limitAt(toE6(47.4915), toE6(19.0100), 50), 0);   // only the placeholder
+}
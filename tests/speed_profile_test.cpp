@@ -0,0 +1,219 @@
+// SpeedProfileStore: every serial command, malformed ones (too many numbers,
+// trailing junk, out of range), the profile surviving a reboot in the
+// Preferences stand-in, and the flat table the sketch's applySpeedProfile()
+// and currentSpeedLimit() read.
+
+#include <Arduino.h>
+#include <string>
+#include "test.h"
+#include "SpeedProfile.h"
+
+namespace {
+
+bool sameProfile(const SpeedProfile &a, const SpeedProfile &b) {
+  return memcmp(&a, &b, sizeof(SpeedProfile)) == 0;
+}
+
+// One command line through poll(); returns whether it changed the profile
+bool command(SpeedProfileStore &store, Stream &console, const char *line) {
+  console.clearPrinted();
+  console.type(line);
+  console.type("\n");
+  return store.poll(console);
+}
+
+bool printedHas(const Stream &console, const char *text) {
+  if (console.printed().find(text) != std::string::npos) return true;
+  printf("    printed: %s\n", console.printed().c_str());
+  return false;
+}
+
+// The profile as stored in NVS, false if there is none of the right size
+bool storedProfile(SpeedProfile &profile) {
+  Preferences prefs;
+  prefs.begin("speed", true);
+  return prefs.getBytes("profile", &profile, sizeof(profile)) == sizeof(profile);
+}
+
+}  // namespace
+
+TEST(speed_profile_defaults_on_a_fresh_chip) {
+  Preferences::erase();
+  SpeedProfileStore store;
+  store.begin();
+  CHECK(sameProfile(store.get(), DEFAULT_SPEED_PROFILE));
+
+  SpeedProfile stored;
+  CHECK(!storedProfile(stored));  // nothing written until a command changes something
+}
+
+TEST(speed_profile_commands) {
+  Preferences::erase();
+  SpeedProfileStore store;
+  store.begin();
+  Stream console;
+
+  CHECK(command(store, console, "limits 0 40 60 80"));
+  CHECK(printedHas(console, "ok\r\nlimits 0 40 60 80\nbands 5 15\nbeeps 400 150 50\n"));
+  CHECK_EQ(store.get().limitCount, 4);
+  CHECK_EQ(store.get().limitsKmh[3], 80);
+
+  CHECK(command(store, console, "bands 3 10"));
+  CHECK_EQ(store.get().slowBandKmh, 3);
+  CHECK_EQ(store.get().mediumBandKmh, 10);
+
+  CHECK(command(store, console, "beeps 500 200 80"));
+  CHECK_EQ(store.get().slowGapMs, 500);
+  CHECK_EQ(store.get().mediumGapMs, 200);
+  CHECK_EQ(store.get().fastGapMs, 80);
+
+  // Show prints without changing anything
+  CHECK(!command(store, console, "show"));
+  CHECK(console.printed() == "limits 0 40 60 80\nbands 3 10\nbeeps 500 200 80\n");
+
+  // Exactly eight limits, commas allowed, values clamped to their ranges
+  CHECK(command(store, console, "limits 0,30,50 70 90 110 130 300"));
+  CHECK_EQ(store.get().limitCount, 8);
+  CHECK_EQ(store.get().limitsKmh[7], 250);
+  CHECK(command(store, console, "beeps 9000 -1 0"));
+  CHECK_EQ(store.get().slowGapMs, 5000);
+  CHECK_EQ(store.get().mediumGapMs, 0);
+
+  // Every change is saved
+  SpeedProfile stored;
+  CHECK(storedProfile(stored));
+  CHECK(sameProfile(stored, store.get()));
+
+  CHECK(command(store, console, "defaults"));
+  CHECK(sameProfile(store.get(), DEFAULT_SPEED_PROFILE));
+  CHECK(storedProfile(stored));
+  CHECK(sameProfile(stored, DEFAULT_SPEED_PROFILE));
+}
+
+TEST(speed_profile_rejects_malformed_commands) {
+  Preferences::erase();
+  SpeedProfileStore store;
+  store.begin();
+  Stream console;
+  CHECK(command(store, console, "limits 0 50 90"));
+  SpeedProfile before = store.get();
+
+  const char *const BAD[] = {
+    "limits 10 20 30 40 50 60 70 80 90",  // nine limits
+    "limits 0 50 90x",                      // trailing junk on a number
+    "bands 5 15 fast",                      // trailing word
+    "beeps 400 150 50 25",                  // one too many
+    "bands 5",                              // one too few
+    "limits",                               // none
+    "limits fifty",
+    "speed 50",                             // unknown command
+  };
+  for (const char *line : BAD) {
+    if (!CHECK(!command(store, console, line))) printf("    accepted: %s\n", line);
+    CHECK(printedHas(console, "error: show | limits"));
+  }
+
+  // Well formed but not a valid profile: slow band above medium
+  CHECK(!command(store, console, "bands 20 10"));
+  CHECK(printedHas(console, "error: invalid profile"));
+
+  CHECK(sameProfile(store.get(), before));
+  SpeedProfile stored;
+  CHECK(storedProfile(stored));
+  CHECK(sameProfile(stored, before));
+}
+
+TEST(speed_profile_lines_split_across_polls) {
+  Preferences::erase();
+  SpeedProfileStore store;
+  store.begin();
+  Stream console;
+
+  // Half a line, then the rest with a second command and CR LF endings
+  console.type("limits 0 6");
+  CHECK(!store.poll(console));
+  CHECK_EQ(store.get().limitCount, DEFAULT_SPEED_PROFILE.limitCount);
+  console.type("0 100\r\n\r\nbands 2 4\r\n");
+  CHECK(store.poll(console));
+  CHECK_EQ(store.get().limitCount, 3);
+  CHECK_EQ(store.get().limitsKmh[1], 60);
+  CHECK_EQ(store.get().mediumBandKmh, 4);
+
+  // A line longer than the buffer is cut, and the cut line is rejected
+  std::string longLine = "limits";
+  while (longLine.size() < 80) longLine += " 1";
+  CHECK(!command(store, console, longLine.c_str()));
+  CHECK_EQ(store.get().limitCount, 3);
+}
+
+TEST(speed_profile_reloads_from_nvs) {
+  Preferences::erase();
+  {
+    SpeedProfileStore store;
+    store.begin();
+    Stream console;
+    CHECK(command(store, console, "limits 0 30 50"));
+    CHECK(command(store, console, "bands 4 12"));
+  }
+
+  // Reboot: a new store reads what the last one saved
+  SpeedProfileStore rebooted;
+  rebooted.begin();
+  CHECK_EQ(rebooted.get().limitCount, 3);
+  CHECK_EQ(rebooted.get().limitsKmh[2], 50);
+  CHECK_EQ(rebooted.get().slowBandKmh, 4);
+  CHECK_EQ(rebooted.get().mediumBandKmh, 12);
+
+  // A profile of another layout version, a truncated one, or an invalid one loads the defaults
+  Preferences prefs;
+  prefs.begin("speed");
+  SpeedProfile old = rebooted.get();
+  old.version = SPEED_PROFILE_VERSION + 1;
+  SpeedProfile empty = rebooted.get();
+  empty.limitCount = 0;
+
+  prefs.putBytes("profile", &old, sizeof(old));
+  SpeedProfileStore afterUpgrade;
+  afterUpgrade.begin();
+  CHECK(sameProfile(afterUpgrade.get(), DEFAULT_SPEED_PROFILE));
+
+  prefs.putBytes("profile", &empty, sizeof(empty));
+  SpeedProfileStore afterCorruption;
+  afterCorruption.begin();
+  CHECK(sameProfile(afterCorruption.get(), DEFAULT_SPEED_PROFILE));
+
+  prefs.putBytes("profile", &empty, sizeof(empty) - 2);
+  SpeedProfileStore afterTruncation;
+  afterTruncation.begin();
+  CHECK(sameProfile(afterTruncation.get(), DEFAULT_SPEED_PROFILE));
+}
+
+TEST(speed_profile_flat_table_for_the_sketch) {
+  Preferences::erase();
+  SpeedProfileStore store;
+  store.begin();
+  Stream console;
+  CHECK(command(store, console, "limits 0 50 70 90 110 130 30 40"));
+  CHECK(command(store, console, "limits 0 60 80"));
+
+  // applySpeedProfile() and currentSpeedLimit() read the struct directly:
+  // the button index runs over limitsKmh[0 .. limitCount), bands and gaps as set
+  const SpeedProfile &profile = store.get();
+  CHECK_EQ(profile.version, SPEED_PROFILE_VERSION);
+  CHECK_EQ(profile.limitCount, 3);
+  const uint8_t EXPECTED[] = { 0, 60, 80 };
+  for (uint8_t i = 0; i < profile.limitCount; i++) CHECK_EQ(profile.limitsKmh[i], EXPECTED[i]);
+  CHECK_EQ(profile.slowBandKmh, DEFAULT_SPEED_PROFILE.slowBandKmh);
+  CHECK_EQ(profile.mediumBandKmh, DEFAULT_SPEED_PROFILE.mediumBandKmh);
+  CHECK_EQ(profile.slowGapMs, DEFAULT_SPEED_PROFILE.slowGapMs);
+  CHECK_EQ(profile.mediumGapMs, DEFAULT_SPEED_PROFILE.mediumGapMs);
+  CHECK_EQ(profile.fastGapMs, DEFAULT_SPEED_PROFILE.fastGapMs);
+
+  // The reference stays valid across commands, and a selection past the new count wraps to 0 there
+  uint8_t speedLimitIndex = 5;
+  CHECK(command(store, console, "limits 0 40"));
+  if (speedLimitIndex >= profile.limitCount) speedLimitIndex = 0;
+  CHECK_EQ(profile.limitsKmh[speedLimitIndex], 0);
+  CHECK_EQ(profile.limitsKmh[1], 40);
+  CHECK_EQ(sizeof(SpeedProfile), 18u);  // the stored layout, SPEED_PROFILE_VERSION 1
+}
@@ -0,0 +1,146 @@
+// SpscRing under contention: a producer and a consumer thread, as the UART
+// capture callback and loop() use it in Better-GPS.h.
+
+#include <Arduino.h>
+#include <thread>
+#include "test.h"
+#include "SpscRing.h"
+
+namespace {
+
+// Byte n of the stream; the multiplier makes a skipped or repeated byte show
+// up within one period instead of after 256
+uint8_t numbered(uint64_t n) {
+  return (uint8_t)(n * 131 + (n >> 8));
+}
+
+}  // namespace
+
+TEST(spsc_ring_bursts_arrive_complete_and_in_order) {
+  static SpscRing<uint8_t, 4096> ring;
+  const uint64_t COUNT = 4000000;
+  uint64_t received = 0, mismatches = 0;
+
+  // Producer only pushes what fits, so nothing may be dropped
+  std::thread producer([COUNT] {
+    uint8_t chunk[97];
+    for (uint64_t sent = 0; sent < COUNT;) {
+      size_t want = 1 + (sent * 7919) % sizeof(chunk);
+      if (want > COUNT - sent) want = COUNT - sent;
+      size_t space = ring.space();
+      if (space == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (want > space) want = space;
+      for (size_t i = 0; i < want; i++) chunk[i] = numbered(sent + i);
+      sent += ring.pushBurst(chunk, want);
+    }
+  });
+
+  uint8_t batch[64];
+  while (received < COUNT) {
+    size_t n = ring.popBatch(batch, 1 + received % sizeof(batch));
+    if (n == 0) std::this_thread::yield();
+    for (size_t i = 0; i < n; i++) {
+      if (batch[i] != numbered(received + i)) mismatches++;
+    }
+    received += n;
+  }
+  producer.join();
+
+  CHECK_EQ(received, COUNT);
+  CHECK_EQ(mismatches, 0u);
+  CHECK_EQ(ring.getDroppedCount(), 0u);
+  CHECK(ring.getHighWater() <= ring.capacity());
+  CHECK(ring.isEmpty());
+}
+
+TEST(spsc_ring_single_items_arrive_in_order) {
+  static SpscRing<uint32_t, 16> ring;
+  const uint32_t COUNT = 1000000;
+  uint32_t next = 0, mismatches = 0;
+
+  std::thread producer([COUNT] {
+    for (uint32_t i = 0; i < COUNT;) {
+      if (ring.space() > 0 && ring.push(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t value;
+  while (next < COUNT) {
+    if (!ring.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (value != next) mismatches++;
+    next++;
+  }
+  producer.join();
+
+  CHECK_EQ(mismatches, 0u);
+  CHECK_EQ(ring.getDroppedCount(), 0u);
+}
+
+TEST(spsc_ring_counts_overflow_under_contention) {
+  static SpscRing<uint32_t, 64> ring;
+  const uint32_t COUNT = 1000000;
+  std::atomic<bool> finished(false);
+  uint64_t stored = 0;
+
+  // Producer ignores the fill level like an ISR would; the consumer drains
+  // slower, so bursts overflow. The stored part of a burst is its head.
+  std::thread producer([&] {
+    uint32_t burst[48];
+    for (uint32_t sent = 0; sent < COUNT; sent += sizeof(burst) / sizeof(burst[0])) {
+      for (uint32_t i = 0; i < sizeof(burst) / sizeof(burst[0]); i++) burst[i] = sent + i;
+      stored += ring.pushBurst(burst, sizeof(burst) / sizeof(burst[0]));
+    }
+    finished = true;
+  });
+
+  uint64_t received = 0, outOfOrder = 0;
+  uint32_t value, last = 0;
+  for (;;) {
+    bool done = finished;
+    if (!ring.pop(value)) {
+      if (done) break;
+      std::this_thread::yield();
+      continue;
+    }
+    if (received > 0 && value <= last) outOfOrder++;
+    last = value;
+    if (++received % 16 == 0) std::this_thread::yield();
+  }
+  producer.join();
+
+  uint32_t sent = (COUNT + 47) / 48 * 48;
+  CHECK_EQ(received, stored);
+  CHECK_EQ(outOfOrder, 0u);
+  CHECK_EQ(received + ring.getDroppedCount(), (uint64_t)sent);
+  CHECK(ring.getDroppedCount() > 0);
+  CHECK_EQ(ring.getHighWater(), 64u);
+}
+
+TEST(spsc_ring_full_ring_drops_and_counts) {
+  SpscRing<uint8_t, 16> ring;
+  uint8_t bytes[40];
+  for (uint8_t i = 0; i < sizeof(bytes); i++) bytes[i] = i;
+
+  CHECK_EQ(ring.pushBurst(bytes, sizeof(bytes)), 16u);
+  CHECK_EQ(ring.getDroppedCount(), 24u);
+  CHECK(!ring.push(99));
+  CHECK_EQ(ring.getDroppedCount(), 25u);
+  CHECK_EQ(ring.space(), 0u);
+
+  // The first 16 survive, in order, and freed space is usable again
+  uint8_t out[16];
+  CHECK_EQ(ring.popBatch(out, sizeof(out)), 16u);
+  for (uint8_t i = 0; i < 16; i++) CHECK_EQ(out[i], i);
+  CHECK(ring.push(7));
+  CHECK_EQ(ring.available(), 1u);
+}
@@ -0,0 +1,297 @@
+// Telemetry frames on a host port: each record type COBS-decoded with its
+// CRC and fields checked, nothing queued while detached, whole frames only
+// when the port is short of room, and a fixed sequence against the golden
+// capture tests/data/telemetry_golden.bin (which `make -C tests telemetry`
+// also runs through v2/tools/telemetry_decode.py).
+
+#include <Arduino.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "test.h"
+#include "Telemetry.h"
+
+namespace {
+
+// USB CDC port: open or not, a TX buffer of limited room
+struct HostPort {
+  bool open = true;
+  size_t room = 4096;
+  std::vector<uint8_t> bytes;
+
+  explicit operator bool() const {
+    return open;
+  }
+
+  int availableForWrite() const {
+    return (int)room;
+  }
+
+  size_t write(const uint8_t *data, size_t length) {
+    bytes.insert(bytes.end(), data, data + length);
+    room -= length;
+    return length;
+  }
+};
+
+// CRC-16/CCITT-FALSE, bit by bit as in the spec
+uint16_t crc16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    for (int bit = 7; bit >= 0; bit--) {
+      bool feedback = ((crc >> 15) ^ (data[i] >> bit)) & 1;
+      crc = (uint16_t)(crc << 1) ^ (feedback ? 0x1021 : 0);
+    }
+  }
+  return crc;
+}
+
+bool cobsDecode(const std::vector<uint8_t> &frame, std::vector<uint8_t> &out) {
+  out.clear();
+  for (size_t pos = 0; pos < frame.size();) {
+    uint8_t code = frame[pos];
+    if (code == 0 || pos + code > frame.size()) return false;
+    out.insert(out.end(), frame.begin() + pos + 1, frame.begin() + pos + code);
+    pos += code;
+    if (code < 0xFF && pos < frame.size()) out.push_back(0);
+  }
+  return true;
+}
+
+// Records of a port capture, CRC removed; a damaged frame counts in bad
+std::vector<std::vector<uint8_t>> records(const std::vector<uint8_t> &stream, uint32_t &bad) {
+  std::vector<std::vector<uint8_t>> out;
+  std::vector<uint8_t> frame, record;
+  bad = 0;
+  for (uint8_t byte : stream) {
+    if (byte != 0) {
+      frame.push_back(byte);
+      continue;
+    }
+    if (!frame.empty()) {
+      if (cobsDecode(frame, record) && record.size() >= 7
+          && crc16(record.data(), record.size() - 2) == (record[record.size() - 2] | record[record.size() - 1] << 8)) {
+        record.resize(record.size() - 2);
+        out.push_back(record);
+      } else {
+        bad++;
+      }
+    }
+    frame.clear();
+  }
+  return out;
+}
+
+uint16_t get16(const std::vector<uint8_t> &r, size_t at) {
+  return r[at] | r[at + 1] << 8;
+}
+
+uint32_t get32(const std::vector<uint8_t> &r, size_t at) {
+  return get16(r, at) | (uint32_t)get16(r, at + 2) << 16;
+}
+
+GpsFix fixOf(int32_t latE6, int32_t lonE6, uint16_t speedKmhX10, uint16_t courseCdeg, bool valid) {
+  GpsFix fix = {};
+  fix.latE6 = latE6;
+  fix.lonE6 = lonE6;
+  fix.speedKmhX10 = speedKmhX10;
+  fix.courseCdeg = courseCdeg;
+  fix.valid = valid;
+  return fix;
+}
+
+// Attach at 200 ms (the first attach check), then one record of each type
+// and a fix without a course, each drained before the next
+std::vector<uint8_t> goldenStream() {
+  Telemetry telemetry;
+  HostPort port;
+  HostArduino::reset();
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+
+  HostArduino::clockUs = 1000000;
+  telemetry.writeFix(TELEM_CHANNEL_GPS, fixOf(47497912, 19040235, 500, 9000, true), fixOf(47497900, 19040240, 0, 0, true));
+  telemetry.service(port, millis());
+
+  HostArduino::clockUs = 1100000;
+  telemetry.writeFix(TELEM_CHANNEL_GPS, fixOf(-33852058, -151209054, 0, GPS_COURSE_UNKNOWN, false),
+                     fixOf(-33852058, -151209054, 0, GPS_COURSE_UNKNOWN, false));
+  telemetry.service(port, millis());
+
+  HostArduino::clockUs = 1100500;
+  telemetry.writeProximity(TELEM_CHANNEL_PROXIMITY, 850, 3, 70, 90, true, 412);
+  telemetry.service(port, millis());
+
+  HostArduino::clockUs = 1200000;
+  telemetry.writeStage(TELEM_CHANNEL_UI, TELEM_STAGE_UI, 100, 23456, 789);
+  telemetry.service(port, millis());
+
+  HostArduino::clockUs = 1200010;
+  OutputStats led, display, buzzer;
+  led.written = 12;
+  led.elided = 3456;
+  display.written = 7;
+  display.elided = 890;
+  telemetry.writeOutputs(TELEM_CHANNEL_UI, led, display, buzzer);
+  telemetry.service(port, millis());
+
+  return port.bytes;
+}
+
+}  // namespace
+
+TEST(telemetry_crc_is_ccitt_false) {
+  const char *CHECK_STRING = "123456789";
+  CHECK_EQ(crc16((const uint8_t *)CHECK_STRING, 9), 0x29B1);
+}
+
+TEST(telemetry_records_decode) {
+  uint32_t bad;
+  std::vector<uint8_t> stream = goldenStream();
+  std::vector<std::vector<uint8_t>> decoded = records(stream, bad);
+  CHECK_EQ(bad, 0u);
+  if (!CHECK_EQ(decoded.size(), 5u)) return;
+
+  // Frames are COBS: the only zeros are the delimiters, one per record
+  size_t zeros = 0;
+  for (uint8_t byte : stream) zeros += byte == 0;
+  CHECK_EQ(zeros, 5u);
+  CHECK_EQ(stream.back(), 0);
+
+  const std::vector<uint8_t> &fix = decoded[0];
+  CHECK_EQ(fix.size(), 5u + 21);
+  CHECK_EQ(fix[0], TELEM_FIX);
+  CHECK_EQ(get32(fix, 1), 1000000u);
+  CHECK_EQ((int32_t)get32(fix, 5), 47497912);
+  CHECK_EQ((int32_t)get32(fix, 9), 19040235);
+  CHECK_EQ((int32_t)get32(fix, 13), 47497900);
+  CHECK_EQ((int32_t)get32(fix, 17), 19040240);
+  CHECK_EQ(get16(fix, 21), 500);
+  CHECK_EQ(get16(fix, 23), 9000);
+  CHECK_EQ(fix[25], 1);
+
+  const std::vector<uint8_t> &lost = decoded[1];
+  CHECK_EQ((int32_t)get32(lost, 5), -33852058);
+  CHECK_EQ((int32_t)get32(lost, 9), -151209054);
+  CHECK_EQ(get16(lost, 23), GPS_COURSE_UNKNOWN);
+  CHECK_EQ(lost[25], 0);
+
+  const std::vector<uint8_t> &proximity = decoded[2];
+  CHECK_EQ(proximity.size(), 5u + 11);
+  CHECK_EQ(proximity[0], TELEM_PROXIMITY);
+  CHECK_EQ(get32(proximity, 1), 1100500u);
+  CHECK_EQ(get16(proximity, 5), 850);
+  CHECK_EQ(get16(proximity, 7), 3);
+  CHECK_EQ(proximity[9], 70);
+  CHECK_EQ(proximity[10], 90);
+  CHECK_EQ(proximity[11], 1);
+  CHECK_EQ(get32(proximity, 12), 412u);
+
+  const std::vector<uint8_t> &stage = decoded[3];
+  CHECK_EQ(stage.size(), 5u + 11);
+  CHECK_EQ(stage[0], TELEM_STAGE);
+  CHECK_EQ(stage[5], TELEM_STAGE_UI);
+  CHECK_EQ(get16(stage, 6), 100);
+  CHECK_EQ(get32(stage, 8), 23456u);
+  CHECK_EQ(get32(stage, 12), 789u);
+
+  const std::vector<uint8_t> &outputs = decoded[4];
+  CHECK_EQ(outputs.size(), 5u + 24);
+  CHECK_EQ(outputs[0], TELEM_OUTPUTS);
+  const uint32_t COUNTS[] = { 12, 3456, 7, 890, 0, 0 };
+  for (size_t i = 0; i < 6; i++) CHECK_EQ(get32(outputs, 5 + 4 * i), COUNTS[i]);
+
+  // One flipped bit anywhere in a frame fails its CRC or its COBS
+  for (size_t at = 0; at + 1 < stream.size(); at++) {
+    if (stream[at] == 0) continue;
+    std::vector<uint8_t> damaged = stream;
+    damaged[at] ^= 0x10;
+    if (damaged[at] == 0) continue;  // becomes a delimiter: splits the frame instead
+    records(damaged, bad);
+    if (!CHECK_EQ(bad, 1u)) printf("    byte %zu\n", at);
+  }
+}
+
+TEST(telemetry_matches_the_golden_capture) {
+  std::string path = __FILE__;
+  path = path.substr(0, path.find_last_of('/') + 1) + "data/telemetry_golden.bin";
+  std::ifstream in(path, std::ios::binary);
+  if (!CHECK(in.good())) return;
+  std::vector<uint8_t> golden((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  std::vector<uint8_t> stream = goldenStream();
+  if (!CHECK(stream == golden)) {
+    printf("    got");
+    for (uint8_t byte : stream) printf(" %02X", byte);
+    printf("\n");
+  }
+}
+
+TEST(telemetry_is_quiet_while_detached) {
+  Telemetry telemetry;
+  HostPort port;
+  port.open = false;
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+  CHECK(!telemetry.isActive());
+
+  telemetry.writeStage(TELEM_CHANNEL_UI, TELEM_STAGE_UI, 1, 2, 3);
+  port.open = true;
+  telemetry.service(port, millis());  // attach checks come every 200 ms
+  CHECK(!telemetry.isActive());
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+  CHECK(telemetry.isActive());
+  CHECK(port.bytes.empty());  // the record written while detached was never built
+
+  // Frames queued when the host goes away are dropped, not sent to the next one
+  telemetry.writeStage(TELEM_CHANNEL_UI, TELEM_STAGE_UI, 1, 2, 3);
+  port.open = false;
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+  port.open = true;
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+  CHECK(port.bytes.empty());
+  CHECK_EQ(telemetry.getFramesSent(), 0u);
+}
+
+TEST(telemetry_sends_whole_frames_only) {
+  Telemetry telemetry;
+  HostPort port;
+  HostArduino::advanceMs(200);
+  telemetry.service(port, millis());
+
+  for (uint16_t i = 0; i < 3; i++) telemetry.writeStage(TELEM_CHANNEL_GPS, TELEM_STAGE_GPS, i, 0, 0);
+  telemetry.writeProximity(TELEM_CHANNEL_PROXIMITY, 100, 1, 50, 0, false, 10);
+
+  // Room for one 20 byte frame: one goes out, the rest wait
+  port.room = 20;
+  telemetry.service(port, millis());
+  CHECK_EQ(telemetry.getFramesSent(), 1u);
+  CHECK_EQ(port.bytes.back(), 0);
+  uint32_t bad;
+  CHECK_EQ(records(port.bytes, bad).size(), 1u);
+
+  port.room = 4096;
+  telemetry.service(port, millis());
+  std::vector<std::vector<uint8_t>> decoded = records(port.bytes, bad);
+  CHECK_EQ(bad, 0u);
+  if (!CHECK_EQ(decoded.size(), 4u)) return;
+
+  // Round robin over the rings, carrying on from the ring after the last
+  // one tried (the attach pass left off at the proximity ring); each ring in order
+  CHECK_EQ(decoded[0][0], TELEM_PROXIMITY);
+  for (uint16_t i = 0; i < 3; i++) {
+    CHECK_EQ(decoded[1 + i][0], TELEM_STAGE);
+    CHECK_EQ(get16(decoded[1 + i], 6), i);
+  }
+  CHECK_EQ(telemetry.getDroppedFrames(), 0u);
+
+  // A ring of 16 frames with no room on the port: the 17th is dropped
+  port.room = 0;
+  for (uint16_t i = 0; i < 17; i++) telemetry.writeStage(TELEM_CHANNEL_UI, TELEM_STAGE_UI, i, 0, 0);
+  telemetry.service(port, millis());
+  CHECK_EQ(telemetry.getDroppedFrames(), 1u);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <type_traits>
+
+// Minimal test registry. TEST(name) defines and registers a case, the CHECK
+// macros report a failure and let the case go on, main.cpp runs every case
+// (or those whose name contains argv[1]).
+
+struct TestCase {
+  const char *name;
+  void (*run)();
+  TestCase *next;
+};
+
+namespace TestRegistry {
+inline TestCase *first = nullptr;
+inline TestCase *last = nullptr;
+inline unsigned failures = 0;  // of the running case
+}
+
+struct TestRegistrar {
+  explicit TestRegistrar(TestCase &test) {
+    if (TestRegistry::last != nullptr) {
+      TestRegistry::last->next = &test;
+    } else {
+      TestRegistry::first = &test;
+    }
+    TestRegistry::last = &test;
+  }
+};
+
+#define TEST(name) \
+  static void test_##name(); \
+  static TestCase testCase_##name = { #name, test_##name, nullptr }; \
+  static TestRegistrar testRegistrar_##name(testCase_##name); \
+  static void test_##name()
+
+inline void testFailed(const char *file, int line, const char *what) {
+  printf("  %s:%d: %s\n", file, line, what);
+  TestRegistry::failures++;
+}
+
+template<typename T>
+inline void testPrint(const char *label, const T &value) {
+  if constexpr (std::is_floating_point<T>::value) {
+    printf("    %s = %.9g\n", label, (double)value);
+  } else if constexpr (std::is_signed<T>::value) {
+    printf("    %s = %lld\n", label, (long long)value);
+  } else {
+    printf("    %s = %llu (0x%llx)\n", label, (unsigned long long)value, (unsigned long long)value);
+  }
+}
+
+template<typename A, typename B>
+inline bool testEqual(const char *file, int line, const char *what, const A &a, const B &b) {
+  if (a == b) return true;
+  testFailed(file, line, what);
+  testPrint("left ", a);
+  testPrint("right", b);
+  return false;
+}
+
+inline bool testNear(const char *file, int line, const char *what, double a, double b, double tolerance) {
+  if (fabs(a - b) <= tolerance) return true;
+  testFailed(file, line, what);
+  printf("    %.9g vs %.9g, off by %.3g (tolerance %.3g)\n", a, b, fabs(a - b), tolerance);
+  return false;
+}
+
+#define CHECK(condition) ((condition) ? true : (testFailed(__FILE__, __LINE__, #condition), false))
+#define CHECK_EQ(a, b) testEqual(__FILE__, __LINE__, #a " == " #b, (a), (b))
+#define CHECK_NEAR(a, b, tolerance) testNear(__FILE__, __LINE__, #a " ~ " #b, (a), (b), (tolerance))
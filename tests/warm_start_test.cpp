@@ -0,0 +1,187 @@
+// Warm start through a scripted receiver on UART 1: NMEA fixes in, the record
+// kept and saved to NVS, then the MGA-INI aiding after a software reset (time
+// and position, exact bytes) and after a power-on (position from NVS only).
+// The receiver answers every MGA-INI frame with an MGA-ACK-DATA0, which the
+// NMEA parser has to step over.
+
+#include <Arduino.h>
+#include <vector>
+#include "test.h"
+#include "Better-GPS.h"
+#include "WarmStart.h"
+
+namespace {
+
+// Budapest, 120.5 m above sea level, geoid 40.2 m: 160.7 m above the ellipsoid
+const char *const LAT = "4729.87472,N";
+const char *const LON = "01902.41410,E";
+
+// MGA-INI TIME_UTC for 2024-06-15 10:47:10.000 UTC, accuracy 575 ms
+const uint8_t TIME_UTC_FRAME[] = { 0xB5, 0x62, 0x13, 0x40, 0x18, 0x00, 0x10, 0x00, 0x00, 0x80, 0xE8, 0x07, 0x06, 0x0F, 0x0A, 0x2F,
+                                   0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0xCD, 0x45, 0x22, 0x36, 0x54 };
+
+// MGA-INI POS_LLH for 47.497912 N 19.040235 E, 160.70 m, accuracy 500 m
+const uint8_t POS_LLH_FRAME[] = { 0xB5, 0x62, 0x13, 0x40, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0x30, 0x9B, 0x4F, 0x1C,
+                                  0x2E, 0x4F, 0x59, 0x0B, 0xC6, 0x3E, 0x00, 0x00, 0x50, 0xC3, 0x00, 0x00, 0x96, 0xFC };
+
+std::string sentence(const char *body) {
+  uint8_t checksum = 0;
+  for (const char *c = body; *c != '\0'; c++) checksum ^= (uint8_t)*c;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  return std::string("$") + body + tail;
+}
+
+// RMC and GGA for one epoch of 2024-06-15, seconds after 10:20:30
+void sendEpoch(HardwareSerial &uart, uint32_t seconds, bool fixed) {
+  uint32_t s = 10 * 3600 + 20 * 60 + 30 + seconds;
+  char time[16], body[128];
+  snprintf(time, sizeof(time), "%02u%02u%02u.00", s / 3600, s / 60 % 60, s % 60);
+
+  snprintf(body, sizeof(body), "GPRMC,%s,%c,%s,%s,0.0,0.0,150624,,,A", time, fixed ? 'A' : 'V', LAT, LON);
+  uart.receive(sentence(body).c_str());
+  snprintf(body, sizeof(body), "GPGGA,%s,%s,%s,%d,08,0.9,120.5,M,40.2,M,,", time, LAT, LON, fixed ? 1 : 0);
+  uart.receive(sentence(body).c_str());
+}
+
+// The ESP32 system clock: set to GPS UTC at each sync, running 100 ppm fast
+struct SystemClock {
+  int64_t setToMs = 0;
+  uint32_t setAtMillis = 0;
+
+  int64_t nowMs() const {
+    return setToMs + (int64_t)(millis() - setAtMillis) * 10001 / 10000;
+  }
+
+  void set(int64_t utcMs) {
+    setToMs = utcMs;
+    setAtMillis = millis();
+  }
+};
+
+// The GPS stage of the sketch: parse, then keep the warm start record
+// (trackWarmStart)
+bool gpsStage(BetterGPS &gps, WarmStart &warmStart, SystemClock &clock) {
+  gps.update();
+  GpsFix fix;
+  if (!gps.getFix(fix)) return false;
+
+  int64_t utcMs;
+  if (!gps.getUtcMs(utcMs)) utcMs = -1;
+  if (warmStart.update(fix, gps.getAltitudeDm(), utcMs, clock.nowMs())) clock.set(utcMs);
+  return true;
+}
+
+// Scripted receiver: every MGA-INI frame written to it is acknowledged with
+// MGA-ACK-DATA0 (accepted, echoing the message id and first payload bytes)
+struct Receiver {
+  std::vector<std::vector<uint8_t>> frames;
+
+  void attach(HardwareSerial &uart) {
+    uart.responder = [this](HardwareSerial &port, const uint8_t *data, size_t length) {
+      for (size_t i = 0; i + UBX_FRAME_OVERHEAD <= length;) {
+        size_t frameLength = UBX_FRAME_OVERHEAD + (data[i + 4] | data[i + 5] << 8);
+        frames.emplace_back(data + i, data + i + frameLength);
+
+        uint8_t payload[8] = { 0x01, 0x00, 0x00, data[i + 3], data[i + 6], data[i + 7], data[i + 8], data[i + 9] };
+        uint8_t out[16];
+        port.receive(out, ubxFrame(0x13, 0x60, payload, sizeof(payload), out, sizeof(out)));
+        i += frameLength;
+      }
+    };
+  }
+};
+
+bool sameBytes(const std::vector<uint8_t> &actual, const uint8_t *expected, size_t length) {
+  if (actual.size() == length && memcmp(actual.data(), expected, length) == 0) return true;
+  printf("    got");
+  for (uint8_t b : actual) printf(" %02X", b);
+  printf("\n");
+  return false;
+}
+
+}  // namespace
+
+TEST(warm_start_aiding_after_reset_and_power_on) {
+  Preferences::erase();
+  SystemClock clock;
+  WarmStartRecord rtc;
+  memset(&rtc, 0xA5, sizeof(rtc));  // RTC_NOINIT memory after a power-on
+
+  // ---- First drive: power-on with empty NVS, nothing to send
+  {
+    BetterGPS gps;
+    WarmStart warmStart(rtc);
+    warmStart.begin(false);
+    uint8_t aiding[WARM_START_AIDING_MAX];
+    CHECK_EQ(warmStart.buildAiding(clock.nowMs(), aiding, sizeof(aiding)), 0u);
+
+    // 10 minutes of fixes (clock set at the first, resynced and drift
+    // measured at the last), then the fix is lost
+    HardwareSerial &uart = *HardwareSerial::port(1);
+    for (uint32_t second = 0; second <= 610; second++) {
+      sendEpoch(uart, second, second <= 600);
+      bool fresh = gpsStage(gps, warmStart, clock);
+      if (second <= 600) CHECK(fresh);
+      HostArduino::advanceMs(1000);
+    }
+  }
+  CHECK(rtc.driftKnown);
+  CHECK_EQ(rtc.driftPpb, 100000);
+  CHECK_EQ(rtc.altitudeDm, 1607);
+
+  // The NVS copy holds the position but not the clock
+  {
+    Preferences prefs;
+    prefs.begin("warm");
+    WarmStartRecord stored;
+    CHECK_EQ(prefs.getBytes("fix", &stored, sizeof(stored)), sizeof(stored));
+    CHECK_EQ(stored.latE6, 47497912);
+    CHECK_EQ(stored.lonE6, 19040235);
+    CHECK_EQ(stored.syncUtcMs, 0);
+  }
+
+  // ---- Software reset 1000 s after the last sync: time and position
+  HostArduino::advanceMs(1000000 - 11 * 1000);
+  {
+    BetterGPS gps;
+    HardwareSerial &uart = *HardwareSerial::port(1);
+    Receiver receiver;
+    receiver.attach(uart);
+
+    WarmStart warmStart(rtc);
+    warmStart.begin(true);
+    uint8_t aiding[WARM_START_AIDING_MAX];
+    gps.sendUbx(aiding, warmStart.buildAiding(clock.nowMs(), aiding, sizeof(aiding)));
+
+    CHECK_EQ(receiver.frames.size(), 2u);
+    if (receiver.frames.size() == 2) {
+      CHECK(sameBytes(receiver.frames[0], TIME_UTC_FRAME, sizeof(TIME_UTC_FRAME)));
+      CHECK(sameBytes(receiver.frames[1], POS_LLH_FRAME, sizeof(POS_LLH_FRAME)));
+    }
+
+    // The two acknowledgements come first on the line, then NMEA
+    CHECK_EQ(uart.available(), 2 * 16);
+    sendEpoch(uart, 1700, true);
+    CHECK(gpsStage(gps, warmStart, clock));
+    CHECK_EQ(gps.getNmeaStats().checksumErrors, 0u);
+    CHECK_EQ(gps.getAltitudeDm(), 1607);
+  }
+
+  // ---- Power-on: RTC memory lost, position from NVS only
+  {
+    WarmStartRecord lost;
+    memset(&lost, 0x5A, sizeof(lost));
+    BetterGPS gps;
+    Receiver receiver;
+    receiver.attach(*HardwareSerial::port(1));
+
+    WarmStart warmStart(lost);
+    warmStart.begin(false);
+    uint8_t aiding[WARM_START_AIDING_MAX];
+    gps.sendUbx(aiding, warmStart.buildAiding(clock.nowMs(), aiding, sizeof(aiding)));
+
+    CHECK_EQ(receiver.frames.size(), 1u);
+    if (receiver.frames.size() == 1) CHECK(sameBytes(receiver.frames[0], POS_LLH_FRAME, sizeof(POS_LLH_FRAME)));
+  }
+}
@@ -0,0 +1,273 @@
+// ZoneLayer's crossing-number test and overlap rule on hand-made polygons
+// (diamonds in both windings, a concave U with horizontal edges, overlapping
+// boxes, a zone over hundreds of grid cells), random points against a double
+// reference, and the zone through DetectorCore: the entry cue and the
+// manual > camera > zone > road limit order.
+
+#include <Arduino.h>
+#include <random>
+#include "test.h"
+#include "ProximityModel.h"
+#include "CameraDb.h"
+#include "SegmentLayer.h"
+#include "ZoneLayer.h"
+#include "DetectorCore.h"
+#include "coordinates.h"
+
+namespace {
+
+constexpr ZoneVertex VERTICES[] = {
+  // 0: diamond, counter-clockwise (S, E, N, W)
+  { 47.500, 19.010 }, { 47.510, 19.020 }, { 47.520, 19.010 }, { 47.510, 19.000 },
+  // 4: the same diamond 0.1 degree east, clockwise (S, W, N, E)
+  { 47.500, 19.110 }, { 47.510, 19.100 }, { 47.520, 19.110 }, { 47.510, 19.120 },
+  // 8: U open to the north: arms 19.000-19.010 and 19.020-19.030, base up to 47.610
+  { 47.600, 19.000 }, { 47.600, 19.030 }, { 47.630, 19.030 }, { 47.630, 19.020 },
+  { 47.610, 19.020 }, { 47.610, 19.010 }, { 47.630, 19.010 }, { 47.630, 19.000 },
+  // 16: A, B, C overlapping boxes
+  { 47.700, 19.000 }, { 47.700, 19.020 }, { 47.720, 19.020 }, { 47.720, 19.000 },
+  { 47.710, 19.010 }, { 47.710, 19.030 }, { 47.730, 19.030 }, { 47.730, 19.010 },
+  { 47.700, 19.015 }, { 47.700, 19.040 }, { 47.740, 19.040 }, { 47.740, 19.015 },
+  // 28: triangle over 20 x 30 grid cells
+  { 47.800, 19.000 }, { 47.800, 19.300 }, { 48.000, 19.000 },
+};
+
+constexpr AlertZone ZONES[] = {
+  { ZONE_SCHOOL, 30, 0, 4 },          // 0: diamond
+  { ZONE_SCHOOL, 30, 4, 4 },          // 1: diamond, other winding
+  { ZONE_ROADWORKS, 50, 8, 8 },       // 2: U
+  { ZONE_SCHOOL, 30, 16, 4 },         // 3: A
+  { ZONE_ROADWORKS, 50, 20, 4 },      // 4: B
+  { ZONE_LOW_EMISSION, 0, 24, 4 },    // 5: C, no limit of its own
+  { ZONE_LOW_EMISSION, 0, 28, 3 },    // 6: triangle
+  { ZONE_SCHOOL, 30, 0, 2 },          // 7: placeholder, never indexed
+};
+
+constexpr ZoneLayerSize ZONE_SIZE = measureZoneLayer(VERTICES, ZONES);
+constexpr auto ZONE_LAYER = buildZoneLayer<ZONE_SIZE.edges, ZONE_SIZE.entries>(VERTICES, ZONES);
+
+ZoneMatch at(double lat, double lon) {
+  return ZONE_LAYER.zoneAt(toE6(lat), toE6(lon));
+}
+
+bool inside(size_t zone, double lat, double lon) {
+  return ZONE_LAYER.contains(ZONE_LAYER.polygons[zone], toE6(lat), toE6(lon));
+}
+
+// Even-odd test in double on the microdegree vertices (boundary points can go either way)
+bool referenceInside(const AlertZone &zone, int32_t latE6, int32_t lonE6) {
+  bool in = false;
+  for (uint16_t i = 0, j = zone.count - 1; i < zone.count; j = i++) {
+    double yi = toE6(VERTICES[zone.first + i].lat), xi = toE6(VERTICES[zone.first + i].lon);
+    double yj = toE6(VERTICES[zone.first + j].lat), xj = toE6(VERTICES[zone.first + j].lon);
+    if ((yi > latE6) != (yj > latE6) && lonE6 < (xj - xi) * (latE6 - yi) / (yj - yi) + xi) in = !in;
+  }
+  return in;
+}
+
+// On one of the zone's edges, exactly (integer collinearity and extent)
+bool onBoundary(const AlertZone &zone, int32_t latE6, int32_t lonE6) {
+  for (uint16_t i = 0; i < zone.count; i++) {
+    int64_t y1 = toE6(VERTICES[zone.first + i].lat), x1 = toE6(VERTICES[zone.first + i].lon);
+    int64_t y2 = toE6(VERTICES[zone.first + (i + 1) % zone.count].lat);
+    int64_t x2 = toE6(VERTICES[zone.first + (i + 1) % zone.count].lon);
+    bool collinear = (x2 - x1) * (latE6 - y1) == (lonE6 - x1) * (y2 - y1);
+    bool within = latE6 >= std::min(y1, y2) && latE6 <= std::max(y1, y2) && lonE6 >= std::min(x1, x2)
+                  && lonE6 <= std::max(x1, x2);
+    if (collinear && within) return true;
+  }
+  return false;
+}
+
+// A camera in zone A, one well east of everything, and a road through A, B and C
+constexpr ProximityModel PROXIMITY_MODEL = { 2.0f, 1.0f, 100, 150, 1000 };
+constexpr ProximityTable<200> PROXIMITY_RADIUS = buildProximityTable<200>(PROXIMITY_MODEL);
+constexpr Coordinate CAMERAS[] = { { 47.7050, 19.0050, 70 }, { 47.7150, 19.1500, 110 } };
+constexpr Region CAMERA_REGIONS[] = { { "A", 0, 2 } };
+constexpr CameraDbSize CAMERA_SIZE = measureCameraDb(CAMERAS, CAMERA_REGIONS);
+typedef CameraDb<CAMERA_SIZE.blocks, CAMERA_SIZE.bytes, CAMERA_SIZE.regions> CameraDatabase;
+constexpr CameraDatabase CAMERA_DB =
+  buildCameraDb<CAMERA_SIZE.blocks, CAMERA_SIZE.bytes>(CAMERAS, CAMERA_REGIONS, 2 * PROXIMITY_RADIUS.maxRadius());
+constexpr RoadSegment ROADS[] = { { 47.7150, 18.9900, 47.7150, 19.0500, 90 } };
+constexpr auto ROAD_LAYER = buildSegmentLayer<segmentIndexSize(ROADS)>(ROADS);
+
+typedef DetectorCore<CameraDatabase, CAMERA_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), decltype(ROAD_LAYER),
+                     decltype(ZONE_LAYER)>
+  ZoneDetector;
+
+GpsFix fixAt(double lat, double lon, uint16_t speedKmh) {
+  GpsFix fix = {};
+  fix.latE6 = toE6(lat);
+  fix.lonE6 = toE6(lon);
+  fix.speedKmhX10 = speedKmh * 10;
+  fix.valid = true;
+  fix.timestampMs = millis();
+  fix.courseCdeg = GPS_COURSE_UNKNOWN;
+  fix.rxMicros = micros();
+  return fix;
+}
+
+}  // namespace
+
+TEST(zone_layer_ray_through_a_vertex) {
+  // Level with the west and east corners: the ray passes through both
+  CHECK(inside(0, 47.510, 19.005));
+  CHECK(inside(0, 47.510, 19.015));
+  CHECK(!inside(0, 47.510, 18.995));
+  CHECK(!inside(0, 47.510, 19.025));
+
+  // Level with the south and north tips, just beside them
+  CHECK(!inside(0, 47.500, 19.005));
+  CHECK(!inside(0, 47.520, 19.005));
+  CHECK(inside(0, 47.5001, 19.010));
+
+  // The U's inner corners: ray through two vertices joined by a horizontal edge
+  CHECK(inside(2, 47.610, 19.005));
+  CHECK(!inside(2, 47.610, 18.995));
+  CHECK(!inside(2, 47.610, 19.035));
+}
+
+TEST(zone_layer_points_on_horizontal_edges) {
+  // Horizontal edges are not compiled: the U keeps 4 of its 8
+  CHECK_EQ(ZONE_LAYER.polygons[2].edgeCount, 4);
+  CHECK_EQ(ZONE_LAYER.polygons[3].edgeCount, 2);
+
+  // Half open in latitude: a south edge belongs to the zone, a north edge does not
+  CHECK(inside(2, 47.600, 19.015));   // base, south edge
+  CHECK(!inside(2, 47.610, 19.015));  // notch floor, a north edge of the base
+  CHECK(inside(2, 47.6099, 19.015));
+  CHECK(!inside(2, 47.630, 19.005));  // top of the west arm
+  CHECK(inside(2, 47.6299, 19.005));
+  CHECK(!inside(2, 47.600, 19.035));  // level with the base, east of it
+}
+
+TEST(zone_layer_concave_polygon) {
+  CHECK(inside(2, 47.620, 19.005));   // west arm
+  CHECK(inside(2, 47.620, 19.025));   // east arm
+  CHECK(inside(2, 47.605, 19.015));   // base
+  CHECK(!inside(2, 47.620, 19.015));  // notch, inside the bounding box
+  CHECK_EQ(at(47.620, 19.015).kind, ZONE_NONE);
+  CHECK_EQ(at(47.620, 19.015).tested, 1);
+  CHECK_EQ(at(47.620, 19.025).kind, ZONE_ROADWORKS);
+}
+
+TEST(zone_layer_windings_agree_with_a_double_reference) {
+  std::mt19937 random(6);
+  std::uniform_int_distribution<int32_t> offset(-12000, 12000);
+  uint32_t boundary = 0;
+
+  for (int i = 0; i < 100000; i++) {
+    int32_t dLat = offset(random), dLon = offset(random);
+    int32_t latE6 = 47510000 + dLat, lonE6 = 19010000 + dLon;
+
+    // The two windings of the diamond give the same answer everywhere
+    bool counter = ZONE_LAYER.contains(ZONE_LAYER.polygons[0], latE6, lonE6);
+    bool clockwise = ZONE_LAYER.contains(ZONE_LAYER.polygons[1], latE6, lonE6 + 100000);
+    CHECK_EQ(counter, clockwise);
+
+    // The reference may only disagree on an edge
+    for (size_t zone : { 0, 2 }) {
+      int32_t lat = zone == 2 ? latE6 + 105000 : latE6;
+      int32_t lon = zone == 2 ? lonE6 + 5000 : lonE6;
+      if (ZONE_LAYER.contains(ZONE_LAYER.polygons[zone], lat, lon) != referenceInside(ZONES[zone], lat, lon)) {
+        if (!CHECK(onBoundary(ZONES[zone], lat, lon))) printf("    zone %zu at %d %d\n", zone, lat, lon);
+        boundary++;
+      }
+    }
+  }
+  printf("  %u boundary points decided differently from the reference\n", boundary);
+
+  // Every vertex of the grid of edges, both windings
+  for (int32_t lat = 47499000; lat <= 47521000; lat += 500) {
+    for (int32_t lon = 18999000; lon <= 19021000; lon += 500) {
+      CHECK_EQ(ZONE_LAYER.contains(ZONE_LAYER.polygons[0], lat, lon),
+               ZONE_LAYER.contains(ZONE_LAYER.polygons[1], lat, lon + 100000));
+    }
+  }
+}
+
+TEST(zone_layer_overlaps_take_the_lowest_limit) {
+  const struct {
+    double lat, lon;
+    ZoneKind kind;
+    uint8_t limitKmh;
+    uint16_t tested;
+  } CASES[] = {
+    { 47.705, 19.005, ZONE_SCHOOL, 30, 1 },         // A
+    { 47.715, 19.012, ZONE_SCHOOL, 30, 2 },         // A and B
+    { 47.705, 19.018, ZONE_SCHOOL, 30, 2 },         // A and C
+    { 47.715, 19.018, ZONE_SCHOOL, 30, 3 },         // A, B and C
+    { 47.725, 19.020, ZONE_ROADWORKS, 50, 2 },      // B and C
+    { 47.735, 19.035, ZONE_LOW_EMISSION, 0, 1 },    // C, no limit
+    { 47.725, 19.005, ZONE_NONE, 0, 0 },            // none
+  };
+  for (const auto &c : CASES) {
+    ZoneMatch match = at(c.lat, c.lon);
+    CHECK_EQ(match.kind, c.kind);
+    CHECK_EQ(match.limitKmh, c.limitKmh);
+    CHECK_EQ(match.tested, c.tested);
+  }
+}
+
+TEST(zone_layer_zone_over_many_cells) {
+  // The triangle's box covers 20 x 30 cells of 0.01 degree, one index entry each
+  CHECK(ZONE_SIZE.entries >= 21 * 31);
+  uint32_t inCount = 0;
+  for (double lat = 47.8003; lat < 48.0; lat += 0.0097) {
+    for (double lon = 19.0005; lon < 19.3; lon += 0.0113) {
+      ZoneMatch match = at(lat, lon);
+      bool expected = (lat - 47.8) / 0.2 + (lon - 19.0) / 0.3 < 1;
+      CHECK_EQ(match.kind, (expected ? ZONE_LOW_EMISSION : ZONE_NONE));
+      CHECK_EQ(match.tested, 1);
+      inCount += expected;
+    }
+  }
+  CHECK(inCount > 200);
+  CHECK_EQ(at(48.001, 19.001).kind, ZONE_NONE);  // north of the box
+}
+
+TEST(detector_zone_cue_and_limit_order) {
+  static ZoneDetector detector(CAMERA_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, 25, true, 1500);
+
+  // On the road east of every zone: road limit, no zone
+  GpsFix road = fixAt(47.7150, 19.0450, 50);
+  ProximityResult result = detector.evaluate({ road, road });
+  CHECK_EQ(result.zone, ZONE_NONE);
+  CHECK_EQ(result.roadLimitKmh, 90);
+  CHECK_EQ(detector.speedLimit(result, 0), 90);
+  CHECK_EQ(detector.step(result, false, 0, micros()), ALERT_CUE_SIGNAL_FOUND);
+  HostArduino::advanceMs(100);
+  CHECK_EQ(detector.step(detector.evaluate({ road, road }), false, 0, micros()), ALERT_CUE_NONE);
+
+  // On the road in B and C: the zone limit beats the road, and entering is announced once
+  HostArduino::advanceMs(100);
+  GpsFix zone = fixAt(47.7150, 19.0250, 50);
+  result = detector.evaluate({ zone, zone });
+  CHECK_EQ(result.zone, ZONE_ROADWORKS);
+  CHECK_EQ(result.zoneLimitKmh, 50);
+  CHECK_EQ(result.roadLimitKmh, 90);
+  CHECK(!result.inRange);
+  CHECK_EQ(detector.speedLimit(result, 0), 50);
+  CHECK_EQ(detector.step(result, false, 0, micros()), ALERT_CUE_ZONE_ENTER);
+  HostArduino::advanceMs(100);
+  CHECK_EQ(detector.step(detector.evaluate({ zone, zone }), false, 0, micros()), ALERT_CUE_NONE);
+
+  // In C only: a zone without a limit leaves the road limit
+  GpsFix open = fixAt(47.7150, 19.0350, 50);
+  result = detector.evaluate({ open, open });
+  CHECK_EQ(result.zone, ZONE_LOW_EMISSION);
+  CHECK_EQ(detector.speedLimit(result, 0), 90);
+
+  // At the camera in A: camera over zone, manual over camera
+  GpsFix camera = fixAt(47.7060, 19.0050, 50);
+  result = detector.evaluate({ camera, camera });
+  CHECK(result.inRange);
+  CHECK_EQ(result.zoneLimitKmh, 30);
+  CHECK_EQ(result.roadLimitKmh, 0);
+  CHECK_EQ(detector.speedLimit(result, 0), 70);
+  CHECK_EQ(detector.speedLimit(result, 40), 40);
+
+  // Nothing around: no limit
+  GpsFix away = fixAt(47.7600, 19.0450, 50);
+  CHECK_EQ(detector.speedLimit(detector.evaluate({ away, away }), 0), 0);
+}
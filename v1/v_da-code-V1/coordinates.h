@@ -1,9 +1,18 @@
 struct Coordinate {
   double lat;
   double lon;
+  uint8_t limitKmh = 0;  // posted limit at the camera, 0 = unknown
 };
 
-const Coordinate coordinates[] PROGMEM = {
+// Cameras of one county: a contiguous range of coordinates[]
+struct Region {
+  const char *name;
+  uint16_t first;
+  uint16_t count;
+};
+
+// Only read at compile time: the sketch packs it into the camera database
+constexpr Coordinate coordinates[] = {
   { 47.315308, 19.163705 },
   { 47.468751, 18.864466 },
   { 47.589436, 19.142904 },
@@ -324,4 +333,9 @@ const Coordinate coordinates[] PROGMEM = {
   { 46.865168, 16.853709 },
   { 46.49286, 17.079483 },
   { 46.584433, 16.919088 }
-};
\ No newline at end of file
+};
+
+// The v1 list is not split by county
+constexpr Region regions[] = {
+  { "Magyarország", 0, 320 }
+};
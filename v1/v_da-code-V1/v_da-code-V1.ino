@@ -1,237 +1,169 @@
-#include <SoftwareSerial.h>
-#include <TinyGPS++.h>
+#include "BoardPolicy.h"
+#include "Better-RGB.h"
+#include "Better-Buzzer.h"
+#include "NmeaParser.h"
+#include "GpsFix.h"
+#include "ProximityModel.h"
+#include "CameraDb.h"
+#include "SegmentLayer.h"
+#include "ZoneLayer.h"
+#include "DetectorCore.h"
 #include "coordinates.h"
-#include <avr/pgmspace.h>
 
-// Connections
-const byte ledG = 4;     // D2 (GPIO4)
-const byte ledR = 5;     // D1 (GPIO5)
-const byte gpsRx = 12;   // D6 (GPIO12)
-const byte gpsTx = 13;   // D7 (GPIO13)
-const byte buzzer = 14;  // D5 (GPIO 14)
+// Pins and LED polarity (BoardPolicy.h): red D1, green D2, buzzer D5, GPS on D7
+typedef V1Board<> Board;
 
-// Instance creation
-SoftwareSerial gpsSerial(gpsTx, gpsRx);
-TinyGPSPlus gps;
-
-// GPS data
+// GPS: the module's TX is on D7 (GPIO13), which is the RX pin of UART0 after
+// Serial.swap(). The hardware UART replaces SoftwareSerial, so no byte is lost
+// while the loop is busy. Nothing is sent to the receiver.
 #define GPS_BAUD 9600
-double currentLat, currentLon;
-int currentSpeed;
+constexpr size_t GPS_RX_BUFFER = 512;
+static_assert(Board::GPS_RX == 13, "Serial.swap() receives on GPIO13");
+NmeaParser nmea;
+
+// Buzzer patterns: { frequency, duration, gap } in Hz / ms
+constexpr BuzzerNote BOOT_NOTES[] = { { 800, 100, 50 }, { 1200, 100, 50 }, { 1600, 100, 50 } };
+constexpr BuzzerNote SIGNAL_FOUND_NOTES[] = { { 4000, 100, 50 }, { 4000, 100, 50 } };
+constexpr BuzzerNote SIGNAL_LOST_NOTES[] = { { 2000, 100, 50 }, { 2000, 100, 50 } };
+// Two series of five beeps when a camera comes in range
+constexpr BuzzerNote PROXIMITY_ALERT_NOTES[] = {
+  { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 400 },
+  { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 100 }, { 4000, 150, 400 }
+};
+constexpr BuzzerNote PROXIMITY_EXIT_NOTES[] = { { 4000, 2000, 0 } };
+
+constexpr BuzzerPattern BOOT_SOUND = buzzerPattern(BOOT_NOTES);
+constexpr BuzzerPattern SIGNAL_FOUND_SOUND = buzzerPattern(SIGNAL_FOUND_NOTES);
+constexpr BuzzerPattern SIGNAL_LOST_SOUND = buzzerPattern(SIGNAL_LOST_NOTES);
+constexpr BuzzerPattern PROXIMITY_ALERT = buzzerPattern(PROXIMITY_ALERT_NOTES);
+constexpr BuzzerPattern PROXIMITY_EXIT = buzzerPattern(PROXIMITY_EXIT_NOTES);
+
+// Camera warning radius, same model as v2 (150-1000 m depending on speed)
+// instead of the old fixed 300 m
+constexpr ProximityModel PROXIMITY_MODEL = { 2.0f, 1.0f, 100, 150, 1000 };
+constexpr ProximityTable<200> PROXIMITY_RADIUS = buildProximityTable<200>(PROXIMITY_MODEL);
+
+// Cameras compressed into 0.25 degree blocks at compile time and kept in
+// flash (CORE_PROGMEM); coordinates[] itself is not stored
+constexpr uint32_t REGION_ADJACENT_MARGIN_M = 2 * PROXIMITY_RADIUS.maxRadius();
+constexpr CameraDbSize CAMERA_DB_SIZE = measureCameraDb(coordinates, regions);
+static_assert(CAMERA_DB_SIZE.cameras == sizeof(coordinates) / sizeof(coordinates[0]), "every camera must belong to a region");
+typedef CameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes, CAMERA_DB_SIZE.regions> CameraDatabase;
+constexpr CameraDatabase CAMERA_DB CORE_PROGMEM = buildCameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes>(coordinates, regions, REGION_ADJACENT_MARGIN_M);
+
+// No road layer, no zones, no speed limit selection and no display on v1:
+// the alert states are no fix, cruising and proximity
+constexpr NoRoadLayer ROAD_LAYER = {};
+constexpr NoZoneLayer ZONE_LAYER = {};
+constexpr bool AUTO_SPEED_LIMIT = false;
+
+// Degraded mode (red and green LED, no warnings) after this long without a
+// new position while the receiver still reports a fix (1 Hz)
+constexpr uint32_t STALE_FIX_MS = 3000;
+
+// Detection engine (DetectorCore.h), the same one the v2 sketch runs
+typedef DetectorCore<CameraDatabase, CAMERA_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), NoRoadLayer, NoZoneLayer> Detector;
+Detector detector(CAMERA_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, 0, AUTO_SPEED_LIMIT, STALE_FIX_MS);
+
+// Newest proximity result, the alert stage runs on it every pass
+ProximityResult lastResult = {};
 
-// Buzzer
-bool playedSignalFoundSound = false;
-bool playedNoSignalSound = false;
+// Instance creation
+BetterRGB<Board> rgb;
+BetterBuzzer buzzer;
 
-// Presence in proximity range
-bool withinProxRange = false;
-#define PROX_RANGE 300  // meters
-bool justLeftProxRange = false;
+// Sound pattern last started for the alert state
+AlertSound appliedSound = ALERT_SOUND_NONE;
 
 void setup() {
-  // Set output pins
-  pinMode(buzzer, OUTPUT);
-  pinMode(ledG, OUTPUT);
-  pinMode(ledR, OUTPUT);
+  // GPS on the hardware UART, moved to GPIO13 / GPIO15
+  Serial.setRxBufferSize(GPS_RX_BUFFER);
+  Serial.begin(GPS_BAUD);
+  Serial.swap();
 
-  // Turn red led on at boot
-  digitalWrite(ledG, HIGH);
-  digitalWrite(ledR, LOW);
+  // Start buzzer sequencer
+  buzzer.begin(Board::BUZZER);
 
-  gpsSerial.begin(GPS_BAUD);
+  // Red led on at boot
+  rgb.begin();
+  rgb.setDigitalColor(true, false, false);
 
-  // Play boot sound with reduced intensity
-  bootUpSound();
+  // Play boot sound
+  buzzer.play(BOOT_SOUND, BUZZER_UI);
 }
 
 void loop() {
-  // GPS is available
-  while (gpsSerial.available() > 0) {
-    gps.encode(gpsSerial.read());
-  }
-
-  // Process GPS data every 500ms
-  static unsigned long lastProcessTime = 0;
-  if (millis() - lastProcessTime > 500) {
-    lastProcessTime = millis();
-
-    // Found satellite(s) -> valid data
-    if (gps.location.isValid()) {
-      // Play sound once when signal is found - only if not already played
-      if (!playedSignalFoundSound) {
-        // Green led on when not in proximity range
-        if (!withinProxRange) {
-          digitalWrite(ledG, LOW);
-          digitalWrite(ledR, HIGH);
-        }
-
-        signalSound(false);
-
-        playedSignalFoundSound = true;
-        playedNoSignalSound = false;
-      }
-
-      // Get current GPS data
-      currentLat = gps.location.lat();
-      currentLon = gps.location.lng();
-      currentSpeed = gps.speed.kmph();
-
-      // Check distance to nearest traffipax
-      checkProximityToTraffipax();
-    }
-    // If no satellites are found
-    else {
-      // Play sound once when signal isn't found - only if not already played
-      if (!playedNoSignalSound) {
-        // First update LED status
-        digitalWrite(ledG, HIGH);
-        digitalWrite(ledR, LOW);
-
-        // Then play sound with slight delay
-        delay(100);
-        signalSound(true);
-
-        playedNoSignalSound = true;
-        playedSignalFoundSound = false;
-      } else {
-        // Turn red led on if not already on
-        digitalWrite(ledG, HIGH);
-        digitalWrite(ledR, LOW);
-      }
+  // Ingest: evaluate proximity on every new position
+  while (Serial.available() > 0) {
+    if (nmea.encode(Serial.read()) & NMEA_LOCATION_UPDATED) {
+      GpsFix fix = fixFromNmea(nmea.getData(), millis(), micros());
+      lastResult = detector.evaluate({ fix, fix });
     }
   }
 
-  // Small delay to prevent watchdog issues
-  delay(10);
-}
-
-// Function to check distance between traffipax and you
-void checkProximityToTraffipax() {
-  bool traffipaxFound = false;
-
-  for (int i = 0; i < sizeof(coordinates) / sizeof(coordinates[0]); i++) {
-    // Access lat + lon from flash memory
-    double lat = pgm_read_float(&coordinates[i].lat);
-    double lon = pgm_read_float(&coordinates[i].lon);
-
-    double distance = getDistance(currentLat, currentLon, lat, lon);
-
-    if (distance <= PROX_RANGE) {
-      traffipaxFound = true;
+  // Advance the buzzer sequencer
+  buzzer.tick();
+  rgb.update();
 
-      if (!withinProxRange) {
-        withinProxRange = true;  // Prevent repeated alerts
-
-        // Change LED state - RED when in proximity
-        digitalWrite(ledG, HIGH);
-        digitalWrite(ledR, LOW);
-        delay(100);
-
-        alertWithStaggeredBeepAndBlink(5);
-
-        // Keep RED on after alert
-        digitalWrite(ledR, LOW);
-        digitalWrite(ledG, HIGH);
-      } else {
-        // Ensure RED stays on while in proximity
-        digitalWrite(ledR, LOW);
-        digitalWrite(ledG, HIGH);
-      }
-      break;
-    }
+  // Work out the alert state, then write only what changed
+  AlertCue cue = detector.step(lastResult, false, 0, micros());
+  applyAlertOutputs(detector.getAlert().outputs());
+  playAlertCue(cue);
+  if (detector.getLatency().isAlertPending() && buzzer.isSounding() && buzzer.activePriority() == BUZZER_PROXIMITY) {
+    detector.alertSounded(micros());
   }
 
-  if (!traffipaxFound && withinProxRange) {
-    // We just left the proximity zone - play exit sound
-    withinProxRange = false;
-    justLeftProxRange = true;
-
-    // Switch back to GREEN
-    digitalWrite(ledR, HIGH);
-    digitalWrite(ledG, LOW);
-
-    // Play the exit sound - 2 second beep at 4000Hz
-    tone(buzzer, 4000, 2000);
-
-  } else if (!traffipaxFound && !withinProxRange) {
-    // Normal operation outside proximity - ensure GREEN is on
-    digitalWrite(ledR, HIGH);
-    digitalWrite(ledG, LOW);
-
-    // Reset the flag once we're out
-    justLeftProxRange = false;
-  }
+  // Let the WiFi / system tasks run
+  yield();
 }
 
-// Function for staggered beeping and LED blinking
-void alertWithStaggeredBeepAndBlink(byte n) {
-  for (int i = 0; i < 2; i++) {
-    for (int j = 0; j < n; j++) {
-      // First turn on LED
-      digitalWrite(ledR, HIGH);
-      delay(50);  // Brief delay
-
-      // Then start tone
-      tone(buzzer, 4000, 150);
-      digitalWrite(ledR, LOW);
-      delay(200);
-
-      // Turn off Buzzer
-      noTone(buzzer);
+// Bring LED and buzzer in line with the desired outputs
+void applyAlertOutputs(const AlertOutputs &out) {
+  // The proximity series plays once on entry; the exit beep comes as a cue
+  if (out.sound != appliedSound) {
+    if (appliedSound == ALERT_SOUND_PROXIMITY) {
+      buzzer.stop(BUZZER_PROXIMITY);
     }
-    delay(400);
+    if (out.sound == ALERT_SOUND_PROXIMITY) {
+      buzzer.play(PROXIMITY_ALERT, BUZZER_PROXIMITY);
+    }
+    appliedSound = out.sound;
   }
-}
 
-// Boot beeping sound with reduced intensity
-void bootUpSound() {
-  int baseFreq = 800;
-  for (int i = 0; i < 3; i++) {
-    tone(buzzer, baseFreq, 100);
-    delay(150);
-    baseFreq += 400;
+  // LED: red blinks with the proximity beeps, then stays on while in range
+  bool red = false, green = false;
+  switch (out.led) {
+    case ALERT_LED_RED:
+      red = true;
+      break;
+    case ALERT_LED_GREEN:
+    case ALERT_LED_MODE_BLINK:
+      green = true;
+      break;
+    case ALERT_LED_BEEP_WHITE:
+      red = buzzer.isSounding() || !buzzer.isPlaying(PROXIMITY_ALERT);
+      break;
+    case ALERT_LED_DEGRADED:
+      red = green = true;
+      break;
   }
-  noTone(buzzer);
+  rgb.setDigitalColor(red, green, false);
 }
 
-// Function to play sound based on state - simplified
-void signalSound(bool isSearching) {
-  int freq = isSearching ? 2000 : 4000;
-
-  // Play two simple beeps
-  tone(buzzer, freq, 100);
-  delay(150);
-  tone(buzzer, freq, 100);
-  delay(150);
-  noTone(buzzer);
-}
-
-// Function to convert degrees to radians
-double toRadians(double degree) {
-  return degree * M_PI / 180.0;
+// One-shot sounds on state transitions
+void playAlertCue(AlertCue cue) {
+  switch (cue) {
+    case ALERT_CUE_SIGNAL_FOUND:
+      buzzer.play(SIGNAL_FOUND_SOUND, BUZZER_UI);
+      break;
+    case ALERT_CUE_SIGNAL_LOST:
+      buzzer.play(SIGNAL_LOST_SOUND, BUZZER_UI);
+      break;
+    case ALERT_CUE_PROXIMITY_EXIT:
+      // 2 second beep at 4000Hz
+      buzzer.play(PROXIMITY_EXIT, BUZZER_PROXIMITY);
+      break;
+    default:
+      break;
+  }
 }
-
-// Function to calculate distance between 2 latitude and longitude points
-double getDistance(double lat1, double lon1, double lat2, double lon2) {
-  // Earth radius in meters
-  const double R = 6371000.0;
-
-  // Convert latitudes and longitudes to radians
-  lat1 = toRadians(lat1);
-  lat2 = toRadians(lat2);
-  lon1 = toRadians(lon1);
-  lon2 = toRadians(lon2);
-
-  // Get distance in lat, lon
-  double distance_lat = lat2 - lat1;
-  double distance_lon = lon2 - lon1;
-
-  // Square of half the chord length
-  double a = sin(distance_lat / 2) * sin(distance_lat / 2) + cos(lat1) * cos(lat2) * sin(distance_lon / 2) * sin(distance_lon / 2);
-
-  // Angular distance in radians
-  double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-
-  // Distance in meters
-  return R * c;
-}
\ No newline at end of file
@@ -0,0 +1,123 @@
+// Host benchmark of the compressed camera database on a sketch's camera list:
+// size against the flat coordinate table and decode cost per block / region.
+//
+// Build (host compiler, the database from the VdaCore library; the camera
+// list comes from the sketch folder on the include path):
+//
+//     g++ -O2 -std=c++17 -I../../libraries/VdaCore/src -I../v_da-code-V2 camera_db_bench.cpp -o camera_db_bench
+//     g++ -O2 -std=c++17 -I../../libraries/VdaCore/src -I../../v1/v_da-code-V1 camera_db_bench.cpp -o camera_db_bench_v1
+//
+// Then:
+//
+//     camera_db_bench
+//     camera_db_bench --passes 20000
+//
+// The ratio compares the encoded data plus block directory and region table
+// with the two doubles per camera the sketches stored before. Every camera
+// must decode back to its microdegree coordinates and limit; exits with 1 if
+// one does not.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "CameraDb.h"
+#include "coordinates.h"
+
+namespace {
+
+const uint32_t ADJACENT_MARGIN_M = 2000;  // 2 x the largest warning radius
+
+constexpr size_t CAMERA_COUNT = sizeof(coordinates) / sizeof(coordinates[0]);
+constexpr CameraDbSize SIZE = measureCameraDb(coordinates, regions);
+typedef CameraDb<SIZE.blocks, SIZE.bytes, SIZE.regions> CameraDatabase;
+constexpr CameraDatabase DB = buildCameraDb<SIZE.blocks, SIZE.bytes>(coordinates, regions, ADJACENT_MARGIN_M);
+
+double elapsedNs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Every camera of the list, found once among the decoded ones
+size_t roundTripErrors() {
+  CameraPosition decoded[CAMERA_COUNT];
+  size_t count = 0;
+  for (size_t r = 0; r < SIZE.regions; r++) {
+    count += DB.decodeRegion(r, decoded + count);
+  }
+
+  size_t errors = count == CAMERA_COUNT ? 0 : 1;
+  bool used[CAMERA_COUNT] = {};
+  for (const Coordinate &camera : coordinates) {
+    CameraPosition expected = { toE6(camera.lat), toE6(camera.lon), camera.limitKmh };
+    size_t i = 0;
+    while (i < count && (used[i] || decoded[i].latE6 != expected.latE6 || decoded[i].lonE6 != expected.lonE6
+                         || decoded[i].limitKmh != expected.limitKmh)) {
+      i++;
+    }
+    if (i == count) {
+      errors++;
+    } else {
+      used[i] = true;
+    }
+  }
+  return errors;
+}
+
+void usage() {
+  fprintf(stderr, "usage: camera_db_bench [--passes N]\n");
+  exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t passes = 5000;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--passes") && hasValue) passes = atoi(argv[++i]);
+    else usage();
+  }
+  if (passes == 0) usage();
+
+  size_t flatBytes = CAMERA_COUNT * 2 * sizeof(double);
+  size_t dataBytes = sizeof(DB.data), directoryBytes = sizeof(DB.directory), regionBytes = sizeof(DB.regions);
+  size_t totalBytes = dataBytes + directoryBytes + regionBytes;
+
+  // Decode every block, best of several rounds of passes
+  static CameraPosition out[CAMERA_BLOCK_MAX];
+  volatile uint32_t sink = 0;
+  double blockNs = 1e300, regionNs = 1e300;
+  for (int round = 0; round < 5; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < passes; pass++) {
+      for (size_t b = 0; b < SIZE.blocks; b++) {
+        sink = sink + DB.decodeBlock(b, out) + out[0].latE6;
+      }
+    }
+    blockNs = std::min(blockNs, elapsedNs(start) / ((double)passes * SIZE.blocks));
+
+    // Whole regions, as the working set pages them in
+    static CameraPosition regionOut[CAMERA_COUNT];
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < passes; pass++) {
+      for (size_t r = 0; r < SIZE.regions; r++) {
+        sink = sink + DB.decodeRegion(r, regionOut) + regionOut[0].lonE6;
+      }
+    }
+    regionNs = std::min(regionNs, elapsedNs(start) / ((double)passes * SIZE.regions));
+  }
+
+  size_t errors = roundTripErrors();
+  printf("%zu cameras, %zu regions, %zu blocks (%.1f cameras per block), working set %zu cameras\n", CAMERA_COUNT,
+         SIZE.regions, SIZE.blocks, (double)CAMERA_COUNT / SIZE.blocks, DB.workingSetSize());
+  printf("data %zu B + directory %zu B + regions %zu B = %zu B (%.1f B per camera)\n", dataBytes, directoryBytes,
+         regionBytes, totalBytes, (double)totalBytes / CAMERA_COUNT);
+  printf("flat lat/lon doubles %zu B: ratio %.2fx (data alone %.2fx)\n", flatBytes, (double)flatBytes / totalBytes,
+         (double)flatBytes / dataBytes);
+  printf("decode %.1f ns per block, %.1f ns per camera, %.1f ns per region\n", blockNs,
+         blockNs * SIZE.blocks / CAMERA_COUNT, regionNs);
+  printf("round trip: %zu errors\n", errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Decode a drive log partition dump into CSV or GPX.
+
+Dump the partition from the device first (offset and size from partitions.csv):
+
+    esptool.py --chip esp32c3 read_flash 0x290000 0x100000 drivelog.bin
+
+Then:
+
+    drivelog_decode.py drivelog.bin > drive.csv
+    drivelog_decode.py --gpx drivelog.bin > drive.gpx
+
+The format is described at the top of v_da-code-V2/DriveLog.h.
+"""
+
+import argparse
+import struct
+import sys
+
+SECTOR_SIZE = 4096
+PAGE_SIZE = 256
+HEADER_SIZE = 8
+MAGIC = 0x314C4456
+
+LOG_FIX = 1
+LOG_EVENT = 2
+LOG_LOOP_STATS = 3
+
+FLAGS = {0x01: "valid", 0x02: "proximity", 0x04: "overspeed", 0x08: "course"}
+EVENTS = {1: "boot", 2: "alert_state", 3: "alert_cue", 4: "speed_limit"}
+ALERT_STATES = ["no_fix", "cruising", "overspeed", "proximity", "mode_display", "stale_fix"]
+ALERT_CUES = ["none", "signal_found", "signal_lost", "proximity_exit", "zone_enter"]
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, pos
+
+
+def zigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode_page(page, start, sequence, page_index):
+    """Yield the records of one page; every page starts from a zero base."""
+    time_ms = lat = lon = 0
+    pos = start
+    while pos < PAGE_SIZE and page[pos] != 0xFF:
+        tag = page[pos]
+        kind, flags = tag & 0x07, tag >> 3
+        delta, pos = varint(page, pos + 1)
+        time_ms += delta
+        record = {"sequence": sequence, "page": page_index, "time_ms": time_ms}
+
+        if kind == LOG_FIX:
+            dlat, pos = varint(page, pos)
+            dlon, pos = varint(page, pos)
+            speed, pos = varint(page, pos)
+            lat += zigzag(dlat)
+            lon += zigzag(dlon)
+            record.update(type="fix", lat=lat / 1e6, lon=lon / 1e6, speed_kmh=speed / 10,
+                          flags="|".join(name for bit, name in FLAGS.items() if flags & bit))
+            if flags & 0x08:
+                course, pos = varint(page, pos)
+                record.update(course_deg=course / 100)
+        elif kind == LOG_EVENT:
+            code = page[pos]
+            value, pos = varint(page, pos + 1)
+            value = zigzag(value)
+            name = EVENTS.get(code, "event_%d" % code)
+            if name == "alert_state" and value < len(ALERT_STATES):
+                value = ALERT_STATES[value]
+            elif name == "alert_cue" and value < len(ALERT_CUES):
+                value = ALERT_CUES[value]
+            record.update(type=name, value=value)
+        elif kind == LOG_LOOP_STATS:
+            average, pos = varint(page, pos)
+            maximum, pos = varint(page, pos)
+            loops, pos = varint(page, pos)
+            record.update(type="loop_stats", avg_us=average, max_us=maximum, loops=loops)
+        else:
+            return  # unknown record: the rest of the page cannot be parsed
+
+        yield record
+
+
+def decode(image):
+    """Yield records of all sectors, oldest sector first."""
+    sectors = []
+    for offset in range(0, len(image) - SECTOR_SIZE + 1, SECTOR_SIZE):
+        magic, sequence = struct.unpack_from("<II", image, offset)
+        if magic == MAGIC and sequence != 0xFFFFFFFF:
+            sectors.append((sequence, offset))
+
+    for sequence, offset in sorted(sectors):
+        for page_index in range(SECTOR_SIZE // PAGE_SIZE):
+            page = image[offset + page_index * PAGE_SIZE:offset + (page_index + 1) * PAGE_SIZE]
+            start = HEADER_SIZE if page_index == 0 else 0
+            if page[start] == 0xFF:
+                break  # rest of the sector is unwritten
+            yield from decode_page(page, start, sequence, page_index)
+
+
+def write_csv(records, out):
+    columns = ["sequence", "page", "time_ms", "type", "lat", "lon", "speed_kmh", "course_deg", "flags",
+               "value", "avg_us", "max_us", "loops"]
+    out.write(",".join(columns) + "\n")
+    for record in records:
+        out.write(",".join(str(record.get(column, "")) for column in columns) + "\n")
+
+
+def write_gpx(records, out):
+    # A boot starts a new track segment, since millis() restarts from zero
+    out.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    out.write('<gpx version="1.1" creator="drivelog_decode" xmlns="http://www.topografix.com/GPX/1/1">\n')
+    out.write("<trk><name>drivelog</name><trkseg>\n")
+    for record in records:
+        if record["type"] == "boot":
+            out.write("</trkseg><trkseg>\n")
+        elif record["type"] == "fix":
+            out.write('<trkpt lat="%.6f" lon="%.6f"><desc>t=%d ms %.1f km/h %s</desc></trkpt>\n'
+                      % (record["lat"], record["lon"], record["time_ms"], record["speed_kmh"], record["flags"]))
+    out.write("</trkseg></trk>\n</gpx>\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="raw drivelog partition dump")
+    parser.add_argument("--gpx", action="store_true", help="write GPX (fixes only) instead of CSV")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        image = f.read()
+
+    records = decode(image)
+    if args.gpx:
+        write_gpx(records, sys.stdout)
+    else:
+        write_csv(records, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+// Replay the fixes of a decoded drive log through GpsKalman to evaluate a tuning.
+//
+// Build (host compiler, the filter header comes from the VdaCore library):
+//
+//     g++ -O2 -std=c++17 -I../../libraries/VdaCore/src kalman_replay.cpp -o kalman_replay
+//
+// Then, on the CSV written by drivelog_decode.py:
+//
+//     kalman_replay drive.csv
+//     kalman_replay --accel 50 --position 300 --gate 1600 drive.csv
+//     kalman_replay --trace drive.csv > filtered.csv
+//
+// Prints the innovation statistics (mean y^2 / S per axis should be near 1)
+// and the jitter of the measured and filtered tracks: RMS change of speed
+// between fixes and RMS second difference of position (cm).
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "GpsKalman.h"
+
+struct Jitter {
+  double speedSq = 0, positionSq = 0;
+  unsigned speedCount = 0, positionCount = 0;
+  bool havePrevious = false, haveStep = false;
+  double previousSpeed = 0, previousNorth = 0, previousEast = 0, stepNorth = 0, stepEast = 0;
+
+  // Positions in cm on a local flat frame
+  void add(double speedKmh, double north, double east) {
+    if (havePrevious) {
+      speedSq += (speedKmh - previousSpeed) * (speedKmh - previousSpeed);
+      speedCount++;
+      double nextNorth = north - previousNorth, nextEast = east - previousEast;
+      if (haveStep) {
+        positionSq += (nextNorth - stepNorth) * (nextNorth - stepNorth) + (nextEast - stepEast) * (nextEast - stepEast);
+        positionCount++;
+      }
+      stepNorth = nextNorth;
+      stepEast = nextEast;
+      haveStep = true;
+    }
+    previousSpeed = speedKmh;
+    previousNorth = north;
+    previousEast = east;
+    havePrevious = true;
+  }
+
+  // A gap in the track: do not difference across it
+  void restart() {
+    havePrevious = haveStep = false;
+  }
+};
+
+static void split(const std::string &line, std::vector<std::string> &fields) {
+  fields.clear();
+  std::stringstream stream(line);
+  std::string field;
+  while (std::getline(stream, field, ',')) fields.push_back(field);
+  if (!line.empty() && line.back() == ',') fields.push_back("");
+}
+
+static int column(const std::vector<std::string> &header, const char *name) {
+  for (size_t i = 0; i < header.size(); i++) {
+    if (header[i] == name) return (int)i;
+  }
+  fprintf(stderr, "missing column %s\n", name);
+  exit(1);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: kalman_replay [--accel cm/s2] [--position cm] [--velocity cm/s] [--gate nis x100]\n"
+                  "                     [--reset-gap ms] [--trace] drive.csv\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  GpsKalmanTuning tuning = DEFAULT_KALMAN_TUNING;
+  bool trace = false;
+  const char *path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--accel") && hasValue) tuning.accelNoiseCmS2 = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--position") && hasValue) tuning.positionNoiseCm = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--velocity") && hasValue) tuning.velocityNoiseCmS = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--gate") && hasValue) tuning.gateNisX100 = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--reset-gap") && hasValue) tuning.resetGapMs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--trace")) trace = true;
+    else if (argv[i][0] != '-' && path == nullptr) path = argv[i];
+    else usage();
+  }
+  if (path == nullptr) usage();
+
+  std::ifstream in(path);
+  std::string line;
+  std::vector<std::string> header, fields;
+  if (!std::getline(in, line)) usage();
+  split(line, header);
+  int timeColumn = column(header, "time_ms"), typeColumn = column(header, "type");
+  int latColumn = column(header, "lat"), lonColumn = column(header, "lon");
+  int speedColumn = column(header, "speed_kmh"), courseColumn = column(header, "course_deg");
+
+  GpsKalman kalman(tuning);
+  Jitter measured, filtered;
+  double originLat = 0, metersPerDegreeLon = 0;
+  bool haveOrigin = false;
+  uint32_t lastTimeMs = 0;
+
+  if (trace) printf("time_ms,lat,lon,speed_kmh,filtered_lat,filtered_lon,filtered_speed_kmh\n");
+
+  while (std::getline(in, line)) {
+    split(line, fields);
+    if ((int)fields.size() <= courseColumn) continue;
+
+    // millis() restarts at boot
+    if (fields[typeColumn] == "boot") {
+      kalman.stop();
+      measured.restart();
+      filtered.restart();
+      continue;
+    }
+    if (fields[typeColumn] != "fix") continue;
+
+    uint32_t timeMs = (uint32_t)strtoul(fields[timeColumn].c_str(), nullptr, 10);
+    double lat = atof(fields[latColumn].c_str()), lon = atof(fields[lonColumn].c_str());
+    double speedKmh = atof(fields[speedColumn].c_str());
+    int32_t courseCdeg = fields[courseColumn].empty() ? -1 : (int32_t)lround(atof(fields[courseColumn].c_str()) * 100);
+
+    if (timeMs - lastTimeMs > tuning.resetGapMs) {
+      measured.restart();
+      filtered.restart();
+    }
+    lastTimeMs = timeMs;
+
+    kalman.update((int32_t)lround(lat * 1e6), (int32_t)lround(lon * 1e6), (uint16_t)lround(speedKmh * 10), courseCdeg, timeMs);
+    double filteredLat = kalman.getLatE6() / 1e6, filteredLon = kalman.getLonE6() / 1e6;
+    double filteredSpeed = kalman.getSpeedKmhX10() / 10.0;
+
+    if (!haveOrigin) {
+      originLat = lat;
+      metersPerDegreeLon = 11119492.7 * cos(lat * M_PI / 180);
+      haveOrigin = true;
+    }
+    measured.add(speedKmh, (lat - originLat) * 11119492.7, lon * metersPerDegreeLon);
+    filtered.add(filteredSpeed, (filteredLat - originLat) * 11119492.7, filteredLon * metersPerDegreeLon);
+
+    if (trace) {
+      printf("%u,%.6f,%.6f,%.1f,%.6f,%.6f,%.1f\n", timeMs, lat, lon, speedKmh, filteredLat, filteredLon, filteredSpeed);
+    }
+  }
+
+  const GpsKalmanStats &stats = kalman.getStats();
+  uint32_t predicted = stats.updates - stats.resets;
+  FILE *out = trace ? stderr : stdout;
+  fprintf(out, "fixes %u, resets %u, rejected %u\n", stats.updates, stats.resets, stats.rejected);
+  if (predicted > 0) {
+    fprintf(out, "nis per axis %.2f, rms innovation %.2f m\n", stats.nisSumX100 / 200.0 / predicted,
+            sqrt((double)stats.innovationSumSqCm2 / predicted) / 100.0);
+  }
+  if (measured.positionCount > 0) {
+    fprintf(out, "speed jitter %.2f -> %.2f km/h, position jitter %.0f -> %.0f cm\n",
+            sqrt(measured.speedSq / measured.speedCount), sqrt(filtered.speedSq / filtered.speedCount),
+            sqrt(measured.positionSq / measured.positionCount), sqrt(filtered.positionSq / filtered.positionCount));
+  }
+  return 0;
+}
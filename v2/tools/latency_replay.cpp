@@ -0,0 +1,249 @@
+// Replay an NMEA trace through the v2 pipeline on a simulated clock and check
+// fix age and fix-to-alert latency against budgets.
+//
+// Build (host compiler, the pipeline headers come from the VdaCore library,
+// the camera list from the sketch):
+//
+//     g++ -O2 -std=c++17 -I../../libraries/VdaCore/src -I../v_da-code-V2 latency_replay.cpp -o latency_replay
+//
+// Then, on a raw NMEA capture of the receiver:
+//
+//     latency_replay drive.nmea
+//     latency_replay --stall-ms 250 --stall-every 500 drive.nmea
+//     latency_replay --fix-age-budget-ms 40 --alert-budget-ms 80 drive.nmea
+//
+// The sentences of each epoch (new RMC / GGA time) go out at the epoch time
+// at the UART baud rate. The UART capture callback runs on the RX FIFO
+// threshold or after the line idles, the loop passes every --pass-us with an
+// optional stall. Each pass runs the GPS, proximity and alert stages like the
+// sketch's loop(). Exits with 1 if the p95 fix age or the largest
+// fix-to-alert latency is over budget.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "NmeaParser.h"
+#include "GpsFix.h"
+#include "RxArrival.h"
+#include "ProximityModel.h"
+#include "CameraDb.h"
+#include "SegmentLayer.h"
+#include "ZoneLayer.h"
+#include "DetectorCore.h"
+#include "coordinates.h"
+
+// Same camera database and radius model as the sketch
+constexpr ProximityModel PROXIMITY_MODEL = { 2.0f, 1.0f, 100, 150, 1000 };
+constexpr ProximityTable<200> PROXIMITY_RADIUS = buildProximityTable<200>(PROXIMITY_MODEL);
+constexpr CameraDbSize CAMERA_DB_SIZE = measureCameraDb(coordinates, regions);
+typedef CameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes, CAMERA_DB_SIZE.regions> CameraDatabase;
+constexpr CameraDatabase CAMERA_DB =
+  buildCameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes>(coordinates, regions, 2 * PROXIMITY_RADIUS.maxRadius());
+constexpr NoRoadLayer ROAD_LAYER = {};
+constexpr NoZoneLayer ZONE_LAYER = {};
+constexpr uint32_t STALE_FIX_MS = 1500;
+
+// ESP32 UART defaults: RX FIFO full threshold and RX timeout in symbols
+constexpr size_t FIFO_THRESHOLD = 120;
+constexpr uint32_t RX_TIMEOUT_SYMBOLS = 2;
+constexpr uint32_t CAPTURE_WAKE_US = 50;  // UART event task wake-up
+
+struct WireByte {
+  uint64_t timeUs;
+  char c;
+};
+
+struct Chunk {
+  uint64_t timeUs;
+  std::string bytes;
+};
+
+struct Options {
+  uint32_t baud = 38400;
+  uint32_t passUs = 1000;
+  uint32_t stallMs = 0;
+  uint32_t stallEvery = 0;
+  uint32_t fixAgeBudgetMs = 50;
+  uint32_t alertBudgetMs = 100;
+};
+
+// UTC time field of RMC / GGA as ms of day, -1 for other sentences
+static int64_t sentenceTimeMs(const std::string &line) {
+  if (line.size() < 7 || (line.compare(3, 3, "RMC") != 0 && line.compare(3, 3, "GGA") != 0)) return -1;
+  size_t comma = line.find(',');
+  if (comma == std::string::npos || line.size() < comma + 7) return -1;
+  const char *t = line.c_str() + comma + 1;
+  int hh = (t[0] - '0') * 10 + (t[1] - '0'), mm = (t[2] - '0') * 10 + (t[3] - '0');
+  double ss = atof(t + 4);
+  return (int64_t)((hh * 3600 + mm * 60) * 1000 + ss * 1000 + 0.5);
+}
+
+// Sentences on the wire: each epoch starts at its UTC time, bytes back to back
+static std::vector<WireByte> wireBytes(std::ifstream &in, const Options &options) {
+  std::vector<WireByte> out;
+  double byteUs = 10e6 / options.baud;
+  int64_t firstMs = -1, epochMs = -1;
+  double cursorUs = 0;
+  std::string line;
+
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] != '$') continue;
+
+    int64_t timeMs = sentenceTimeMs(line);
+    if (timeMs >= 0 && timeMs != epochMs) {
+      if (firstMs < 0) firstMs = timeMs;
+      epochMs = timeMs;
+      int64_t offsetMs = timeMs - firstMs;
+      if (offsetMs < 0) offsetMs += 86400000;  // midnight
+      cursorUs = std::max(cursorUs, offsetMs * 1000.0);
+    }
+    line += "\r\n";
+    for (char c : line) {
+      cursorUs += byteUs;
+      out.push_back({ (uint64_t)cursorUs, c });
+    }
+  }
+  return out;
+}
+
+// When the capture callback gets which bytes: FIFO threshold or line idle
+static std::deque<Chunk> captureChunks(const std::vector<WireByte> &bytes, const Options &options) {
+  std::deque<Chunk> out;
+  double idleUs = RX_TIMEOUT_SYMBOLS * 10e6 / options.baud;
+  std::string fifo;
+
+  for (size_t i = 0; i < bytes.size(); i++) {
+    fifo += bytes[i].c;
+    bool idle = i + 1 == bytes.size() || bytes[i + 1].timeUs - bytes[i].timeUs > idleUs;
+    if (fifo.size() >= FIFO_THRESHOLD || idle) {
+      out.push_back({ bytes[i].timeUs + (uint64_t)(idle ? idleUs : 0) + CAPTURE_WAKE_US, fifo });
+      fifo.clear();
+    }
+  }
+  return out;
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, unsigned percent) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t rank = (values.size() * percent + 99) / 100;
+  return values[rank > 0 ? rank - 1 : 0];
+}
+
+static void usage() {
+  fprintf(stderr, "usage: latency_replay [--baud n] [--pass-us us] [--stall-ms ms --stall-every passes]\n"
+                  "                      [--fix-age-budget-ms ms] [--alert-budget-ms ms] trace.nmea\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  const char *path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--baud") && hasValue) options.baud = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--pass-us") && hasValue) options.passUs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--stall-ms") && hasValue) options.stallMs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--stall-every") && hasValue) options.stallEvery = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fix-age-budget-ms") && hasValue) options.fixAgeBudgetMs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--alert-budget-ms") && hasValue) options.alertBudgetMs = atoi(argv[++i]);
+    else if (argv[i][0] != '-' && path == nullptr) path = argv[i];
+    else usage();
+  }
+  if (path == nullptr || options.baud == 0 || options.passUs == 0) usage();
+
+  std::ifstream in(path);
+  if (!in) usage();
+  std::vector<WireByte> bytes = wireBytes(in, options);
+  std::deque<Chunk> chunks = captureChunks(bytes, options);
+  if (bytes.empty()) {
+    fprintf(stderr, "no NMEA sentences in %s\n", path);
+    return 2;
+  }
+
+  static DetectorCore<CameraDatabase, CAMERA_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), NoRoadLayer, NoZoneLayer> detector(
+    CAMERA_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, 0, false, STALE_FIX_MS);
+  NmeaParser nmea;
+  RxArrival<64> arrival;
+  std::deque<char> ring;
+  uint32_t locationRxMicros = 0;
+  ProximityResult result = {};
+
+  std::vector<uint32_t> fixAges, alertLatencies;
+  uint32_t fixAgeSamples = 0, alertSamples = 0, alerts = 0;
+  uint64_t endUs = bytes.back().timeUs + 100000;  // let the last epoch through, but not go stale
+  uint64_t passes = 0;
+
+  for (uint64_t nowUs = 0; nowUs <= endUs; passes++) {
+    uint32_t now = (uint32_t)nowUs;  // micros() on the device
+
+    // Capture callback(s) that ran since the last pass
+    while (!chunks.empty() && chunks.front().timeUs <= nowUs) {
+      for (char c : chunks.front().bytes) ring.push_back(c);
+      arrival.captured(chunks.front().bytes.size(), (uint32_t)chunks.front().timeUs);
+      chunks.pop_front();
+    }
+
+    // GPS stage
+    bool fresh = false;
+    while (!ring.empty()) {
+      arrival.parsed();
+      if (nmea.encode(ring.front()) & NMEA_LOCATION_UPDATED) {
+        fresh = true;
+        locationRxMicros = arrival.lastArrival(now);
+      }
+      ring.pop_front();
+    }
+    GpsFix fix = fixFromNmea(nmea.getData(), now / 1000, locationRxMicros);
+
+    // Proximity stage
+    if (fresh || !fix.valid) {
+      result = detector.evaluate({ fix, fix });
+    }
+
+    // Alert stage: a raised alert sounds in the same pass (proximity priority)
+    AlertState before = detector.getAlert().getBaseState();
+    detector.step(result, false, 0, now);
+    if (detector.getAlert().getBaseState() == ALERT_PROXIMITY && before != ALERT_PROXIMITY) alerts++;
+    if (detector.getLatency().isAlertPending() && detector.getAlert().outputs().sound != ALERT_SOUND_NONE) {
+      detector.alertSounded(now);
+    }
+
+    const FixLatency &latency = detector.getLatency();
+    if (latency.getFixAge().getTotal() != fixAgeSamples) {
+      fixAgeSamples = latency.getFixAge().getTotal();
+      fixAges.push_back(latency.getFixAge().last());
+    }
+    if (latency.getAlertLatency().getTotal() != alertSamples) {
+      alertSamples = latency.getAlertLatency().getTotal();
+      alertLatencies.push_back(latency.getAlertLatency().last());
+    }
+
+    nowUs += options.passUs;
+    if (options.stallEvery > 0 && passes % options.stallEvery == options.stallEvery - 1) {
+      nowUs += options.stallMs * 1000ULL;
+    }
+  }
+
+  const NmeaStats &stats = nmea.getStats();
+  uint32_t fixAgeP95 = percentile(fixAges, 95);
+  uint32_t alertMax = alertLatencies.empty() ? 0 : *std::max_element(alertLatencies.begin(), alertLatencies.end());
+  printf("sentences %u, fixes %zu, alerts %u, stale events %u\n", stats.sentences, fixAges.size(), alerts,
+         detector.getLatency().getStaleEvents());
+  printf("fix age p50 %.1f p95 %.1f max %.1f ms (budget p95 %u ms)\n", percentile(fixAges, 50) / 1000.0,
+         fixAgeP95 / 1000.0, percentile(fixAges, 100) / 1000.0, options.fixAgeBudgetMs);
+  printf("fix to alert p50 %.1f max %.1f ms over %zu alerts (budget max %u ms)\n", percentile(alertLatencies, 50) / 1000.0,
+         alertMax / 1000.0, alertLatencies.size(), options.alertBudgetMs);
+
+  bool ok = fixAgeP95 <= options.fixAgeBudgetMs * 1000 && alertMax <= options.alertBudgetMs * 1000;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
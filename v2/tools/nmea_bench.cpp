@@ -0,0 +1,203 @@
+// Host benchmark of NmeaParser against TinyGPSPlus on the same NMEA stream:
+// throughput (MB/s) and cost per fix (encode of the epoch's bytes plus
+// reading the position and speed on each location update).
+//
+// Build (host compiler; TinyGPSPlus is not vendored, point TINYGPSPLUS at a
+// checkout of https://github.com/mikalhart/TinyGPSPlus, it is compiled into
+// this file on the host Arduino stand-in from the tests):
+//
+//     g++ -O2 -std=c++17 -I../../libraries/VdaCore/src -I../../tests/host -I$TINYGPSPLUS/src nmea_bench.cpp -o nmea_bench
+//
+// Then, on a raw NMEA capture (e.g. from a logic analyser or a USB-UART) or on
+// a generated trace of RMC, GGA, GSA, GSV and VTG epochs:
+//
+//     nmea_bench capture.nmea
+//     nmea_bench --epochs 20000 --passes 50
+//
+// Both parsers must report the same number of fixes at the same positions
+// (within a microdegree); the mismatch count says if they do not.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "NmeaParser.h"
+
+// TinyGPSPlus, with the Arduino math macros it uses (not in the host stand-in)
+#define ARDUINO 10819
+#include <Arduino.h>
+#define TWO_PI 6.283185307179586476925286766559
+#define radians(deg) ((deg) * 0.017453292519943295769236907684886)
+#define degrees(rad) ((rad) * 57.295779513082320876798154814105)
+#define sq(x) ((x) * (x))
+#include <TinyGPS++.cpp>
+
+namespace {
+
+struct Fix {
+  int32_t latE6, lonE6;
+};
+
+struct Result {
+  double seconds = 1e30;  // best pass
+  std::vector<Fix> fixes;
+  uint64_t sink = 0;      // keeps the reads alive
+};
+
+std::string sentence(const char *body) {
+  uint8_t checksum = 0;
+  for (const char *c = body; *c != '\0'; c++) checksum ^= (uint8_t)*c;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  return std::string("$") + body + tail;
+}
+
+// NMEA degrees and minutes, 5 decimals as the u-blox M10 sends them
+void coordinate(char *out, size_t size, double value, bool latitude) {
+  char hemisphere = latitude ? (value < 0 ? 'S' : 'N') : (value < 0 ? 'W' : 'E');
+  value = fabs(value);
+  int whole = (int)value;
+  double minutes = (value - whole) * 60;
+  snprintf(out, size, latitude ? "%02d%08.5f,%c" : "%03d%08.5f,%c", whole, minutes, hemisphere);
+}
+
+// One 1 Hz epoch per second of a drive around Budapest, the sentence set of
+// the receiver's default output
+std::string generate(uint32_t epochs) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  double lat = 47.4979, lon = 19.0402, course = 90, speedKnots = 27;
+  std::string out;
+  char body[160], time[16], latText[24], lonText[24];
+
+  for (uint32_t i = 0; i < epochs; i++) {
+    uint32_t s = 36000 + i;
+    snprintf(time, sizeof(time), "%02u%02u%02u.00", s / 3600 % 24, s / 60 % 60, s % 60);
+    coordinate(latText, sizeof(latText), lat, true);
+    coordinate(lonText, sizeof(lonText), lon, false);
+
+    snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%s,%.3f,%.2f,150624,,,A,V", time, latText, lonText, speedKnots, course);
+    out += sentence(body);
+    snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", course, speedKnots, speedKnots * 1.852);
+    out += sentence(body);
+    snprintf(body, sizeof(body), "GNGGA,%s,%s,%s,1,12,0.71,120.5,M,40.2,M,,", time, latText, lonText);
+    out += sentence(body);
+    out += sentence("GNGSA,A,3,02,05,13,15,18,20,23,24,29,,,,1.21,0.71,0.98,1");
+    out += sentence("GPGSV,3,1,10,02,41,280,38,05,22,047,31,13,67,110,42,15,70,226,44,1");
+    out += sentence("GPGSV,3,2,10,18,35,306,36,20,11,070,27,23,19,162,33,24,48,311,40,1");
+    out += sentence("GPGSV,3,3,10,29,55,157,43,30,06,022,,1");
+
+    // Random walk of course and speed, position advanced by one second
+    course = fmod(course + unit(random) * 4 + 360, 360);
+    speedKnots = fmin(fmax(speedKnots + unit(random), 0), 70);
+    double meters = speedKnots * 1852 / 3600;
+    lat += meters * cos(course * M_PI / 180) / 111195;
+    lon += meters * sin(course * M_PI / 180) / (111195 * cos(lat * M_PI / 180));
+  }
+  return out;
+}
+
+double elapsed(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+Result runNmeaParser(const std::string &stream, uint32_t passes) {
+  Result result;
+  for (uint32_t pass = 0; pass < passes; pass++) {
+    NmeaParser parser;
+    bool record = pass == 0;
+    auto start = std::chrono::steady_clock::now();
+    for (char c : stream) {
+      if (parser.encode(c) & NMEA_LOCATION_UPDATED) {
+        const NmeaData &data = parser.getData();
+        result.sink += (uint32_t)data.latE6 + (uint32_t)data.lonE6 + data.speedCentiKnots;
+        if (record) result.fixes.push_back({ data.latE6, data.lonE6 });
+      }
+    }
+    result.seconds = fmin(result.seconds, elapsed(start));
+  }
+  return result;
+}
+
+Result runTinyGps(const std::string &stream, uint32_t passes) {
+  Result result;
+  for (uint32_t pass = 0; pass < passes; pass++) {
+    TinyGPSPlus gps;
+    bool record = pass == 0;
+    auto start = std::chrono::steady_clock::now();
+    for (char c : stream) {
+      if (gps.encode(c) && gps.location.isUpdated()) {
+        double lat = gps.location.lat(), lon = gps.location.lng();
+        result.sink += (uint64_t)(lat * 1e6) + (uint64_t)(lon * 1e6) + (uint64_t)gps.speed.kmph();
+        if (record) result.fixes.push_back({ (int32_t)lround(lat * 1e6), (int32_t)lround(lon * 1e6) });
+      }
+    }
+    result.seconds = fmin(result.seconds, elapsed(start));
+  }
+  return result;
+}
+
+void report(const char *name, const Result &result, size_t bytes) {
+  size_t fixes = result.fixes.size() > 0 ? result.fixes.size() : 1;
+  printf("%-12s %9.1f %9.2f %9.0f %8zu\n", name, bytes / result.seconds / 1e6, result.seconds * 1e9 / bytes,
+         result.seconds * 1e9 / fixes, result.fixes.size());
+}
+
+void usage() {
+  fprintf(stderr, "usage: nmea_bench [--epochs N] [--passes N] [capture.nmea]\n");
+  exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t epochs = 10000, passes = 20;
+  const char *path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--epochs") && hasValue) epochs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--passes") && hasValue) passes = atoi(argv[++i]);
+    else if (argv[i][0] != '-' && path == nullptr) path = argv[i];
+    else usage();
+  }
+  if (passes == 0) usage();
+
+  std::string stream;
+  if (path != nullptr) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) usage();
+    stream.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  } else {
+    stream = generate(epochs);
+  }
+  if (stream.empty()) usage();
+
+  Result ours = runNmeaParser(stream, passes), theirs = runTinyGps(stream, passes);
+
+  // Same fixes in the same order, to the microdegree (TinyGPSPlus goes
+  // through double, so allow one count of rounding)
+  size_t mismatches = ours.fixes.size() > theirs.fixes.size() ? ours.fixes.size() - theirs.fixes.size()
+                                                              : theirs.fixes.size() - ours.fixes.size();
+  for (size_t i = 0; i < ours.fixes.size() && i < theirs.fixes.size(); i++) {
+    if (abs(ours.fixes[i].latE6 - theirs.fixes[i].latE6) > 1 || abs(ours.fixes[i].lonE6 - theirs.fixes[i].lonE6) > 1) {
+      mismatches++;
+    }
+  }
+
+  printf("%zu bytes, best of %u passes\n", stream.size(), passes);
+  printf("%-12s %9s %9s %9s %8s\n", "parser", "MB/s", "ns/byte", "ns/fix", "fixes");
+  report("NmeaParser", ours, stream.size());
+  report("TinyGPSPlus", theirs, stream.size());
+  printf("speedup %.2fx, %zu mismatched fixes\n", theirs.seconds / ours.seconds, mismatches);
+
+  volatile uint64_t sink = ours.sink + theirs.sink;
+  (void)sink;
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Decode the binary telemetry stream of the v2 firmware (USE_TELEMETRY).
+
+Read the USB CDC port live (needs pyserial), or a capture of it:
+
+    telemetry_decode.py /dev/ttyACM0                  # summary every 5 s
+    telemetry_decode.py --capture run.bin /dev/ttyACM0
+    telemetry_decode.py --csv run.bin > run.csv
+    telemetry_decode.py --plot run.bin                # needs matplotlib
+
+The frame format is described at the top of v_da-code-V2/Telemetry.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+TELEM_FIX = 1
+TELEM_PROXIMITY = 2
+TELEM_STAGE = 3
+TELEM_OUTPUTS = 4
+
+STAGES = ["gps", "proximity", "ui"]
+DEVICES = ["led", "display", "buzzer"]
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code < 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse(frame):
+    """Record dict of one COBS frame (without the delimiter), None if damaged."""
+    data = cobs_decode(frame)
+    if data is None or len(data) < 7 or crc16(data[:-2]) != struct.unpack_from("<H", data, len(data) - 2)[0]:
+        return None
+    kind, time_us = struct.unpack_from("<BI", data)
+    body = data[5:-2]
+    record = {"time_us": time_us}
+    try:
+        if kind == TELEM_FIX:
+            lat, lon, mlat, mlon, speed, course, flags = struct.unpack("<iiiiHHB", body)
+            record.update(type="fix", lat=lat / 1e6, lon=lon / 1e6, measured_lat=mlat / 1e6,
+                          measured_lon=mlon / 1e6, speed_kmh=speed / 10, valid=flags & 1,
+                          course_deg="" if course == 0xFFFF else course / 100)
+        elif kind == TELEM_PROXIMITY:
+            radius, candidates, camera_limit, road_limit, in_range, us = struct.unpack("<HHBBBI", body)
+            record.update(type="proximity", radius_m=radius, candidates=candidates, camera_limit=camera_limit,
+                          road_limit=road_limit, in_range=in_range, evaluate_us=us)
+        elif kind == TELEM_STAGE:
+            stage, passes, total, maximum = struct.unpack("<BHII", body)
+            record.update(type="stage", stage=STAGES[stage] if stage < len(STAGES) else stage,
+                          passes=passes, total_us=total, max_us=maximum)
+        elif kind == TELEM_OUTPUTS:
+            counts = struct.unpack("<6I", body)
+            record.update(type="outputs")
+            for i, device in enumerate(DEVICES):
+                record[device + "_written"] = counts[2 * i]
+                record[device + "_elided"] = counts[2 * i + 1]
+        else:
+            return None
+    except struct.error:
+        return None
+    return record
+
+
+class Decoder:
+    """Split a byte stream on 0x00 delimiters; counts frames that fail to parse."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                return
+            frame = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if not frame:
+                continue
+            record = parse(frame)
+            if record is None:
+                self.bad += 1  # text on the port, or a frame cut by attaching mid-stream
+            else:
+                yield record
+
+
+class Summary:
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.fixes = 0
+        self.evaluations = 0
+        self.candidates = 0
+        self.max_candidates = 0
+        self.evaluate_us = 0
+        self.stages = {}
+        self.outputs = None
+        self.first_outputs = None
+
+    def add(self, record):
+        kind = record["type"]
+        if kind == "fix":
+            self.fixes += 1
+        elif kind == "proximity":
+            self.evaluations += 1
+            self.candidates += record["candidates"]
+            self.max_candidates = max(self.max_candidates, record["candidates"])
+            self.evaluate_us += record["evaluate_us"]
+        elif kind == "stage":
+            passes, total, maximum = self.stages.get(record["stage"], (0, 0, 0))
+            self.stages[record["stage"]] = (passes + record["passes"], total + record["total_us"],
+                                            max(maximum, record["max_us"]))
+        elif kind == "outputs":
+            self.first_outputs = self.first_outputs or record
+            self.outputs = record
+
+    def write(self, out, bad):
+        out.write("fixes %d, evaluations %d, bad frames %d\n" % (self.fixes, self.evaluations, bad))
+        if self.evaluations:
+            out.write("  candidates avg %.1f max %d, evaluate avg %.0f us\n"
+                      % (self.candidates / self.evaluations, self.max_candidates,
+                         self.evaluate_us / self.evaluations))
+        for stage, (passes, total, maximum) in sorted(self.stages.items(), key=lambda item: str(item[0])):
+            if passes:
+                out.write("  %-10s %7d passes avg %6.0f us max %6d us\n" % (stage, passes, total / passes, maximum))
+        if self.outputs:
+            out.write("  writes (written/elided in window):")
+            for device in DEVICES:
+                written = self.outputs[device + "_written"] - self.first_outputs[device + "_written"]
+                elided = self.outputs[device + "_elided"] - self.first_outputs[device + "_elided"]
+                out.write(" %s %d/%d" % (device, written, elided))
+            out.write("\n")
+        out.flush()
+
+
+def read_chunks(source, capture):
+    """Yield byte chunks of a capture file or a live serial port."""
+    if os.path.isfile(source):
+        with open(source, "rb") as f:
+            while True:
+                chunk = f.read(65536)
+                if not chunk:
+                    return
+                yield chunk
+    import serial  # pyserial, only needed for live ports
+    port = serial.Serial(source, timeout=0.2)
+    port.dtr = True  # the firmware only streams while the port is open
+    while True:
+        chunk = port.read(4096)
+        if capture:
+            capture.write(chunk)
+        yield chunk
+
+
+def write_csv(records, out):
+    columns = ["time_us", "type", "lat", "lon", "measured_lat", "measured_lon", "speed_kmh", "course_deg", "valid",
+               "radius_m", "candidates", "camera_limit", "road_limit", "in_range", "evaluate_us",
+               "stage", "passes", "total_us", "max_us"]
+    columns += [device + suffix for device in DEVICES for suffix in ("_written", "_elided")]
+    out.write(",".join(columns) + "\n")
+    for record in records:
+        out.write(",".join(str(record.get(column, "")) for column in columns) + "\n")
+
+
+def plot(records):
+    import matplotlib.pyplot as plt
+
+    stages = {}
+    proximity = []
+    for record in records:
+        seconds = record["time_us"] / 1e6
+        if record["type"] == "stage" and record["passes"]:
+            stages.setdefault(record["stage"], []).append(
+                (seconds, record["total_us"] / record["passes"], record["max_us"]))
+        elif record["type"] == "proximity":
+            proximity.append((seconds, record["candidates"], record["evaluate_us"]))
+
+    figure, (timing, candidates) = plt.subplots(2, 1, sharex=True)
+    for stage, points in sorted(stages.items(), key=lambda item: str(item[0])):
+        timing.plot([p[0] for p in points], [p[1] for p in points], label="%s avg" % stage)
+        timing.plot([p[0] for p in points], [p[2] for p in points], ":", label="%s max" % stage)
+    timing.set_ylabel("us per pass")
+    timing.legend()
+    candidates.plot([p[0] for p in proximity], [p[1] for p in proximity], ".", label="candidates")
+    candidates.plot([p[0] for p in proximity], [p[2] for p in proximity], ".", label="evaluate us")
+    candidates.set_xlabel("device time (s)")
+    candidates.legend()
+    figure.tight_layout()
+    plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="serial port or capture file")
+    parser.add_argument("--capture", help="also save the raw stream of a live port to this file")
+    parser.add_argument("--csv", action="store_true", help="write every record as CSV")
+    parser.add_argument("--plot", action="store_true", help="plot stage timings and proximity candidates")
+    parser.add_argument("--interval", type=float, default=5.0, help="seconds between live summaries")
+    args = parser.parse_args()
+
+    capture = open(args.capture, "wb") if args.capture else None
+    decoder = Decoder()
+    chunks = read_chunks(args.source, capture)
+    records = (record for chunk in chunks for record in decoder.feed(chunk))
+
+    if args.csv:
+        write_csv(records, sys.stdout)
+    elif args.plot:
+        plot(list(records))
+    else:
+        # Whole-file summary for a capture, rolling summaries for a live port
+        summary = Summary()
+        live = not os.path.isfile(args.source)
+        next_report = time.monotonic() + args.interval
+        try:
+            for record in records:
+                summary.add(record)
+                if live and time.monotonic() >= next_report:
+                    summary.write(sys.stdout, decoder.bad)
+                    summary.reset()
+                    next_report += args.interval
+        except KeyboardInterrupt:
+            pass
+        summary.write(sys.stdout, decoder.bad)
+
+
+if __name__ == "__main__":
+    main()
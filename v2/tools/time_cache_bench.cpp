@@ -0,0 +1,246 @@
+// Host benchmark of the BetterGPS Hungarian time getters: cost per loop()
+// pass with the old cache (1 s millis() expiry, dropped on every decoded
+// sentence) against the fix-epoch cache BetterGPS uses now.
+//
+// Build (host compiler, the Arduino core and UART stand-ins come from the
+// tests):
+//
+//     g++ -O2 -std=c++17 -I../../tests/host -I../../libraries/VdaCore/src -I../v_da-code-V2 time_cache_bench.cpp -o time_cache_bench
+//
+// Then:
+//
+//     time_cache_bench
+//     time_cache_bench --seconds 600 --loop-us 100
+//
+// A 10 Hz stream (RMC, VTG, GGA, GSA and three GSV per epoch) goes out on the
+// simulated UART at 38400 baud. Every --loop-us the loop parses what has
+// arrived and reads the hour, minute and second like a clock display. Prints
+// the getter cost per loop (wall time on this machine: best run with the
+// reads less best run without), the old cache's conversions per second, and
+// how many loops read a different second from the two caches.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "Better-GPS.h"
+
+namespace {
+
+const uint32_t EPOCH_MS = 100;
+const uint32_t BYTES_PER_SECOND = 3840;  // 38400 baud, 10 bits per byte
+
+std::string sentence(const char *body) {
+  uint8_t checksum = 0;
+  for (const char *c = body; *c != '\0'; c++) checksum ^= (uint8_t)*c;
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+  return std::string("$") + body + tail;
+}
+
+// One epoch of the receiver's output, dated 2024-06-15 10:20:30 UTC + epochMs
+std::string epoch(uint32_t epochMs) {
+  uint32_t s = 10 * 3600 + 20 * 60 + 30 + epochMs / 1000;
+  char time[16], body[160];
+  snprintf(time, sizeof(time), "%02u%02u%02u.%02u", s / 3600, s / 60 % 60, s % 60, epochMs % 1000 / 10);
+
+  std::string out;
+  snprintf(body, sizeof(body), "GNRMC,%s,A,4729.87472,N,01902.41410,E,27.000,90.00,150624,,,A,V", time);
+  out += sentence(body);
+  out += sentence("GNVTG,90.00,T,,M,27.000,N,50.004,K,A");
+  snprintf(body, sizeof(body), "GNGGA,%s,4729.87472,N,01902.41410,E,1,12,0.71,120.5,M,40.2,M,,", time);
+  out += sentence(body);
+  out += sentence("GNGSA,A,3,02,05,13,15,18,20,23,24,29,,,,1.21,0.71,0.98,1");
+  out += sentence("GPGSV,3,1,10,02,41,280,38,05,22,047,31,13,67,110,42,15,70,226,44,1");
+  out += sentence("GPGSV,3,2,10,18,35,306,36,20,11,070,27,23,19,162,33,24,48,311,40,1");
+  out += sentence("GPGSV,3,3,10,29,55,157,43,30,06,022,,1");
+  return out;
+}
+
+// The cache BetterGPS had before the fix-epoch key: valid for 1 s of
+// millis(), dropped whenever encode() completes a sentence, rebuilt from the
+// last sentence's UTC fields
+class MillisExpiryTime {
+private:
+  HardwareSerial uart;
+  NmeaParser nmea;
+  bool valid = false;
+  unsigned long lastUpdate = 0;
+  int hour = 0, minute = 0, second = 0;
+
+  void rebuild() {
+    const NmeaData &data = nmea.getData();
+    int64_t utc = HungarianTime::toEpochSeconds(data.year(), data.month(), data.day(), data.hour(), data.minute(),
+                                                data.second());
+    int64_t local = utc + HungarianTime::utcOffsetSeconds(data.year(), utc);
+    int32_t days = HungarianTime::floorDiv(local, 86400);
+    int year, month, day;
+    HungarianTime::civilFromDays(days, year, month, day);
+    int32_t secondsOfDay = (int32_t)(local - (int64_t)days * 86400);
+    hour = secondsOfDay / 3600;
+    minute = secondsOfDay / 60 % 60;
+    second = secondsOfDay % 60;
+    valid = true;
+    lastUpdate = millis();
+    rebuilds++;
+  }
+
+  void refresh() {
+    if (!valid || millis() - lastUpdate >= 1000) rebuild();
+  }
+
+public:
+  uint32_t rebuilds = 0;
+
+  MillisExpiryTime()
+    : uart(1) {}
+
+  void update() {
+    while (uart.available()) {
+      if (nmea.encode(uart.read())) valid = false;
+    }
+  }
+
+  byte getHour() {
+    refresh();
+    return hour;
+  }
+
+  byte getMinute() {
+    refresh();
+    return minute;
+  }
+
+  byte getSecond() {
+    refresh();
+    return second;
+  }
+};
+
+// The whole stream with the time each byte's stop bit goes out
+struct Line {
+  std::string bytes;
+  std::vector<uint64_t> arrivalUs;
+};
+
+Line transmit(uint32_t seconds) {
+  Line line;
+  const uint64_t BYTE_US = 1000000 / BYTES_PER_SECOND;
+  for (uint32_t epochMs = 0; epochMs < seconds * 1000; epochMs += EPOCH_MS) {
+    uint64_t at = (uint64_t)epochMs * 1000;
+    for (char c : epoch(epochMs)) {
+      line.bytes += c;
+      line.arrivalUs.push_back(at += BYTE_US);
+    }
+  }
+  return line;
+}
+
+struct Run {
+  double ns = 0;
+  uint32_t loops = 0;
+  uint32_t differing = 0;  // loops whose second differs from the reference
+  uint32_t rebuilds = 0;
+};
+
+// BetterGPS does not count its conversions
+uint32_t rebuildsOf(const BetterGPS &) {
+  return 0;
+}
+
+uint32_t rebuildsOf(const MillisExpiryTime &gps) {
+  return gps.rebuilds;
+}
+
+double nowNs() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Run loop() every loopUs over the line on UART 1; Gps is BetterGPS or
+// MillisExpiryTime. With readTime the loop reads the clock display fields,
+// and the seconds read are compared with (or, if empty, stored in) reference.
+template<typename Gps>
+Run simulate(const Line &line, uint32_t loopUs, bool readTime, std::vector<uint8_t> &reference) {
+  HostArduino::reset();
+  Gps gps;
+  HardwareSerial &uart = *HardwareSerial::port(1);
+  Run run;
+  size_t sent = 0;
+  uint64_t endUs = line.arrivalUs.back() + loopUs;
+  bool storing = reference.empty();
+  volatile uint32_t sink = 0;
+
+  double start = nowNs();
+  for (uint64_t t = 0; t < endUs; t += loopUs) {
+    HostArduino::clockUs = t;
+    size_t from = sent;
+    while (sent < line.bytes.size() && line.arrivalUs[sent] <= t) sent++;
+    uart.receive((const uint8_t *)line.bytes.data() + from, sent - from);
+
+    gps.update();
+    if (readTime) {
+      uint8_t second = gps.getSecond();
+      sink = sink + gps.getHour() + gps.getMinute();
+      if (storing) reference.push_back(second);
+      else if (run.loops < reference.size()) run.differing += reference[run.loops] != second;
+    }
+    run.loops++;
+  }
+  run.ns = nowNs() - start;
+  run.rebuilds = rebuildsOf(gps);
+  return run;
+}
+
+// Getter cost per loop: best run with the reads less best run without (the
+// parsing and the simulation itself)
+template<typename Gps>
+double getterNsPerLoop(const Line &line, uint32_t loopUs, uint32_t repeats, std::vector<uint8_t> &reference,
+                       Run &reading) {
+  double with = 1e300, without = 1e300;
+  for (uint32_t i = 0; i < repeats; i++) {
+    std::vector<uint8_t> none;
+    without = std::min(without, simulate<Gps>(line, loopUs, false, none).ns);
+    reading = simulate<Gps>(line, loopUs, true, reference);
+    with = std::min(with, reading.ns);
+  }
+  return (with - without) / reading.loops;
+}
+
+void usage() {
+  fprintf(stderr, "usage: time_cache_bench [--seconds N] [--loop-us N] [--repeats N]\n");
+  exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t seconds = 120, loopUs = 200, repeats = 5;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--seconds") && hasValue) seconds = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--loop-us") && hasValue) loopUs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--repeats") && hasValue) repeats = atoi(argv[++i]);
+    else usage();
+  }
+  if (seconds == 0 || loopUs == 0 || repeats == 0) usage();
+
+  Line line = transmit(seconds);
+  std::vector<uint8_t> reference;  // seconds read through the fix-epoch cache
+  Run after, before;
+  double afterNs = getterNsPerLoop<BetterGPS>(line, loopUs, repeats, reference, after);
+  double beforeNs = getterNsPerLoop<MillisExpiryTime>(line, loopUs, repeats, reference, before);
+
+  printf("%u s at 10 Hz, %zu bytes, loop every %u us, %u loops, best of %u\n", seconds, line.bytes.size(), loopUs,
+         after.loops, repeats);
+  printf("%-18s %10s %14s\n", "cache", "ns/loop", "rebuilds/s");
+  printf("%-18s %10.1f %14.1f\n", "millis() expiry", beforeNs, (double)before.rebuilds / seconds);
+  printf("%-18s %10.1f %14s\n", "fix epoch", afterNs, "-");
+  printf("%u loops (%.2f%%) read another second through the old cache, which lags until the next sentence\n",
+         before.differing, 100.0 * before.differing / before.loops);
+  return 0;
+}
@@ -1,16 +1,138 @@
 #pragma once
 
-#include <TinyGPSPlus.h>
 #include <HardwareSerial.h>
 #include "constants.h"
+#include "SpscRing.h"
+#include "RxArrival.h"
+#include "NmeaParser.h"
+#include "GpsFix.h"
+
+// ---------------------------------------------- Hungarian time zone ----------------------------------------------
+
+// CET (UTC+1) with CEST (UTC+2) between the last Sunday of March 01:00 UTC
+// and the last Sunday of October 01:00 UTC. Transition instants for
+// FIRST_YEAR..LAST_YEAR are generated at compile time; other years fall back
+// to the same calendar math at runtime.
+namespace HungarianTime {
+constexpr int FIRST_YEAR = 2020;
+constexpr int LAST_YEAR = 2100;
+constexpr int YEAR_COUNT = LAST_YEAR - FIRST_YEAR + 1;
+
+constexpr int32_t floorDiv(int64_t a, int32_t b) {
+  return (int32_t)(a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+constexpr int32_t daysFromCivil(int year, int month, int day) {
+  int y = year - (month <= 2 ? 1 : 0);
+  int era = (y >= 0 ? y : y - 399) / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Inverse of daysFromCivil
+inline void civilFromDays(int32_t days, int &year, int &month, int &day) {
+  days += 719468;
+  int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+  int32_t doe = days - era * 146097;
+  int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int32_t mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+// 0=Sunday, 1=Monday, ..., 6=Saturday (1970-01-01 was a Thursday)
+constexpr int dayOfWeek(int32_t days) {
+  return days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6;
+}
+
+constexpr int64_t toEpochSeconds(int year, int month, int day, int hour, int minute, int second) {
+  return (int64_t)daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// 01:00 UTC on the last Sunday of the month (March and October both have 31 days)
+constexpr int64_t lastSundayTransition(int year, int month) {
+  int32_t lastDay = daysFromCivil(year, month, 31);
+  return (int64_t)(lastDay - dayOfWeek(lastDay)) * 86400 + 3600;
+}
+
+struct DstTable {
+  uint32_t start[YEAR_COUNT];
+  uint32_t end[YEAR_COUNT];
+
+  constexpr DstTable()
+    : start(), end() {
+    for (int i = 0; i < YEAR_COUNT; i++) {
+      start[i] = (uint32_t)lastSundayTransition(FIRST_YEAR + i, 3);
+      end[i] = (uint32_t)lastSundayTransition(FIRST_YEAR + i, 10);
+    }
+  }
+};
+
+constexpr DstTable DST_TABLE{};
+
+static_assert(DST_TABLE.start[0] == 1585443600UL, "DST start 2020-03-29 01:00 UTC");
+static_assert(DST_TABLE.end[YEAR_COUNT - 1] == 4128627600UL, "DST end 2100-10-31 01:00 UTC");
+
+// UTC offset in seconds for a UTC instant of the given (UTC) year
+inline int32_t utcOffsetSeconds(int year, int64_t utc) {
+  if (year >= FIRST_YEAR && year <= LAST_YEAR) {
+    int i = year - FIRST_YEAR;
+    return (utc >= DST_TABLE.start[i] && utc < DST_TABLE.end[i]) ? 7200 : 3600;
+  }
+  return (utc >= lastSundayTransition(year, 3) && utc < lastSundayTransition(year, 10)) ? 7200 : 3600;
+}
+}
 
 class BetterGPS {
 private:
   HardwareSerial gpsSerial;
-  TinyGPSPlus gps;
-  const int GPS_CACHE_VALIDITY_MS = 1000;
+  NmeaParser nmea;
+  bool locationFresh = false;  // NMEA_LOCATION_UPDATED seen since the last getFix()
+
+  // UART capture: the receive callback (UART event task, triggered by the RX
+  // FIFO threshold or line idle) moves bytes into rxRing, update() parses them
+  // in batches. 4 KB holds over a second of NMEA at 38400 baud, enough to ride
+  // out the blocking sections in loop().
+  static const size_t RX_RING_SIZE = 4096;
+  static const size_t UART_RX_BUFFER_SIZE = 1024;
+  static const size_t PARSE_BATCH_SIZE = 64;
+  SpscRing<uint8_t, RX_RING_SIZE> rxRing;
+  volatile uint32_t uartErrorCount = 0;
+  bool captureActive = false;
+
+  // Arrival time of every chunk moved into rxRing, so sentences can be dated
+  // by when their last byte arrived rather than when update() parsed them
+  static const size_t RX_MARK_RING_SIZE = 64;
+  RxArrival<RX_MARK_RING_SIZE> rxArrival;
+  uint32_t locationRxMicros = 0;  // arrival of the sentence behind the current position
+
+  // Move everything the UART driver holds into the ring (producer side)
+  void captureRx() {
+    uint8_t chunk[PARSE_BATCH_SIZE];
+    size_t n;
+    while ((n = gpsSerial.available()) > 0) {
+      if (n > sizeof(chunk)) n = sizeof(chunk);
+      n = gpsSerial.read(chunk, n);
+      if (n == 0) break;
+      rxArrival.captured(rxRing.pushBurst(chunk, n), micros());
+    }
+  }
+
+  // Fix epoch: UTC time of the last time-bearing sentence and the millis() it arrived at
+  uint32_t fixTimeKey = 0xFFFFFFFF;
+  unsigned long fixMillis = 0;
+  bool fixEpochDirty = false;
+  bool fixEpochValid = false;
+  int fixYear = 0;
+  int64_t fixEpochMs = 0;
 
-  // Cache for Hungarian time to avoid repeated calculations
+  // Cache for Hungarian time, keyed on the UTC second it was computed for
+  // and valid until millis() reaches secondEndMillis
   struct HungarianTimeCache {
     int year;
     int month;
@@ -20,185 +142,81 @@ private:
     int minute;
     int second;
     bool valid;
-    unsigned long lastUpdate;
+    int64_t utcSecond;
+    unsigned long secondEndMillis;
   } timeCache;
 
-  // Zeller's Congruence to calculate day of the week
-  int calculateDayOfWeek(int y, int m, int d) {
-    if (m < 3) {
-      m += 12;
-      y -= 1;
-    }
-    int k = y % 100;
-    int j = y / 100;
-    int f = d + 13 * (m + 1) / 5 + k + k / 4 + j / 4 + 5 * j;
-
-    // Correct Zeller's result: 0=Saturday, 1=Sunday, 2=Monday, etc.
-    // Convert to standard: 0=Sunday, 1=Monday, 2=Tuesday, ..., 6=Saturday
-    return (f + 1) % 7;
-  }
+  // Convert a UTC instant to Hungarian local time (one table lookup plus one add)
+  void convertToHungarianTime(int64_t utc, int utcYear, int &year, int &month, int &day, int &dayIndex, int &hour, int &minute, int &second) {
+    int64_t local = utc + HungarianTime::utcOffsetSeconds(utcYear, utc);
 
-  // Check if it's daylight saving time in Hungary (CEST)
-  // DST starts last Sunday in March at 2:00 AM
-  // DST ends last Sunday in October at 3:00 AM
-  bool isDaylightSavingTime(int year, int month, int day, int hour) {
-    // Before March or after October - definitely standard time
-    if (month < 3 || month > 10) {
-      return false;
-    }
-
-    // April to September - definitely daylight saving time
-    if (month > 3 && month < 10) {
-      return true;
-    }
-
-    // March - need to check if we're past the last Sunday
-    if (month == 3) {
-      // Find the last Sunday of March
-      int lastSunday = 31;
-      while (calculateDayOfWeek(year, 3, lastSunday) != 0) {
-        lastSunday--;
-      }
-
-      if (day < lastSunday) {
-        return false;  // Before DST starts
-      } else if (day > lastSunday) {
-        return true;  // After DST starts
-      } else {
-        // On the last Sunday - DST starts at 2:00 AM UTC (3:00 AM CET)
-        return hour >= 1;  // 1:00 UTC = 2:00 CET when DST starts
-      }
-    }
-
-    // October - need to check if we're before the last Sunday
-    if (month == 10) {
-      // Find the last Sunday of October
-      int lastSunday = 31;
-      while (calculateDayOfWeek(year, 10, lastSunday) != 0) {
-        lastSunday--;
-      }
+    int32_t days = HungarianTime::floorDiv(local, 86400);
+    int32_t secondsOfDay = (int32_t)(local - (int64_t)days * 86400);
 
-      if (day < lastSunday) {
-        return true;  // Before DST ends
-      } else if (day > lastSunday) {
-        return false;  // After DST ends
-      } else {
-        // On the last Sunday - DST ends at 3:00 AM CEST (1:00 AM UTC)
-        return hour < 1;  // Before 1:00 UTC (2:00 AM CET when DST ends)
-      }
-    }
-
-    return false;
+    HungarianTime::civilFromDays(days, year, month, day);
+    dayIndex = HungarianTime::dayOfWeek(days);
+    hour = secondsOfDay / 3600;
+    minute = (secondsOfDay / 60) % 60;
+    second = secondsOfDay % 60;
   }
 
-  // Get Hungarian timezone offset (+1 CET, +2 CEST)
-  int getHungarianTimezoneOffset(int year, int month, int day, int hour) {
-    return isDaylightSavingTime(year, month, day, hour) ? 2 : 1;
+  // Bring the cache up to date. The fix epoch is decoded at most once per new
+  // fix; between fixes the time advances by the millis() elapsed since the fix
+  // arrived, and the calendar fields are only rebuilt when the second changes.
+  void refreshTimeCache() {
+    // Same fix and still inside the cached second: nothing to do
+    if (timeCache.valid && !fixEpochDirty && (long)(millis() - timeCache.secondEndMillis) < 0) {
+      return;
+    }
+    rebuildTimeCache();
   }
 
-  // Convert UTC time to Hungarian local time
-  void convertToHungarianTime(int &year, int &month, int &day, int &hour, int &minute, int &second) {
-    // First, get the timezone offset based on UTC time
-    int offset = getHungarianTimezoneOffset(year, month, day, hour);
-
-    // Add the offset to the hour
-    hour += offset;
-
-    // Handle day overflow
-    if (hour >= 24) {
-      hour -= 24;
-      day++;
-
-      // Days in each month
-      int daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
-      // Check for leap year
-      bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-      if (isLeapYear) daysInMonth[1] = 29;
-
-      // Handle month overflow
-      if (day > daysInMonth[month - 1]) {
-        day = 1;
-        month++;
-
-        // Handle year overflow
-        if (month > 12) {
-          month = 1;
-          year++;
-        }
-      }
+  void rebuildTimeCache() {
+    if (!hasFix()) {
+      timeCache.valid = false;
+      return;
     }
 
-    // Handle day underflow
-    else if (hour < 0) {
-      hour += 24;
-      day--;
-
-      // Handle day underflow
-      if (day < 1) {
-        month--;
-
-        // Handle month underflow
-        if (month < 1) {
-          month = 12;
-          year--;
-        }
-
-        // Days in each month
-        int daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
-        // Check for leap year
-        bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-        if (isLeapYear) daysInMonth[1] = 29;
-
-        day = daysInMonth[month - 1];
-      }
+    const NmeaData &data = nmea.getData();
+    if (fixEpochDirty && data.dateValid) {
+      fixYear = data.year();
+      fixEpochMs = HungarianTime::toEpochSeconds(fixYear, data.month(), data.day(),
+                                                 data.hour(), data.minute(), data.second())
+                     * 1000
+                   + data.centisecond() * 10;
+      fixEpochDirty = false;
+      fixEpochValid = true;
     }
-  }
 
-  // Update the cache with fresh Hungarian time calculation
-  void updateTimeCache() {
-    if (!hasFix()) {
+    if (!fixEpochValid) {
       timeCache.valid = false;
       return;
     }
 
-    // Get UTC time from GPS
-    int year = gps.date.year();
-    int month = gps.date.month();
-    int day = gps.date.day();
-    int hour = gps.time.hour();
-    int minute = gps.time.minute();
-    int second = gps.time.second();
-
-    // Convert to Hungarian time
-    convertToHungarianTime(year, month, day, hour, minute, second);
-
-    // Update cache
-    timeCache.year = year;
-    timeCache.month = month;
-    timeCache.day = day;
-    timeCache.hour = hour;
-    timeCache.minute = minute;
-    timeCache.second = second;
-    timeCache.dayIndex = calculateDayOfWeek(year, month, day);
-    timeCache.valid = true;
-    timeCache.lastUpdate = millis();
-  }
+    int64_t utcSecond = (fixEpochMs + (unsigned long)(millis() - fixMillis)) / 1000;
+    timeCache.secondEndMillis = fixMillis + (unsigned long)((utcSecond + 1) * 1000 - fixEpochMs);
+    if (timeCache.valid && timeCache.utcSecond == utcSecond) {
+      return;
+    }
 
-  // Check if cache is still valid
-  bool isCacheValid() {
-    return timeCache.valid && (millis() - timeCache.lastUpdate < GPS_CACHE_VALIDITY_MS);
+    convertToHungarianTime(utcSecond, fixYear, timeCache.year, timeCache.month, timeCache.day,
+                           timeCache.dayIndex, timeCache.hour, timeCache.minute, timeCache.second);
+    timeCache.utcSecond = utcSecond;
+    timeCache.valid = true;
   }
 
 public:
   BetterGPS()
     : gpsSerial(1) {
     timeCache.valid = false;
-    timeCache.lastUpdate = 0;
+    timeCache.utcSecond = 0;
+    timeCache.secondEndMillis = 0;
   }
 
   void begin(byte gpsRx, byte gpsTx = -1, int gpsBaud = 38400) {
+    // Must be set before the driver is installed
+    gpsSerial.setRxBufferSize(UART_RX_BUFFER_SIZE);
+
     // Try multiple baud rates for compatibility
     int baudRates[] = { 38400, 9600, 57600, 115200 };
     bool foundBaud = false;
@@ -313,31 +331,115 @@ public:
     }
 
     delay(500);  // Allow GPS to stabilize
+
+    // Hand reception over to the capture callback
+    gpsSerial.onReceiveError([this](hardwareSerial_error_t error) {
+      if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR) {
+        uartErrorCount = uartErrorCount + 1;
+      }
+    });
+    gpsSerial.onReceive([this]() {
+      captureRx();
+    });
+    captureActive = true;
   }
 
   void update() {
-    while (gpsSerial.available()) {
-      if (gps.encode(gpsSerial.read())) {
-        // New data available, invalidate cache
-        timeCache.valid = false;
+    // Without the capture callback (begin() not run) read the UART directly
+    if (!captureActive) {
+      captureRx();
+    }
+
+    uint8_t batch[PARSE_BATCH_SIZE];
+    size_t n;
+    while ((n = rxRing.popBatch(batch, sizeof(batch))) > 0) {
+      for (size_t i = 0; i < n; i++) {
+        rxArrival.parsed();
+        uint8_t updated = nmea.encode(batch[i]);
+        if (updated & NMEA_LOCATION_UPDATED) {
+          locationFresh = true;
+          locationRxMicros = rxArrival.lastArrival(micros());
+        }
+        if (updated & NMEA_TIME_UPDATED) {
+          // A new fix epoch starts when the reported UTC time changes
+          uint32_t timeKey = nmea.getData().time;
+          if (timeKey != fixTimeKey) {
+            fixTimeKey = timeKey;
+            fixMillis = millis();
+            fixEpochDirty = true;
+          }
+        }
       }
     }
   }
 
+  // ---------------------------------------------- Receive statistics ----------------------------------------------
+
+  // Bytes lost because rxRing was full when the capture callback ran
+  uint32_t getRxOverflowCount() {
+    return rxRing.getDroppedCount();
+  }
+
+  // UART driver buffer / hardware FIFO overflows reported by the core
+  uint32_t getUartOverflowCount() {
+    return uartErrorCount;
+  }
+
+  // Highest rxRing fill level seen, in bytes
+  uint32_t getRxHighWater() {
+    return rxRing.getHighWater();
+  }
+
+  // RMC / GGA decoded, dropped on checksum, other sentences skipped
+  const NmeaStats &getNmeaStats() {
+    return nmea.getStats();
+  }
+
+
+  // True while the receiver reports a fix (RMC status A / GGA quality > 0)
   bool hasFix() {
-    return gps.location.isValid();
+    return nmea.getData().locationValid;
   }
 
   double getLatitude() {
-    return gps.location.lat();
+    return nmea.getData().latE6 / 1e6;
   }
 
   double getLongitude() {
-    return gps.location.lng();
+    return nmea.getData().lonE6 / 1e6;
   }
 
   double getSpeedKmph() {
-    return gps.speed.kmph();
+    return nmea.getData().speedCentiKnots * 0.01852;
+  }
+
+  // Height above the WGS84 ellipsoid in 0.1 m (GGA)
+  int32_t getAltitudeDm() {
+    return nmea.getData().altitudeDm;
+  }
+
+  // Current UTC in ms since 1970 from the last fix epoch, false before the first dated fix
+  bool getUtcMs(int64_t &utcMs) {
+    refreshTimeCache();
+    if (!fixEpochValid) return false;
+    utcMs = fixEpochMs + (unsigned long)(millis() - fixMillis);
+    return true;
+  }
+
+  // Send prepared UBX frames (e.g. aiding) to the receiver
+  void sendUbx(const uint8_t *frames, size_t length) {
+    gpsSerial.write(frames, length);
+    gpsSerial.flush();
+  }
+
+  // Fill fix with the current position/speed. Returns true if the location
+  // was updated since the previous call.
+  bool getFix(GpsFix &fix) {
+    bool fresh = locationFresh;
+    locationFresh = false;
+
+    fix = fixFromNmea(nmea.getData(), millis(), locationRxMicros);
+    return fresh;
   }
 
   // Function that calculates Hungarian time once and fills all values
@@ -347,10 +449,7 @@ public:
       return;
     }
 
-    // Check if we need to update the cache
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
 
     // Return cached values
     if (timeCache.valid) {
@@ -368,51 +467,37 @@ public:
 
   // Optimized getter functions - use cache instead of recalculating
   int getYear() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.year : 0;
   }
 
   byte getMonth() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.month : 0;
   }
 
   byte getDay() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.day : 0;
   }
 
   byte getHour() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.hour : 0;
   }
 
   byte getMinute() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.minute : 0;
   }
 
   byte getSecond() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.second : 0;
   }
 
   byte getDayIndex() {
-    if (!isCacheValid()) {
-      updateTimeCache();
-    }
+    refreshTimeCache();
     return timeCache.valid ? timeCache.dayIndex : 0;
   }
 };
\ No newline at end of file
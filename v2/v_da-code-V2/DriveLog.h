@@ -0,0 +1,344 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_partition.h>
+#endif
+
+// Append-only drive log in the "drivelog" flash partition (see partitions.csv).
+//
+// The partition is used as a ring of 4 KB sectors, each starting with an
+// 8 byte header { magic, sequence }. Writing always moves forward to the next
+// sector, so every sector is erased equally often. Sectors are written in
+// 256 byte pages; records never cross a page and every page starts from a
+// zero base (time, lat, lon), so each page decodes on its own.
+//
+// Record: tag byte (type in the low 3 bits, flags in the high 5 bits),
+// varint ms since the previous record on the page, then the payload:
+//   LOG_FIX         zigzag dLat, zigzag dLon (microdegrees), varint speed (0.1 km/h),
+//                   with LOG_FLAG_COURSE varint course (0.01 degree)
+//   LOG_EVENT       event code byte, zigzag value
+//   LOG_LOOP_STATS  varint average us, varint max us, varint loop count
+// Unwritten flash (0xFF) ends a page. tools/drivelog_decode.py turns a
+// partition dump into CSV / GPX.
+//
+// Sector erases (tens of ms) can run ahead of the writer in a low priority
+// task: begin(true), then call eraseAhead() from that task. The sector after
+// the one being filled is then erased while the current one fills up, which
+// costs one sector of the oldest history; service() only writes pages.
+
+enum DriveLogRecord : uint8_t {
+  LOG_FIX = 1,
+  LOG_EVENT = 2,
+  LOG_LOOP_STATS = 3
+};
+
+// Fix flags (5 bits)
+constexpr uint8_t LOG_FLAG_VALID = 0x01;
+constexpr uint8_t LOG_FLAG_PROXIMITY = 0x02;
+constexpr uint8_t LOG_FLAG_OVERSPEED = 0x04;
+constexpr uint8_t LOG_FLAG_COURSE = 0x08;  // course follows the speed
+
+enum DriveLogEvent : uint8_t {
+  LOG_EVENT_BOOT = 1,         // value: 0
+  LOG_EVENT_ALERT_STATE = 2,  // value: AlertState
+  LOG_EVENT_ALERT_CUE = 3,    // value: AlertCue
+  LOG_EVENT_SPEED_LIMIT = 4   // value: km/h, 0 = none
+};
+
+class DriveLog {
+private:
+  static const uint32_t SECTOR_SIZE = 4096;
+  static const uint32_t PAGE_SIZE = 256;
+  static const uint32_t PAGES_PER_SECTOR = SECTOR_SIZE / PAGE_SIZE;
+  static const uint32_t HEADER_SIZE = 8;
+  static const uint32_t MAGIC = 0x314C4456;  // "VDL1"
+  static const uint32_t MAX_RECORD_SIZE = 1 + 5 + 5 + 5 + 5 + 5;
+  static const uint32_t NO_SECTOR = 0xFFFFFFFF;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  const esp_partition_t *partition = nullptr;
+#else
+  // Host builds log into RAM with NOR flash semantics (erase to 0xFF, writes clear bits)
+  static const uint32_t HOST_FLASH_SIZE = 16 * SECTOR_SIZE;
+  uint8_t hostFlash[HOST_FLASH_SIZE];
+#endif
+
+  uint32_t sectorCount = 0;
+
+  // Page being filled and page waiting for flash (double buffer)
+  uint8_t pages[2][PAGE_SIZE];
+  uint8_t fillIndex = 0;
+  uint32_t fillPos = 0;
+  bool pendingReady = false;
+  uint32_t pendingPage = 0;  // absolute page number the pending buffer goes to
+  bool pendingErased = false;
+
+  uint32_t nextPage = 0;     // absolute page number of the page being filled
+  uint32_t sequence = 0;     // header sequence of the sector being filled
+
+  // Delta bases, reset at each page start
+  uint32_t lastTimeMs = 0;
+  int32_t lastLatE6 = 0;
+  int32_t lastLonE6 = 0;
+
+  // Erase handoff with the erase task: the sector the writer needs next and
+  // the last one the task finished
+  bool backgroundErase = false;
+  std::atomic<uint32_t> eraseWanted{ NO_SECTOR };
+  std::atomic<uint32_t> erasedSector{ NO_SECTOR };
+
+  uint32_t droppedRecords = 0;
+  uint32_t pagesWritten = 0;
+
+  bool readFlash(uint32_t offset, void *data, uint32_t len) {
+#if defined(ARDUINO_ARCH_ESP32)
+    return esp_partition_read(partition, offset, data, len) == ESP_OK;
+#else
+    memcpy(data, hostFlash + offset, len);
+    return true;
+#endif
+  }
+
+  bool writeFlash(uint32_t offset, const void *data, uint32_t len) {
+#if defined(ARDUINO_ARCH_ESP32)
+    return esp_partition_write(partition, offset, data, len) == ESP_OK;
+#else
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (uint32_t i = 0; i < len; i++) hostFlash[offset + i] &= bytes[i];
+    return true;
+#endif
+  }
+
+  bool eraseSector(uint32_t sector) {
+#if defined(ARDUINO_ARCH_ESP32)
+    return esp_partition_erase_range(partition, sector * SECTOR_SIZE, SECTOR_SIZE) == ESP_OK;
+#else
+    memset(hostFlash + sector * SECTOR_SIZE, 0xFF, SECTOR_SIZE);
+    return true;
+#endif
+  }
+
+  static void put32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+  }
+
+  static uint32_t get32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+  }
+
+  static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  }
+
+  void putVarint(uint32_t value) {
+    uint8_t *page = pages[fillIndex];
+    while (value >= 0x80) {
+      page[fillPos++] = (uint8_t)(value | 0x80);
+      value >>= 7;
+    }
+    page[fillPos++] = (uint8_t)value;
+  }
+
+  // Start filling a fresh page; sector-first pages get the sector header
+  void openPage() {
+    uint8_t *page = pages[fillIndex];
+    memset(page, 0xFF, PAGE_SIZE);
+    fillPos = 0;
+
+    if (nextPage % PAGES_PER_SECTOR == 0) {
+      sequence++;
+      put32(page, MAGIC);
+      put32(page + 4, sequence);
+      fillPos = HEADER_SIZE;
+    }
+
+    lastTimeMs = 0;
+    lastLatE6 = 0;
+    lastLonE6 = 0;
+  }
+
+  // Hand the filled page to service(); false if the previous page is still waiting
+  bool sealPage() {
+    if (pendingReady) {
+      return false;
+    }
+
+    pendingPage = nextPage;
+    pendingErased = false;
+    pendingReady = true;
+    fillIndex ^= 1;
+    nextPage = (nextPage + 1) % (sectorCount * PAGES_PER_SECTOR);
+    openPage();
+    return true;
+  }
+
+  // Make room for one record; returns false (record dropped) when flash is behind
+  bool reserve() {
+    if (sectorCount == 0) {
+      return false;
+    }
+    if (fillPos + MAX_RECORD_SIZE > PAGE_SIZE && !sealPage()) {
+      droppedRecords++;
+      return false;
+    }
+    return true;
+  }
+
+  void putHeader(DriveLogRecord type, uint8_t flags, uint32_t timeMs) {
+    pages[fillIndex][fillPos++] = (uint8_t)(type | (flags << 3));
+    putVarint(timeMs >= lastTimeMs ? timeMs - lastTimeMs : 0);  // 0 if millis() wrapped
+    lastTimeMs = timeMs;
+  }
+
+public:
+#if !defined(ARDUINO_ARCH_ESP32)
+  // Blank RAM flash; it keeps its contents across begin() like flash across a reboot
+  DriveLog() {
+    memset(hostFlash, 0xFF, sizeof(hostFlash));
+  }
+#endif
+
+  // Find the partition and continue after the newest sector. Returns false if
+  // there is no drivelog partition (logging is then a no-op). With
+  // eraseInTask, service() leaves erasing to eraseAhead().
+  bool begin(bool eraseInTask = false) {
+#if defined(ARDUINO_ARCH_ESP32)
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "drivelog");
+    if (partition == nullptr) {
+      return false;
+    }
+    sectorCount = partition->size / SECTOR_SIZE;
+#else
+    sectorCount = HOST_FLASH_SIZE / SECTOR_SIZE;
+#endif
+
+    // Newest sector = highest sequence; start in the sector after it
+    uint32_t newestSector = sectorCount - 1;
+    sequence = 0;
+    for (uint32_t sector = 0; sector < sectorCount; sector++) {
+      uint8_t header[HEADER_SIZE];
+      if (readFlash(sector * SECTOR_SIZE, header, HEADER_SIZE) && get32(header) == MAGIC && get32(header + 4) != 0xFFFFFFFF
+          && get32(header + 4) > sequence) {
+        sequence = get32(header + 4);
+        newestSector = sector;
+      }
+    }
+
+    fillIndex = 0;
+    pendingReady = false;
+    nextPage = ((newestSector + 1) % sectorCount) * PAGES_PER_SECTOR;
+    openPage();
+
+    backgroundErase = eraseInTask;
+    erasedSector.store(NO_SECTOR);
+    eraseWanted.store(nextPage / PAGES_PER_SECTOR);
+    return true;
+  }
+
+  void logFix(uint32_t timeMs, int32_t latE6, int32_t lonE6, uint16_t speedKmhX10, uint8_t flags, uint16_t courseCdeg = 0) {
+    if (!reserve()) return;
+
+    putHeader(LOG_FIX, flags & 0x1F, timeMs);
+    putVarint(zigzag(latE6 - lastLatE6));
+    putVarint(zigzag(lonE6 - lastLonE6));
+    putVarint(speedKmhX10);
+    if (flags & LOG_FLAG_COURSE) putVarint(courseCdeg);
+    lastLatE6 = latE6;
+    lastLonE6 = lonE6;
+  }
+
+  void logEvent(uint32_t timeMs, DriveLogEvent event, int32_t value) {
+    if (!reserve()) return;
+
+    putHeader(LOG_EVENT, 0, timeMs);
+    pages[fillIndex][fillPos++] = event;
+    putVarint(zigzag(value));
+  }
+
+  void logLoopStats(uint32_t timeMs, uint32_t averageUs, uint32_t maxUs, uint32_t loops) {
+    if (!reserve()) return;
+
+    putHeader(LOG_LOOP_STATS, 0, timeMs);
+    putVarint(averageUs);
+    putVarint(maxUs);
+    putVarint(loops);
+  }
+
+  // Seal the partly filled page so it reaches flash (signal loss, mode
+  // change, a planned power-off). No-op while the previous page still waits.
+  void sync() {
+    uint32_t start = nextPage % PAGES_PER_SECTOR == 0 ? HEADER_SIZE : 0;
+    if (sectorCount > 0 && fillPos > start) {
+      sealPage();
+    }
+  }
+
+  // Do at most one flash operation (one sector erase or one page write), call
+  // once per loop. With the erase task, a sector's first page waits here
+  // until the task has erased that sector.
+  void service() {
+    if (!pendingReady) {
+      return;
+    }
+
+    if (pendingPage % PAGES_PER_SECTOR == 0 && !pendingErased) {
+      uint32_t sector = pendingPage / PAGES_PER_SECTOR;
+      if (!backgroundErase) {
+        eraseSector(sector);
+        pendingErased = true;
+        return;
+      }
+
+      if (erasedSector.load() != sector) {
+        eraseWanted.store(sector);
+        return;
+      }
+      pendingErased = true;
+      eraseWanted.store((sector + 1) % sectorCount);  // get the next one ready
+    }
+
+    writeFlash(pendingPage * PAGE_SIZE, pages[fillIndex ^ 1], PAGE_SIZE);
+    pendingReady = false;
+    pagesWritten++;
+  }
+
+  // Erase the sector the writer wants next, if that is not done yet. Call
+  // periodically from a low priority task; returns true if it erased one.
+  bool eraseAhead() {
+    uint32_t sector = eraseWanted.load();
+    if (sector == NO_SECTOR || sector == erasedSector.load()) {
+      return false;
+    }
+
+    eraseSector(sector);
+    erasedSector.store(sector);
+    return true;
+  }
+
+  bool isReady() {
+    return sectorCount > 0;
+  }
+
+  uint32_t getDroppedCount() {
+    return droppedRecords;
+  }
+
+  uint32_t getPagesWritten() {
+    return pagesWritten;
+  }
+
+#if !defined(ARDUINO_ARCH_ESP32)
+  const uint8_t *hostImage() {
+    return hostFlash;
+  }
+
+  uint32_t hostImageSize() {
+    return HOST_FLASH_SIZE;
+  }
+#endif
+};
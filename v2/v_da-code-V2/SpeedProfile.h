@@ -0,0 +1,152 @@
+#pragma once
+
+#include <Preferences.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Speed limits cycled by the mode button, overspeed bands and beep gaps for
+// one vehicle. Stored in NVS and loaded once at boot; the per-fix path only
+// indexes the flat limitsKmh[] array.
+
+constexpr uint8_t SPEED_PROFILE_VERSION = 1;  // bump when the layout changes
+constexpr uint8_t SPEED_PROFILE_MAX_LIMITS = 8;
+
+struct SpeedProfile {
+  uint8_t version;
+  uint8_t limitCount;
+  uint8_t limitsKmh[SPEED_PROFILE_MAX_LIMITS];  // 0 = automatic (camera / road limit)
+  uint8_t slowBandKmh;    // up to this far over: slow beeps
+  uint8_t mediumBandKmh;  // up to this far over: medium beeps, above: fast
+  uint16_t slowGapMs;     // silence between overspeed beeps per band
+  uint16_t mediumGapMs;
+  uint16_t fastGapMs;
+};
+
+constexpr SpeedProfile DEFAULT_SPEED_PROFILE = {
+  SPEED_PROFILE_VERSION, 6, { 0, 50, 70, 90, 110, 130 }, 5, 15, 400, 150, 50
+};
+
+// Loads / saves the profile and takes updates over a serial line:
+//   show                  print the profile
+//   limits 0 50 70 80     limits cycled by the button (0 = automatic), up to 8
+//   bands 5 15            slow / medium band in km/h over the limit
+//   beeps 400 150 50      gap after each beep for slow / medium / fast
+//   defaults              back to the built-in profile
+class SpeedProfileStore {
+private:
+  static constexpr const char *NAMESPACE = "speed";
+  static constexpr const char *KEY = "profile";
+  static const uint8_t LINE_MAX = 64;
+
+  Preferences prefs;
+  SpeedProfile profile = DEFAULT_SPEED_PROFILE;
+  char line[LINE_MAX];
+  uint8_t lineLength = 0;
+
+  static bool isValid(const SpeedProfile &candidate) {
+    return candidate.version == SPEED_PROFILE_VERSION && candidate.limitCount > 0
+           && candidate.limitCount <= SPEED_PROFILE_MAX_LIMITS && candidate.slowBandKmh <= candidate.mediumBandKmh;
+  }
+
+  bool save() {
+    return prefs.putBytes(KEY, &profile, sizeof(profile)) == sizeof(profile);
+  }
+
+  // Parse up to max numbers from text, returns how many were read
+  static uint8_t parseNumbers(char *text, long *values, uint8_t max) {
+    uint8_t count = 0;
+    char *end;
+    while (count < max) {
+      while (*text == ' ' || *text == ',') text++;
+      if (*text == '\0') break;
+      values[count] = strtol(text, &end, 10);
+      if (end == text) return 0;  // not a number
+      count++;
+      text = end;
+    }
+    return *text == '\0' ? count : 0;
+  }
+
+  // Apply one command line to a copy of the profile; false on a bad command
+  bool execute(char *command, Stream &serial) {
+    char *args = strchr(command, ' ');
+    if (args != nullptr) *args++ = '\0';
+    else args = command + strlen(command);
+
+    SpeedProfile next = profile;
+    long values[SPEED_PROFILE_MAX_LIMITS];
+    uint8_t count = parseNumbers(args, values, SPEED_PROFILE_MAX_LIMITS);
+
+    if (strcmp(command, "show") == 0) {
+      print(serial);
+      return false;
+    } else if (strcmp(command, "limits") == 0 && count > 0) {
+      next.limitCount = count;
+      for (uint8_t i = 0; i < count; i++) next.limitsKmh[i] = (uint8_t)constrain(values[i], 0, 250);
+    } else if (strcmp(command, "bands") == 0 && count == 2) {
+      next.slowBandKmh = (uint8_t)constrain(values[0], 0, 100);
+      next.mediumBandKmh = (uint8_t)constrain(values[1], 0, 100);
+    } else if (strcmp(command, "beeps") == 0 && count == 3) {
+      next.slowGapMs = (uint16_t)constrain(values[0], 0, 5000);
+      next.mediumGapMs = (uint16_t)constrain(values[1], 0, 5000);
+      next.fastGapMs = (uint16_t)constrain(values[2], 0, 5000);
+    } else if (strcmp(command, "defaults") == 0) {
+      next = DEFAULT_SPEED_PROFILE;
+    } else {
+      serial.println("error: show | limits <kmh...> | bands <slow> <medium> | beeps <slow> <medium> <fast> | defaults");
+      return false;
+    }
+
+    if (!isValid(next)) {
+      serial.println("error: invalid profile");
+      return false;
+    }
+
+    profile = next;
+    serial.println(save() ? "ok" : "ok (not saved)");
+    print(serial);
+    return true;
+  }
+
+public:
+  // Load the stored profile, or the default if none / an old layout is stored
+  void begin() {
+    prefs.begin(NAMESPACE, false);
+
+    SpeedProfile stored;
+    if (prefs.getBytesLength(KEY) == sizeof(stored) && prefs.getBytes(KEY, &stored, sizeof(stored)) == sizeof(stored)
+        && isValid(stored)) {
+      profile = stored;
+    } else {
+      profile = DEFAULT_SPEED_PROFILE;
+    }
+  }
+
+  const SpeedProfile &get() {
+    return profile;
+  }
+
+  // Read pending serial input, returns true when a command changed the profile
+  bool poll(Stream &serial) {
+    bool changed = false;
+
+    while (serial.available() > 0) {
+      char c = serial.read();
+      if (c == '\r' || c == '\n') {
+        line[lineLength] = '\0';
+        if (lineLength > 0) changed |= execute(line, serial);
+        lineLength = 0;
+      } else if (lineLength < LINE_MAX - 1) {
+        line[lineLength++] = c;
+      }
+    }
+    return changed;
+  }
+
+  void print(Stream &serial) {
+    serial.print("limits");
+    for (uint8_t i = 0; i < profile.limitCount; i++) serial.printf(" %u", profile.limitsKmh[i]);
+    serial.printf("\nbands %u %u\nbeeps %u %u %u\n", profile.slowBandKmh, profile.mediumBandKmh,
+                  profile.slowGapMs, profile.mediumGapMs, profile.fastGapMs);
+  }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Minimal task layer: FreeRTOS tasks on ESP32, std::thread on the host so the
+// same task functions can be driven from a desktop build.
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+// Pass as core to leave the task unpinned
+constexpr int TASK_ANY_CORE = -1;
+
+typedef void (*TaskFunction)(void *);
+
+inline bool startTask(const char *name, TaskFunction function, void *arg, uint32_t stackBytes, uint8_t priority, int core) {
+#if defined(ARDUINO_ARCH_ESP32)
+  BaseType_t affinity = core < 0 || core >= portNUM_PROCESSORS ? tskNO_AFFINITY : core;
+  return xTaskCreatePinnedToCore(function, name, stackBytes, arg, priority, nullptr, affinity) == pdPASS;
+#else
+  std::thread(function, arg).detach();
+  return true;
+#endif
+}
+
+inline void taskDelayMs(uint32_t ms) {
+#if defined(ARDUINO_ARCH_ESP32)
+  vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+#else
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+// Park the calling task for good (used by loop() once the worker tasks run)
+inline void taskSuspendSelf() {
+#if defined(ARDUINO_ARCH_ESP32)
+  vTaskDelete(nullptr);
+#else
+  for (;;) std::this_thread::sleep_for(std::chrono::hours(1));
+#endif
+}
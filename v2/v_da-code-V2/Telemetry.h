@@ -0,0 +1,298 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include "SpscRing.h"
+#include "GpsFix.h"
+#include "OutputShadow.h"
+
+// Binary telemetry over the USB CDC port for live profiling.
+//
+// Each stage builds whole frames into its own SPSC ring (GPS, proximity and
+// UI may run on different tasks, and a ring has one producer). The UI stage
+// drains the rings into the port, a frame at a time and only as much as the
+// CDC TX buffer takes, so it never blocks. Nothing is built or queued unless
+// a host has the port open: unattached, a record costs one flag load.
+//
+// Frame: COBS encoded { type, time_us (u32), payload, CRC-16/CCITT-FALSE }
+// followed by a 0x00 delimiter, all integers little-endian. Anything else on
+// the port (command replies, text reports) fails the CRC and is skipped.
+//   TELEM_FIX        lat, lon, measured lat, measured lon (i32 microdegrees),
+//                    speed (u16 0.1 km/h), course (u16 0.01 degree, 0xFFFF unknown), flags (u8, 1 = valid)
+//   TELEM_PROXIMITY  radius (u16 m), candidates (u16), camera limit, road limit, in range (u8 each), evaluate time (u32 us)
+//   TELEM_STAGE      stage (u8), passes (u16), total us (u32), max us (u32) per TELEMETRY_STAGE_INTERVAL_MS
+//   TELEM_OUTPUTS    written / elided (u32 each) for LED, display, buzzer, since boot
+// tools/telemetry_decode.py reads the port or a capture.
+
+enum TelemetryRecord : uint8_t {
+  TELEM_FIX = 1,
+  TELEM_PROXIMITY = 2,
+  TELEM_STAGE = 3,
+  TELEM_OUTPUTS = 4
+};
+
+enum TelemetryStage : uint8_t {
+  TELEM_STAGE_GPS = 0,
+  TELEM_STAGE_PROXIMITY = 1,
+  TELEM_STAGE_UI = 2
+};
+
+// One ring per producing stage
+enum TelemetryChannel : uint8_t {
+  TELEM_CHANNEL_GPS,
+  TELEM_CHANNEL_PROXIMITY,
+  TELEM_CHANNEL_UI,
+  TELEM_CHANNEL_COUNT
+};
+
+constexpr size_t TELEMETRY_RECORD_MAX = 1 + 4 + 24 + 2;                          // type, time, largest payload, CRC
+constexpr size_t TELEMETRY_FRAME_MAX = TELEMETRY_RECORD_MAX + TELEMETRY_RECORD_MAX / 254 + 2;  // COBS overhead, delimiter
+constexpr unsigned long TELEMETRY_STAGE_INTERVAL_MS = 100;
+
+struct TelemetryFrame {
+  uint8_t length;
+  uint8_t bytes[TELEMETRY_FRAME_MAX];
+};
+
+class Telemetry {
+private:
+  static const size_t RING_FRAMES = 16;
+  static const unsigned long ATTACH_CHECK_MS = 200;
+
+  // Record under construction, before COBS
+  struct Record {
+    uint8_t bytes[TELEMETRY_RECORD_MAX];
+    uint8_t length = 0;
+
+    void put8(uint8_t value) {
+      bytes[length++] = value;
+    }
+
+    void put16(uint16_t value) {
+      put8(value);
+      put8(value >> 8);
+    }
+
+    void put32(uint32_t value) {
+      put16(value);
+      put16(value >> 16);
+    }
+  };
+
+  SpscRing<TelemetryFrame, RING_FRAMES> rings[TELEM_CHANNEL_COUNT];
+  std::atomic<bool> active{ false };
+
+  // Drain side: frame taken from a ring that did not fit the port yet
+  TelemetryFrame pending;
+  bool hasPending = false;
+  uint8_t nextChannel = 0;
+  unsigned long lastAttachCheck = 0;
+  uint32_t framesSent = 0;
+
+  static uint16_t crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+      crc ^= (uint16_t)data[i] << 8;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+    }
+    return crc;
+  }
+
+  // Consistent overhead byte stuffing: no 0x00 inside the frame
+  static uint8_t cobsEncode(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t codeAt = 0, pos = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++) {
+      if (in[i] != 0) {
+        out[pos++] = in[i];
+        code++;
+      }
+      if (in[i] == 0 || code == 0xFF) {
+        out[codeAt] = code;
+        codeAt = pos++;
+        code = 1;
+      }
+    }
+    out[codeAt] = code;
+    out[pos++] = 0;
+    return pos;
+  }
+
+  static Record start(TelemetryRecord type) {
+    Record record;
+    record.put8(type);
+    record.put32(micros());
+    return record;
+  }
+
+  void send(TelemetryChannel channel, Record &record) {
+    record.put16(crc16(record.bytes, record.length));
+
+    TelemetryFrame frame;
+    frame.length = cobsEncode(record.bytes, record.length, frame.bytes);
+    rings[channel].push(frame);  // a full ring drops the frame (counted)
+  }
+
+public:
+  // Producers check this before measuring anything for telemetry
+  bool isActive() const {
+    return active.load(std::memory_order_relaxed);
+  }
+
+  // ---------------------------------------------- Producer side (one stage per channel) ----------------------------------------------
+
+  void writeFix(TelemetryChannel channel, const GpsFix &fix, const GpsFix &measured) {
+    if (!isActive()) return;
+
+    Record record = start(TELEM_FIX);
+    record.put32(fix.latE6);
+    record.put32(fix.lonE6);
+    record.put32(measured.latE6);
+    record.put32(measured.lonE6);
+    record.put16(fix.speedKmhX10);
+    record.put16(fix.courseCdeg);
+    record.put8(fix.valid ? 1 : 0);
+    send(channel, record);
+  }
+
+  void writeProximity(TelemetryChannel channel, uint16_t radiusM, uint16_t candidates, uint8_t cameraLimitKmh,
+                      uint8_t roadLimitKmh, bool inRange, uint32_t evaluateUs) {
+    if (!isActive()) return;
+
+    Record record = start(TELEM_PROXIMITY);
+    record.put16(radiusM);
+    record.put16(candidates);
+    record.put8(cameraLimitKmh);
+    record.put8(roadLimitKmh);
+    record.put8(inRange ? 1 : 0);
+    record.put32(evaluateUs);
+    send(channel, record);
+  }
+
+  void writeStage(TelemetryChannel channel, TelemetryStage stage, uint16_t passes, uint32_t totalUs, uint32_t maxUs) {
+    if (!isActive()) return;
+
+    Record record = start(TELEM_STAGE);
+    record.put8(stage);
+    record.put16(passes);
+    record.put32(totalUs);
+    record.put32(maxUs);
+    send(channel, record);
+  }
+
+  void writeOutputs(TelemetryChannel channel, const OutputStats &led, const OutputStats &display, const OutputStats &buzzer) {
+    if (!isActive()) return;
+
+    Record record = start(TELEM_OUTPUTS);
+    record.put32(led.written);
+    record.put32(led.elided);
+    record.put32(display.written);
+    record.put32(display.elided);
+    record.put32(buzzer.written);
+    record.put32(buzzer.elided);
+    send(channel, record);
+  }
+
+  // ---------------------------------------------- Consumer side (UI stage) ----------------------------------------------
+
+  // Follow the host attaching / detaching and move whole frames into the
+  // port while its TX buffer has room. Port: operator bool (host has the
+  // port open), availableForWrite(), write(buffer, length).
+  template<typename Port>
+  void service(Port &port, unsigned long nowMs) {
+    if (nowMs - lastAttachCheck >= ATTACH_CHECK_MS) {
+      lastAttachCheck = nowMs;
+      bool attached = (bool)port;
+
+      // Frames queued for a host that went away are stale for the next one
+      if (!attached && isActive()) {
+        TelemetryFrame discard;
+        for (auto &ring : rings) {
+          while (ring.pop(discard)) {}
+        }
+        hasPending = false;
+      }
+      active.store(attached, std::memory_order_relaxed);
+    }
+    if (!isActive()) return;
+
+    // Round robin over the rings, one frame at a time
+    for (uint8_t tried = 0; tried <= TELEM_CHANNEL_COUNT;) {
+      if (!hasPending) {
+        hasPending = rings[nextChannel].pop(pending);
+        nextChannel = (nextChannel + 1) % TELEM_CHANNEL_COUNT;
+        if (!hasPending) {
+          tried++;
+          continue;
+        }
+      }
+      if ((size_t)port.availableForWrite() < pending.length) {
+        return;
+      }
+      port.write(pending.bytes, pending.length);
+      hasPending = false;
+      framesSent++;
+      tried = 0;
+    }
+  }
+
+  uint32_t getFramesSent() const {
+    return framesSent;
+  }
+
+  // Frames lost to full rings (the host did not keep up)
+  uint32_t getDroppedFrames() const {
+    uint32_t dropped = 0;
+    for (auto &ring : rings) {
+      dropped += ring.getDroppedCount();
+    }
+    return dropped;
+  }
+};
+
+// Pass timing of one stage, sent as a TELEM_STAGE record every
+// TELEMETRY_STAGE_INTERVAL_MS while a host is attached. Used by that stage only;
+// the clock is only read while a host is attached.
+class TelemetryStageTimer {
+private:
+  TelemetryChannel channel;
+  TelemetryStage stage;
+  bool timing = false;
+  uint32_t startUs = 0;
+  uint16_t passes = 0;
+  uint32_t totalUs = 0;
+  uint32_t maxUs = 0;
+  unsigned long windowStart = 0;
+
+public:
+  TelemetryStageTimer(TelemetryChannel stageChannel, TelemetryStage stageId)
+    : channel(stageChannel), stage(stageId) {}
+
+  void start(const Telemetry &telemetry) {
+    timing = telemetry.isActive();
+    if (timing) startUs = micros();
+  }
+
+  // End of the pass, returns its duration in us (0 if not timed)
+  uint32_t stop(Telemetry &telemetry) {
+    if (!timing) return 0;
+
+    uint32_t us = micros() - startUs;
+    passes++;
+    totalUs += us;
+    if (us > maxUs) maxUs = us;
+
+    unsigned long now = millis();
+    if (now - windowStart >= TELEMETRY_STAGE_INTERVAL_MS) {
+      telemetry.writeStage(channel, stage, passes, totalUs, maxUs);
+      passes = 0;
+      totalUs = 0;
+      maxUs = 0;
+      windowStart = now;
+    }
+    return us;
+  }
+};
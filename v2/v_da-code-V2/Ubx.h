@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// UBX frame: 0xB5 0x62, class, id, little-endian length, payload, 8-bit
+// Fletcher checksum over class..payload
+constexpr size_t UBX_FRAME_OVERHEAD = 8;
+
+inline void ubxPut16(uint8_t *p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+inline void ubxPut32(uint8_t *p, uint32_t value) {
+  ubxPut16(p, value);
+  ubxPut16(p + 2, value >> 16);
+}
+
+// Write one frame to out, returns its length (0 if it does not fit in max)
+inline size_t ubxFrame(uint8_t msgClass, uint8_t msgId, const uint8_t *payload, uint16_t length, uint8_t *out, size_t max) {
+  if (length + UBX_FRAME_OVERHEAD > max) return 0;
+
+  out[0] = 0xB5;
+  out[1] = 0x62;
+  out[2] = msgClass;
+  out[3] = msgId;
+  ubxPut16(out + 4, length);
+  memcpy(out + 6, payload, length);
+
+  uint8_t a = 0, b = 0;
+  for (size_t i = 2; i < 6 + (size_t)length; i++) {
+    a += out[i];
+    b += a;
+  }
+  out[6 + length] = a;
+  out[7 + length] = b;
+  return length + UBX_FRAME_OVERHEAD;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Preferences.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "Better-GPS.h"
+#include "Ubx.h"
+
+// Last known position and time, handed to the receiver at boot as UBX-MGA-INI
+// aiding (TIME_UTC, then POS_LLH) so it does not start from a cold search.
+//
+// The record lives in RTC memory (RTC_NOINIT in the sketch), which survives
+// software resets and deep sleep, and so does the system clock: time aiding
+// is only sent after those. A copy of the position goes to NVS on fix loss
+// and every few minutes with a fix, for power-on boots.
+// The system clock is resynced to GPS UTC every SYNC_INTERVAL_MS, and the
+// error found at each resync gives its drift, which sizes the time accuracy.
+
+struct WarmStartRecord {
+  uint32_t magic;
+  int32_t latE6, lonE6;
+  int32_t altitudeDm;  // above the ellipsoid
+  int64_t syncUtcMs;   // UTC the system clock was last set to, 0 = clock not synced
+  int32_t driftPpb;    // system clock rate error, + = fast
+  bool driftKnown;
+};
+
+constexpr size_t WARM_START_AIDING_MAX = 2 * UBX_FRAME_OVERHEAD + 24 + 20;
+
+class WarmStart {
+private:
+  static const uint32_t MAGIC = 0x56575331;  // "VWS1"
+  static constexpr const char *NAMESPACE = "warm";
+  static constexpr const char *KEY = "fix";
+  static const unsigned long SAVE_INTERVAL_MS = 300000;   // NVS copy while driving
+  static const unsigned long SYNC_INTERVAL_MS = 600000;   // long enough to see drift through NMEA jitter
+  static const uint32_t POSITION_ACCURACY_CM = 50000;     // parked near the last fix
+  static const uint32_t TIME_ACCURACY_MS = 500;           // NMEA arrival jitter
+  static const uint32_t UNKNOWN_DRIFT_PPB = 500000;       // RTC slow clock before any measurement
+  static const uint32_t DRIFT_MARGIN_PPB = 50000;
+
+  WarmStartRecord &record;
+  Preferences prefs;
+  bool started = false;
+  bool wasValid = false;
+  unsigned long lastSave = 0;
+  unsigned long lastSync = 0;
+
+  void save() {
+    WarmStartRecord stored = record;
+    stored.syncUtcMs = 0;  // the clock does not survive a power cycle
+    prefs.putBytes(KEY, &stored, sizeof(stored));
+  }
+
+  size_t timeAiding(int64_t clockMs, uint8_t *out, size_t max) const {
+    int64_t elapsedMs = clockMs - record.syncUtcMs;
+    if (record.syncUtcMs == 0 || elapsedMs < 0) return 0;
+
+    // Take the measured drift out and widen the accuracy by what may remain
+    int64_t utcMs = clockMs - elapsedMs * (record.driftKnown ? record.driftPpb : 0) / 1000000000;
+    uint32_t driftPpb = record.driftKnown ? (uint32_t)abs(record.driftPpb) / 4 + DRIFT_MARGIN_PPB : UNKNOWN_DRIFT_PPB;
+    int64_t accuracyMs = TIME_ACCURACY_MS + elapsedMs * driftPpb / 1000000000;
+
+    int64_t seconds = utcMs / 1000;
+    int32_t days = HungarianTime::floorDiv(seconds, 86400);
+    int32_t secondOfDay = (int32_t)(seconds - (int64_t)days * 86400);
+    int year, month, day;
+    HungarianTime::civilFromDays(days, year, month, day);
+
+    uint8_t payload[24] = {};
+    payload[0] = 0x10;                // TIME_UTC
+    payload[3] = (uint8_t)(int8_t)-128;  // leap seconds unknown
+    ubxPut16(payload + 4, year);
+    payload[6] = month;
+    payload[7] = day;
+    payload[8] = secondOfDay / 3600;
+    payload[9] = secondOfDay / 60 % 60;
+    payload[10] = secondOfDay % 60;
+    ubxPut32(payload + 12, (uint32_t)(utcMs % 1000) * 1000000);
+    ubxPut16(payload + 16, accuracyMs / 1000 < 0xFFFF ? accuracyMs / 1000 : 0xFFFF);
+    ubxPut32(payload + 20, (uint32_t)(accuracyMs % 1000) * 1000000);
+    return ubxFrame(0x13, 0x40, payload, sizeof(payload), out, max);
+  }
+
+  size_t positionAiding(uint8_t *out, size_t max) const {
+    uint8_t payload[20] = {};
+    payload[0] = 0x01;  // POS_LLH
+    ubxPut32(payload + 4, (uint32_t)(record.latE6 * 10));
+    ubxPut32(payload + 8, (uint32_t)(record.lonE6 * 10));
+    ubxPut32(payload + 12, (uint32_t)(record.altitudeDm * 10));
+    ubxPut32(payload + 16, POSITION_ACCURACY_CM);
+    return ubxFrame(0x13, 0x40, payload, sizeof(payload), out, max);
+  }
+
+public:
+  explicit WarmStart(WarmStartRecord &rtcRecord)
+    : record(rtcRecord) {}
+
+  // clockKept: the reset kept RTC memory and the system clock (not a power-on)
+  void begin(bool clockKept) {
+    prefs.begin(NAMESPACE, false);
+    started = true;
+    if (clockKept && record.magic == MAGIC) return;
+
+    WarmStartRecord stored;
+    if (prefs.getBytesLength(KEY) == sizeof(stored) && prefs.getBytes(KEY, &stored, sizeof(stored)) == sizeof(stored)
+        && stored.magic == MAGIC) {
+      record = stored;
+    } else {
+      record = {};
+    }
+    record.syncUtcMs = 0;
+  }
+
+  // UBX-MGA-INI frames for the stored state into out, returns the total length
+  size_t buildAiding(int64_t clockMs, uint8_t *out, size_t max) const {
+    if (record.magic != MAGIC) return 0;
+
+    size_t length = timeAiding(clockMs, out, max);
+    return length + positionAiding(out + length, max - length);
+  }
+
+  // Track one fix. utcMs < 0 when GPS time is unknown. Returns true when the
+  // system clock should be set to utcMs.
+  bool update(const GpsFix &fix, int32_t altitudeDm, int64_t utcMs, int64_t clockMs) {
+    bool syncClock = false;
+
+    if (fix.valid) {
+      record.magic = MAGIC;
+      record.latE6 = fix.latE6;
+      record.lonE6 = fix.lonE6;
+      record.altitudeDm = altitudeDm;
+
+      if (utcMs > 0 && (record.syncUtcMs == 0 || fix.timestampMs - lastSync >= SYNC_INTERVAL_MS)) {
+        int64_t intervalMs = utcMs - record.syncUtcMs;
+        if (record.syncUtcMs != 0 && intervalMs >= (int64_t)SYNC_INTERVAL_MS) {
+          int32_t drift = (int32_t)((clockMs - utcMs) * 1000000000 / intervalMs);
+          record.driftPpb = record.driftKnown ? (3 * record.driftPpb + drift) / 4 : drift;
+          record.driftKnown = true;
+        }
+        record.syncUtcMs = utcMs;
+        lastSync = fix.timestampMs;
+        syncClock = true;
+      }
+
+      if (started && fix.timestampMs - lastSave >= SAVE_INTERVAL_MS) {
+        save();
+        lastSave = fix.timestampMs;
+      }
+    } else if (wasValid && started) {
+      save();  // fix lost: likely a garage or the end of the drive
+      lastSave = fix.timestampMs;
+    }
+
+    wasValid = fix.valid;
+    return syncClock;
+  }
+};
@@ -1,6 +1,14 @@
 struct Coordinate {
   double lat;
   double lon;
+  uint8_t limitKmh = 0;  // posted limit at the camera, 0 = unknown
+};
+
+// Cameras of one county: a contiguous range of coordinates[]
+struct Region {
+  const char *name;
+  uint16_t first;
+  uint16_t count;
 };
 
 constexpr Coordinate coordinates[] = {
@@ -178,4 +186,27 @@ constexpr Coordinate coordinates[] = {
   { 46.760544, 17.328331 },
   { 46.726746, 17.114232 }
 
-};
\ No newline at end of file
+};
+
+constexpr Region regions[] = {
+  { "Budapest", 0, 6 },
+  { "Baranya", 6, 7 },
+  { "Bács-Kiskun", 13, 7 },
+  { "Békés", 20, 6 },
+  { "Borsod-Abaúj-Zemplén", 26, 10 },
+  { "Csongrád", 36, 6 },
+  { "Fejér", 42, 8 },
+  { "Győr-Moson-Sopron", 50, 5 },
+  { "Hajdú-Bihar", 55, 8 },
+  { "Heves", 63, 6 },
+  { "Jász-Nagykun-Szolnok", 69, 8 },
+  { "Komárom-Esztergom", 77, 6 },
+  { "Nógrád", 83, 5 },
+  { "Pest", 88, 4 },
+  { "Somogy", 92, 6 },
+  { "Szabolcs-Szatmár-Bereg", 98, 6 },
+  { "Tolna", 104, 6 },
+  { "Vas", 110, 5 },
+  { "Veszprém", 115, 10 },
+  { "Zala", 125, 9 }
+};
@@ -0,0 +1,7 @@
+// Road segments with a posted speed limit, used when no camera limit applies.
+// One line per segment: { lat1, lon1, lat2, lon2, limit km/h }, keep segments
+// short (a few hundred meters). Entries with limit 0 are ignored.
+
+constexpr RoadSegment roadSegments[] = {
+  { 0, 0, 0, 0, 0 }  // placeholder, the layer is empty until segments are added
+};
@@ -1,40 +1,66 @@
+#include "BoardPolicy.h"
 #include "Better-GPS.h"
 #include "Better-RGB.h"
+#include "Better-Buzzer.h"
 #include "GN1650.h"
 #include "coordinates.h"
+#include "SpscRing.h"
+#include "TaskRuntime.h"
+#include "AlertStateMachine.h"
+#include "ProximityModel.h"
+#include "RegionWorkingSet.h"
+#include "SpeedProfile.h"
+#include "SegmentLayer.h"
+#include "roadsegments.h"
+#include "ZoneLayer.h"
+#include "zones.h"
+#include "DriveLog.h"
+#include "Geodesy.h"
+#include "WarmStart.h"
+#include "GpsKalman.h"
+#include "DetectorCore.h"
+#include "ButtonInput.h"
+#include "Telemetry.h"
+
+// Pins, LED polarity and display timing (BoardPolicy.h)
+typedef V2Board<> Board;
 
 // Mode switch button
-constexpr uint8_t MODE_SW = 0;
-
-// RGB Led
-constexpr uint8_t LED_R = 2;
-constexpr uint8_t LED_G = 3;
-constexpr uint8_t LED_B = 4;
-constexpr bool LED_COMMON_CATHODE = false;
+constexpr uint8_t MODE_SW = Board::MODE_SW;
 
 // GPS
-constexpr uint8_t GPS_RX = 6;
-constexpr uint8_t GPS_TX = 10;
+constexpr uint8_t GPS_RX = Board::GPS_RX;
+constexpr uint8_t GPS_TX = Board::GPS_TX;
 double currentLat, currentLon;
 int currentSpeed;
+bool gpsFixValid = false;
 
 // Buzzer
-constexpr uint8_t BUZZER = 7;
-bool hadGpsFix = false;
-
-// Led driver
-constexpr uint8_t DATA_PIN = 8;
-constexpr uint8_t CLK_PIN = 9;
-
-// Proximity range
-bool withinProxRange = false;
-int proximityRange = 300;  // meters
-bool justLeftProxRange = false;
-
-// Variables for buzzer flashing sync
-bool buzzerFlashState = false;
-unsigned long buzzerFlashTimer = 0;
-constexpr unsigned long BUZZER_FLASH_INTERVAL = 200;
+constexpr uint8_t BUZZER = Board::BUZZER;
+
+// Buzzer patterns: { frequency, duration, gap } in Hz / ms
+constexpr BuzzerNote BOOT_NOTES[] = { { 3300, 100, 50 }, { 3500, 100, 50 }, { 3700, 100, 50 } };
+constexpr BuzzerNote SIGNAL_FOUND_NOTES[] = { { 4000, 100, 50 }, { 4000, 100, 50 } };
+constexpr BuzzerNote SIGNAL_LOST_NOTES[] = { { 2500, 100, 50 }, { 2500, 100, 50 } };
+constexpr BuzzerNote MODE_CHIRP_NOTES[] = { { 0, 200, 0 }, { 3700, 200, 0 } };
+constexpr BuzzerNote PROXIMITY_ALERT_NOTES[] = { { 3700, 200, 200 } };
+constexpr BuzzerNote PROXIMITY_EXIT_NOTES[] = { { 3700, 2000, 0 } };
+constexpr BuzzerNote ZONE_ENTER_NOTES[] = { { 3300, 150, 50 }, { 3700, 150, 50 }, { 3300, 150, 50 } };
+// Overspeed gaps come from the speed profile (applySpeedProfile)
+BuzzerNote OVERSPEED_SLOW_NOTES[] = { { 3700, 100, 400 } };
+BuzzerNote OVERSPEED_MEDIUM_NOTES[] = { { 3700, 100, 150 } };
+BuzzerNote OVERSPEED_FAST_NOTES[] = { { 3700, 100, 50 } };
+
+constexpr BuzzerPattern BOOT_SOUND = buzzerPattern(BOOT_NOTES);
+constexpr BuzzerPattern SIGNAL_FOUND_SOUND = buzzerPattern(SIGNAL_FOUND_NOTES);
+constexpr BuzzerPattern SIGNAL_LOST_SOUND = buzzerPattern(SIGNAL_LOST_NOTES);
+constexpr BuzzerPattern MODE_CHIRP = buzzerPattern(MODE_CHIRP_NOTES);
+constexpr BuzzerPattern PROXIMITY_ALERT = buzzerPattern(PROXIMITY_ALERT_NOTES, true);
+constexpr BuzzerPattern PROXIMITY_EXIT = buzzerPattern(PROXIMITY_EXIT_NOTES);
+constexpr BuzzerPattern ZONE_ENTER = buzzerPattern(ZONE_ENTER_NOTES);
+constexpr BuzzerPattern OVERSPEED_SLOW = buzzerPattern(OVERSPEED_SLOW_NOTES, true);
+constexpr BuzzerPattern OVERSPEED_MEDIUM = buzzerPattern(OVERSPEED_MEDIUM_NOTES, true);
+constexpr BuzzerPattern OVERSPEED_FAST = buzzerPattern(OVERSPEED_FAST_NOTES, true);
 
 // Loading animation
 constexpr unsigned long LOADING_INTERVAL = 100;
@@ -42,431 +68,701 @@ constexpr unsigned long LOADING_INTERVAL = 100;
 // Earth radius in meters
 constexpr double R = 6371000.0;
 
-// Speed limit mode variables
-enum SpeedMode {
-  NONE = 0,
-  LIMIT_50 = 1,
-  LIMIT_70 = 2,
-  LIMIT_90 = 3,
-  LIMIT_110 = 4,
-  LIMIT_130 = 5
-};
-SpeedMode currentSpeedMode = NONE;
-const int speedLimits[6] = { 0, 50, 70, 90, 110, 130 };
-
-// Button handling variables
-bool lastButtonState = HIGH;
-unsigned long buttonPressStartTime = 0;
-bool buttonHoldProcessed = false;
-constexpr unsigned long BUTTON_HOLD_TIME = 1500;  // 1.5 seconds for hold-to-reset
-
+// Camera warning radius: 2 s reaction, 1 m/s^2 coasting deceleration, 100 m margin,
+// 150-1000 m (50 km/h -> 224 m, 90 km/h -> 463 m, 130 km/h -> 824 m)
+constexpr ProximityModel PROXIMITY_MODEL = { 2.0f, 1.0f, 100, 150, 1000 };
+constexpr ProximityTable<200> PROXIMITY_RADIUS = buildProximityTable<200>(PROXIMITY_MODEL);
+
+// Cameras compressed per county into 0.25 degree blocks at compile time; coordinates[] itself is not stored.
+// Counties whose camera boxes come within twice the largest radius are neighbours.
+constexpr uint32_t REGION_ADJACENT_MARGIN_M = 2 * PROXIMITY_RADIUS.maxRadius();
+constexpr CameraDbSize CAMERA_DB_SIZE = measureCameraDb(coordinates, regions);
+static_assert(CAMERA_DB_SIZE.cameras == sizeof(coordinates) / sizeof(coordinates[0]), "every camera must belong to a region");
+typedef CameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes, CAMERA_DB_SIZE.regions> CameraDatabase;
+constexpr CameraDatabase CAMERA_DB CORE_PROGMEM = buildCameraDb<CAMERA_DB_SIZE.blocks, CAMERA_DB_SIZE.bytes>(coordinates, regions, REGION_ADJACENT_MARGIN_M);
+
+// Road segment speed limits, in the same grid as the camera index
+constexpr uint32_t SEGMENT_MATCH_M = 25;  // max distance from the fix to the segment
+constexpr size_t SEGMENT_INDEX_SIZE = segmentIndexSize(roadSegments);
+constexpr SegmentLayer<sizeof(roadSegments) / sizeof(roadSegments[0]), SEGMENT_INDEX_SIZE> ROAD_LAYER = buildSegmentLayer<SEGMENT_INDEX_SIZE>(roadSegments);
+
+// Alert zone polygons, same grid again; a zone's limit applies inside it when no camera limit does
+constexpr ZoneLayerSize ZONE_LAYER_SIZE = measureZoneLayer(zoneVertices, zones);
+constexpr ZoneLayer<sizeof(zones) / sizeof(zones[0]), ZONE_LAYER_SIZE.edges, ZONE_LAYER_SIZE.entries> ZONE_LAYER =
+  buildZoneLayer<ZONE_LAYER_SIZE.edges, ZONE_LAYER_SIZE.entries>(zoneVertices, zones);
+
+// Speed limit profile (NVS, updated over Serial) and the selected limit
+SpeedProfileStore speedProfiles;
+uint8_t speedLimitIndex = 0;  // into limitsKmh[], entry 0 is selected by hold-to-reset
+
+// A selected limit of 0 means automatic: the limit of the camera being
+// approached, else of the road segment. Any other selected limit overrides.
+constexpr bool AUTO_SPEED_LIMIT = true;
+constexpr bool SERIAL_COMMANDS = true;
+
+// Degraded mode (blue LED, loading animation, no warnings) after this long
+// without a new position while the receiver still reports a fix (10 Hz)
+constexpr uint32_t STALE_FIX_MS = 1500;
+
+// Detection engine (DetectorCore.h): keeps the cameras of the current county
+// and its neighbours decoded in RAM, and the alert state
+typedef DetectorCore<CameraDatabase, CAMERA_DB.workingSetSize(), decltype(PROXIMITY_RADIUS), decltype(ROAD_LAYER), decltype(ZONE_LAYER)> Detector;
+Detector detector(CAMERA_DB, PROXIMITY_RADIUS, ROAD_LAYER, ZONE_LAYER, SEGMENT_MATCH_M, AUTO_SPEED_LIMIT, STALE_FIX_MS);
+
+// Mode button: the pin interrupt queues timestamped edges, the UI decodes
+// them into gestures (ButtonInput.h). Short press: next limit, double press:
+// previous limit, 1.5 s hold: reset to the first limit.
+constexpr ButtonTiming BUTTON_TIMING = { 30, 1500, 300 };  // debounce, hold-to-reset, double press gap
+ButtonInput<16> modeButton(BUTTON_TIMING);
+
+unsigned long modeDisplayStartTime = 0;
 unsigned long modeDisplayEndTime = 0;
 bool showingModeDisplay = false;
 
-// Speed warning variables - made non-blocking
-unsigned long lastSpeedWarningTime = 0;
-bool isSpeedWarningActive = false;
-unsigned long speedWarningBeepEndTime = 0;
-bool speedWarningBeepActive = false;
-unsigned long speedWarningLedEndTime = 0;
-bool speedWarningLedActive = false;
-
-// Non-blocking sound variables
-unsigned long soundEndTime = 0;
-bool soundActive = false;
+// Green LED comes back after a short blink when the mode is shown
+constexpr unsigned long MODE_LED_BLINK_MS = 200;
+
+// Sound pattern last started for the alert state
+AlertSound appliedSound = ALERT_SOUND_NONE;
+
+// Output write statistics over Serial (written / elided per device)
+constexpr bool REPORT_OUTPUT_STATS = false;
+constexpr unsigned long OUTPUT_STATS_INTERVAL_MS = 60000;
+unsigned long lastOutputStatsReport = 0;
+
+// Warm start: last fix and time kept in RTC memory / NVS and sent to the
+// receiver as UBX-MGA-INI aiding at boot
+constexpr bool USE_WARM_START = true;
+RTC_NOINIT_ATTR WarmStartRecord warmStartRecord;
+WarmStart warmStart(warmStartRecord);
+
+// Constant-velocity Kalman filter on fixes (GPS stage): the filtered fix
+// drives the speed display and the proximity checks, the drive log keeps the
+// measured one so tools/kalman_replay.cpp can evaluate tunings on it
+constexpr bool USE_KALMAN_FILTER = true;
+constexpr bool REPORT_KALMAN_STATS = false;  // innovation statistics over Serial
+constexpr unsigned long KALMAN_STATS_INTERVAL_MS = 60000;
+unsigned long lastKalmanStatsReport = 0;
+GpsKalman kalman(DEFAULT_KALMAN_TUNING);
+
+// Binary telemetry (Telemetry.h) on the USB CDC port while a host has it
+// open: fixes, proximity evaluations, stage timings and output writes, for
+// tools/telemetry_decode.py. Do not combine with the text reports.
+constexpr bool USE_TELEMETRY = false;
+constexpr unsigned long TELEMETRY_OUTPUTS_INTERVAL_MS = 1000;
+unsigned long lastTelemetryOutputs = 0;
+Telemetry telemetry;
+TelemetryStageTimer gpsStageTimer(TELEM_CHANNEL_GPS, TELEM_STAGE_GPS);
+TelemetryStageTimer proximityStageTimer(TELEM_CHANNEL_PROXIMITY, TELEM_STAGE_PROXIMITY);
+TelemetryStageTimer uiStageTimer(TELEM_CHANNEL_UI, TELEM_STAGE_UI);
+
+// Fix age and fix-to-alert latency over Serial (FixLatency.h); tools/latency_replay.cpp
+// checks the same numbers against budgets on a recorded NMEA trace
+constexpr bool REPORT_LATENCY_STATS = false;
+constexpr unsigned long LATENCY_STATS_INTERVAL_MS = 60000;
+unsigned long lastLatencyStatsReport = 0;
+
+// Time the integer geodesy against the double haversine at boot (Serial)
+constexpr bool BENCHMARK_GEODESY = false;
+
+// Drive log in the "drivelog" flash partition (partitions.csv)
+constexpr bool USE_DRIVE_LOG = true;
+constexpr unsigned long LOG_FIX_INTERVAL_MS = 1000;
+constexpr unsigned long LOG_LOOP_STATS_INTERVAL_MS = 60000;
+constexpr uint8_t DRIVE_LOG_ERASE_PRIORITY = 1;  // below the UI task, level with loop()
+constexpr uint32_t DRIVE_LOG_ERASE_PERIOD_MS = 100;
+unsigned long lastFixLogTime = 0;
+unsigned long lastLoopStatsLogTime = 0;
+AlertState loggedAlertState = ALERT_STATE_COUNT;
+
+// UI pass timing between loop stats records
+unsigned long lastUiPassMicros = 0;
+uint32_t uiPassTotalUs = 0;
+uint32_t uiPassMaxUs = 0;
+uint32_t uiPassCount = 0;
+
+// Task mode: GPS ingest, proximity evaluation and UI run as separate
+// FreeRTOS tasks (std::thread on host builds) instead of one loop()
+constexpr bool USE_RTOS_TASKS = false;
+constexpr int GPS_TASK_CORE = 0;
+constexpr int PROXIMITY_TASK_CORE = 1;  // falls back to unpinned on single-core parts
+constexpr int UI_TASK_CORE = 1;
+constexpr uint8_t GPS_TASK_PRIORITY = 5;
+constexpr uint8_t PROXIMITY_TASK_PRIORITY = 3;
+constexpr uint8_t UI_TASK_PRIORITY = 2;
+constexpr uint32_t TASK_STACK_BYTES = 4096;
+constexpr uint32_t GPS_TASK_PERIOD_MS = 5;
+constexpr uint32_t PROXIMITY_TASK_PERIOD_MS = 10;
+constexpr uint32_t UI_TASK_PERIOD_MS = 2;
+constexpr unsigned long NO_FIX_HEARTBEAT_MS = 100;
+
+// Stage queues (single producer / single consumer each)
+SpscRing<FilteredFix, 8> fixQueue;
+SpscRing<ProximityResult, 8> resultQueue;
 
 // Instances
 BetterGPS gps;
-BetterRGB rgb;
-GN1650 ledDriver;
+BetterRGB<Board> rgb;
+BetterBuzzer buzzer;
+GN1650<Board> ledDriver;
+DriveLog driveLog;
 
 void setup() {
-  // Initialize button
+  if (SERIAL_COMMANDS || REPORT_OUTPUT_STATS || REPORT_KALMAN_STATS || REPORT_LATENCY_STATS || BENCHMARK_GEODESY || USE_TELEMETRY) {
+    Serial.begin(115200);
+  }
+
+  if (BENCHMARK_GEODESY) {
+    benchmarkGeodesy();
+  }
+
+  // Load the speed limit profile
+  speedProfiles.begin();
+  applySpeedProfile();
+
+  // Initialize button, edges are captured from here on
   pinMode(MODE_SW, INPUT_PULLUP);
+  modeButton.begin(digitalRead(MODE_SW) == LOW, millis());
+  attachInterrupt(digitalPinToInterrupt(MODE_SW), modeButtonEdge, CHANGE);
 
   // Start GPS
   gps.begin(GPS_RX, GPS_TX);
 
-  // Initialize RGB with pins and common cathode configuration
-  rgb.begin(LED_R, LED_G, LED_B, LED_COMMON_CATHODE);
+  // Hand the last position / time to the receiver
+  if (USE_WARM_START) {
+    warmStart.begin(esp_reset_reason() != ESP_RST_POWERON);
+
+    uint8_t aiding[WARM_START_AIDING_MAX];
+    size_t length = warmStart.buildAiding(systemClockMs(), aiding, sizeof(aiding));
+    gps.sendUbx(aiding, length);
+  }
+
+  // Start buzzer sequencer
+  buzzer.begin(BUZZER);
+
+  // Initialize RGB (pins and polarity come from the board)
+  rgb.begin();
   rgb.allOff();
 
   // Start GN1650
-  ledDriver.begin(DATA_PIN, CLK_PIN, 8);
+  ledDriver.begin(8);
 
   // Perform startup segment test
   ledDriver.testSegments(80);
 
   delay(300);
 
+  // Open the drive log, sectors are erased ahead in their own task
+  if (USE_DRIVE_LOG && driveLog.begin(true)) {
+    driveLog.logEvent(millis(), LOG_EVENT_BOOT, 0);
+    startTask("drivelog", driveLogEraseTask, nullptr, TASK_STACK_BYTES, DRIVE_LOG_ERASE_PRIORITY, TASK_ANY_CORE);
+  }
+
   // Play boot sound
   bootUpSound();
+
+  if (USE_RTOS_TASKS) {
+    startTasks();
+  }
 }
 
 void loop() {
-  // Handle mode button press
-  handleModeButton();
-
-  // Handle non-blocking sounds
-  if (soundActive && millis() >= soundEndTime) {
-    noTone(BUZZER);
-    soundActive = false;
+  // In task mode the work happens in the tasks started from setup()
+  if (USE_RTOS_TASKS) {
+    taskSuspendSelf();
   }
 
-  // Update functions for custom classes
+  // Ingest
+  GpsFix fix;
+  bool fresh = runGpsStage(fix);
+
+  // Evaluate proximity
+  ProximityResult result = runProximityStage(filteredFix(fix), fresh);
+
+  // Drive outputs
+  runUi(result);
+}
+
+// ---------------------------------------------- Stages ----------------------------------------------
+
+// Parse GPS data; on a new fix keep the warm start record and the filter
+// current. Returns true on a new fix.
+bool runGpsStage(GpsFix &fix) {
+  gpsStageTimer.start(telemetry);
+
   gps.update();
-  rgb.update();
+  bool fresh = gps.getFix(fix);
+  if (fresh) {
+    trackWarmStart(fix);
+    filterFix(fix);
+  }
 
-  // Handle mode display timeout globally
-  if (showingModeDisplay && millis() >= modeDisplayEndTime) {
-    showingModeDisplay = false;
+  gpsStageTimer.stop(telemetry);
+  if (fresh) {
+    FilteredFix traced = filteredFix(fix);
+    telemetry.writeFix(TELEM_CHANNEL_GPS, traced.fix, traced.measured);
   }
+  return fresh;
+}
 
-  // GPS has fix
-  if (gps.hasFix()) {
-    // Play signal found sound if this is first fix or recovery from lost fix
-    if (!hadGpsFix) {
-      if (!withinProxRange) {
-        rgb.setDigitalColor(false, true, false);  // Turn green on only
-      }
-      signalSound(false);  // Found signal sound
-      hadGpsFix = true;
-    }
+// Camera and road limit lookups; traced evaluations go to the telemetry
+ProximityResult runProximityStage(const FilteredFix &fix, bool traced) {
+  proximityStageTimer.start(telemetry);
+  ProximityResult result = detector.evaluate(fix);
+  uint32_t evaluateUs = proximityStageTimer.stop(telemetry);
 
-    // Get current GPS data
-    currentLat = gps.getLatitude();
-    currentLon = gps.getLongitude();
-    currentSpeed = gps.getSpeedKmph();
+  if (traced) {
+    telemetry.writeProximity(TELEM_CHANNEL_PROXIMITY, result.radiusM, result.candidates, result.cameraLimitKmh,
+                             result.roadLimitKmh, result.inRange, evaluateUs);
+  }
+  return result;
+}
 
-    // Display speed unless showing mode
-    if (!showingModeDisplay) {
-      ledDriver.displayNumber(currentSpeed);
-    }
+// ---------------------------------------------- Task mode ----------------------------------------------
 
-    // Check distance to nearest traffipax
-    checkProximityToTraffipax();
+void startTasks() {
+  startTask("gps", gpsTask, nullptr, TASK_STACK_BYTES, GPS_TASK_PRIORITY, GPS_TASK_CORE);
+  startTask("proximity", proximityTask, nullptr, TASK_STACK_BYTES, PROXIMITY_TASK_PRIORITY, PROXIMITY_TASK_CORE);
+  startTask("ui", uiTask, nullptr, TASK_STACK_BYTES, UI_TASK_PRIORITY, UI_TASK_CORE);
+}
 
-    // Handle speed limit warnings if not in proximity
-    if (!withinProxRange) {
-      handleSpeedLimitWarning();
-    } else {
-      stopSpeedWarnings();
+// Parse GPS data and publish a fix whenever the location updates
+// (or periodically while there is no fix, so the UI sees the loss)
+void gpsTask(void *) {
+  GpsFix fix;
+  unsigned long lastPublish = 0;
+
+  for (;;) {
+    bool fresh = runGpsStage(fix);
+    if (fresh || millis() - lastPublish >= NO_FIX_HEARTBEAT_MS) {
+      fixQueue.push(filteredFix(fix));
+      lastPublish = millis();
     }
 
-    // Handle buzzer flashing when in proximity
-    handleBuzzerFlashing();
+    taskDelayMs(GPS_TASK_PERIOD_MS);
+  }
+}
 
-    // Handle white LED flashing when in proximity
-    handleWhiteFlashing();
-  } else {
-    // No GPS fix - show loading animation
-    if (!showingModeDisplay) {
-      // Play loading animation continuously
-      ledDriver.loading(LOADING_INTERVAL);
-
-      // Play signal lost sound if we previously had a fix
-      if (hadGpsFix) {
-        signalSound(true);  // "no signal" sound
-        hadGpsFix = false;
-      }
-
-      // Steady red LED when no GPS fix (unless in mode display)
-      if (!showingModeDisplay) {
-        rgb.setDigitalColor(true, false, false);
-      }
-
-      // Reset state when no GPS fix but still in proximity range
-      if (withinProxRange) {
-        withinProxRange = false;
-        noTone(BUZZER);
-        rgb.allOff();
-      }
-
-      // Stop speed warnings when no GPS
-      stopSpeedWarnings();
+// Evaluate the newest fix against the camera list
+void proximityTask(void *) {
+  FilteredFix fix;
+
+  for (;;) {
+    bool received = false;
+    while (fixQueue.pop(fix)) {
+      received = true;  // Only the newest fix matters
+    }
+
+    if (received) {
+      resultQueue.push(runProximityStage(fix, true));
     }
+
+    taskDelayMs(PROXIMITY_TASK_PERIOD_MS);
   }
 }
 
-// Handle non-blocking white LED flashing
-void handleWhiteFlashing() {
-  if (withinProxRange) {
-    // White LED state follows the buzzer flash state
-    if (buzzerFlashState) {
-      rgb.setDigitalColor(true, true, true);  // White on
-    } else {
-      rgb.allOff();  // Off
+// Button, display, LED and buzzer handling on the newest result
+void uiTask(void *) {
+  ProximityResult result = {};
+
+  for (;;) {
+    ProximityResult next;
+    while (resultQueue.pop(next)) {
+      result = next;
     }
+
+    runUi(result);
+
+    taskDelayMs(UI_TASK_PERIOD_MS);
   }
 }
 
-// Handle mode button press with debouncing and hold-to-reset
-void handleModeButton() {
-  bool currentButtonState = digitalRead(MODE_SW);
+// ---------------------------------------------- UI ----------------------------------------------
 
-  // Button pressed (falling edge detection)
-  if (lastButtonState == HIGH && currentButtonState == LOW) {
-    buttonPressStartTime = millis();
-    buttonHoldProcessed = false;
-  }
+void runUi(const ProximityResult &result) {
+  uiStageTimer.start(telemetry);
 
-  // Button held down - check for hold-to-reset
-  if (currentButtonState == LOW && !buttonHoldProcessed) {
-    if (millis() - buttonPressStartTime >= BUTTON_HOLD_TIME) {
-      // Hold detected - reset to NONE mode
-      currentSpeedMode = NONE;
-      showModeIndication();
-      buttonHoldProcessed = true;
+  // Handle mode button press
+  handleModeButton();
 
-      // Stop any active speed warnings
-      stopSpeedWarnings();
-    }
+  // Speed profile updates over Serial
+  if (SERIAL_COMMANDS && speedProfiles.poll(Serial)) {
+    applySpeedProfile();
   }
 
-  // Button released (rising edge detection)
-  if (lastButtonState == LOW && currentButtonState == HIGH) {
-    // Only process short press if hold wasn't already processed
-    if (!buttonHoldProcessed) {
-      // Short press - cycle through modes
-      currentSpeedMode = (SpeedMode)((currentSpeedMode + 1) % 6);
-      showModeIndication();
+  // Advance the buzzer sequencer
+  buzzer.tick();
 
-      // Stop any active speed warnings
-      stopSpeedWarnings();
-    }
+  // Update functions for custom classes
+  rgb.update();
+
+  // Handle mode display timeout globally
+  if (showingModeDisplay && millis() >= modeDisplayEndTime) {
+    showingModeDisplay = false;
   }
 
-  lastButtonState = currentButtonState;
-}
+  gpsFixValid = result.fix.valid;
 
-// Show mode indication with LED display and sound
-void showModeIndication() {
-  // Display the speed limit for 3 seconds
-  if (currentSpeedMode == NONE) {
-    ledDriver.displayNumber(0);  // Show 0 for no limit
-  } else {
-    ledDriver.displayNumber(speedLimits[currentSpeedMode]);
+  // Get current GPS data
+  if (gpsFixValid) {
+    currentLat = result.fix.latE6 / 1e6;
+    currentLon = result.fix.lonE6 / 1e6;
+    currentSpeed = result.fix.speedKmhX10 / 10;
   }
 
-  showingModeDisplay = true;
-  modeDisplayEndTime = millis() + 3000;  // Show for 3 seconds
+  // Work out the alert state once, then write only what changed
+  AlertCue cue = detector.step(result, showingModeDisplay, currentSpeedLimit(), micros());
 
-  // Turn green LED on and play buzzer tone
-  rgb.allOff();
-  delay(200);
-  rgb.setDigitalColor(false, true, false);
-  tone(BUZZER, 3700, 200);
+  applyAlertOutputs(detector.getAlert().outputs());
+  playAlertCue(cue);
 
-  // Set timers for when to turn off LED and stop sound
-  soundActive = true;
-  soundEndTime = millis() + 200;
-}
+  // Close the latency sample at the first tone of a raised alert
+  if (detector.getLatency().isAlertPending() && buzzer.isSounding() && buzzer.activePriority() >= BUZZER_OVERSPEED) {
+    detector.alertSounded(micros());
+  }
 
-// Helper function to restore normal LED state
-void restoreNormalLedState() {
-  if (gps.hasFix() && !withinProxRange && !showingModeDisplay && !isSpeedWarningActive) {
-    rgb.setDigitalColor(false, true, false);  // Green on for GPS signal
+  if (USE_DRIVE_LOG) {
+    logDrive(result, cue);
   }
-}
 
-// Stop speed warnings and restore normal LED state
-void stopSpeedWarnings() {
-  if (isSpeedWarningActive) {
-    isSpeedWarningActive = false;
-    speedWarningBeepActive = false;
-    speedWarningLedActive = false;
-    noTone(BUZZER);
+  if (REPORT_OUTPUT_STATS && millis() - lastOutputStatsReport >= OUTPUT_STATS_INTERVAL_MS) {
+    lastOutputStatsReport = millis();
+    reportOutputStats();
+  }
 
-    // Restore normal LED state after stopping warnings
-    restoreNormalLedState();
+  if (REPORT_LATENCY_STATS && millis() - lastLatencyStatsReport >= LATENCY_STATS_INTERVAL_MS) {
+    lastLatencyStatsReport = millis();
+    reportLatencyStats();
+  }
+
+  if (USE_TELEMETRY) {
+    if (millis() - lastTelemetryOutputs >= TELEMETRY_OUTPUTS_INTERVAL_MS) {
+      lastTelemetryOutputs = millis();
+      telemetry.writeOutputs(TELEM_CHANNEL_UI, rgb.getOutputStats(), ledDriver.getOutputStats(), buzzer.getOutputStats());
+    }
+    uiStageTimer.stop(telemetry);
+    telemetry.service(Serial, millis());
   }
 }
 
-void handleSpeedLimitWarning() {
-  // If no speed limit mode is set, do nothing
-  if (currentSpeedMode == NONE) {
-    stopSpeedWarnings();
-    return;
+// Bring LED, display and buzzer in line with the desired outputs.
+// The drivers drop writes that would not change anything, so this runs every pass.
+void applyAlertOutputs(const AlertOutputs &out) {
+  // Steady sound: stop the old pattern on change, (re)start the new one
+  // whenever it is not playing (e.g. after a higher priority sound ended)
+  if (out.sound != appliedSound) {
+    stopAlertSound(appliedSound);
+    appliedSound = out.sound;
+  }
+  const BuzzerPattern *pattern = alertSoundPattern(out.sound);
+  if (pattern != nullptr && !buzzer.isPlaying(*pattern)) {
+    buzzer.play(*pattern, alertSoundPriority(out.sound));
   }
 
-  int speedLimit = speedLimits[currentSpeedMode];
-  int speedDifference = currentSpeed - speedLimit;
+  // LED
+  bool red = false, green = false, blue = false;
+  switch (out.led) {
+    case ALERT_LED_RED:
+      red = true;
+      break;
+    case ALERT_LED_GREEN:
+      green = true;
+      break;
+    case ALERT_LED_MODE_BLINK:
+      green = millis() - modeDisplayStartTime >= MODE_LED_BLINK_MS;
+      break;
+    case ALERT_LED_BEEP_WHITE:
+      red = green = blue = buzzer.isSounding();
+      break;
+    case ALERT_LED_DEGRADED:
+      blue = true;
+      break;
+  }
+  rgb.setDigitalColor(red, green, blue);
 
-  if (speedDifference > 0) {
-    // Over speed limit
-    if (!isSpeedWarningActive) {
-      isSpeedWarningActive = true;
-      lastSpeedWarningTime = millis();
-    }
+  // Display
+  switch (out.display) {
+    case ALERT_DISPLAY_LOADING:
+      ledDriver.updateLoading(LOADING_INTERVAL);
+      break;
+    case ALERT_DISPLAY_SPEED:
+      ledDriver.displayNumber(currentSpeed);
+      break;
+    case ALERT_DISPLAY_MODE:
+      ledDriver.displayNumber(currentSpeedLimit());  // 0 for automatic
+      break;
+  }
+}
 
-    // Calculate warning intensity based on speed difference
-    unsigned long warningInterval;
-
-    if (speedDifference <= 5) {
-      // 1-5 km/h over: slow beeping
-      warningInterval = 500;  // 0.5 second interval
-    } else if (speedDifference <= 15) {
-      // 6-15 km/h over: medium beeping
-      warningInterval = 250;  // 0.25 second interval
-    } else {
-      // 15+ km/h over: fast beeping
-      warningInterval = 150;  // 0.15 second interval
-    }
+// Fixes at 1 Hz, alert changes and cues as they happen, loop timing once a minute.
+// Records collect in RAM; service() writes at most one flash page per pass.
+void logDrive(const ProximityResult &result, AlertCue cue) {
+  unsigned long now = millis();
+  unsigned long nowMicros = micros();
+
+  if (lastUiPassMicros != 0) {
+    uint32_t passUs = nowMicros - lastUiPassMicros;
+    uiPassTotalUs += passUs;
+    uiPassCount++;
+    if (passUs > uiPassMaxUs) uiPassMaxUs = passUs;
+  }
+  lastUiPassMicros = nowMicros;
+
+  // The measured fix, so replays see what the receiver reported
+  const GpsFix &fix = result.measured;
+  if (fix.valid && now - lastFixLogTime >= LOG_FIX_INTERVAL_MS) {
+    uint8_t flags = LOG_FLAG_VALID;
+    if (result.inRange) flags |= LOG_FLAG_PROXIMITY;
+    if (detector.getAlert().getBaseState() == ALERT_OVERSPEED) flags |= LOG_FLAG_OVERSPEED;
+    if (fix.courseCdeg != GPS_COURSE_UNKNOWN) flags |= LOG_FLAG_COURSE;
+
+    driveLog.logFix(now, fix.latE6, fix.lonE6, fix.speedKmhX10, flags, fix.courseCdeg);
+    lastFixLogTime = now;
+  }
 
-    // Handle beeping timing
-    unsigned long currentTime = millis();
-    if (currentTime - lastSpeedWarningTime >= warningInterval) {
-      if (!speedWarningBeepActive) {
-        tone(BUZZER, 3700, 100);  // Short beep
-        speedWarningBeepActive = true;
-        speedWarningBeepEndTime = currentTime + 100;
-
-        // Start white LED flashing
-        rgb.allOff();                           // Clear all LEDs first
-        rgb.setDigitalColor(true, true, true);  // White (all LEDs on)
-        speedWarningLedActive = true;
-        speedWarningLedEndTime = currentTime + (warningInterval / 2);
-
-        lastSpeedWarningTime = currentTime;
-      }
-    }
+  if (detector.getAlert().getState() != loggedAlertState) {
+    loggedAlertState = detector.getAlert().getState();
+    driveLog.logEvent(now, LOG_EVENT_ALERT_STATE, loggedAlertState);
+  }
 
-    // Handle LED state changes
-    if (speedWarningLedActive) {
-      if (currentTime >= speedWarningLedEndTime) {
-        if (currentTime < lastSpeedWarningTime + warningInterval) {
-          // Turn off LED for second half (flash off)
-          rgb.allOff();
-          speedWarningLedEndTime = lastSpeedWarningTime + warningInterval;
-        } else {
-          // End of cycle - turn off LED and prepare for next cycle
-          rgb.allOff();
-          speedWarningLedActive = false;
-        }
-      }
-    }
+  if (cue != ALERT_CUE_NONE) {
+    driveLog.logEvent(now, LOG_EVENT_ALERT_CUE, cue);
+  }
 
-    // Reset beep flag when beep ends
-    if (speedWarningBeepActive && currentTime >= speedWarningBeepEndTime) {
-      speedWarningBeepActive = false;
-    }
+  // Signal lost: often the end of a drive, get the last page to flash
+  if (cue == ALERT_CUE_SIGNAL_LOST) {
+    driveLog.sync();
+  }
 
-  } else {
-    // Under speed limit - stop warnings
-    stopSpeedWarnings();
+  if (now - lastLoopStatsLogTime >= LOG_LOOP_STATS_INTERVAL_MS && uiPassCount > 0) {
+    driveLog.logLoopStats(now, uiPassTotalUs / uiPassCount, uiPassMaxUs, uiPassCount);
+    lastLoopStatsLogTime = now;
+    uiPassTotalUs = 0;
+    uiPassMaxUs = 0;
+    uiPassCount = 0;
   }
+
+  driveLog.service();
 }
 
-// Function to check distance between traffipax and you
-void checkProximityToTraffipax() {
-  // Adjust proximity range based on speed
-  if (currentSpeed <= 50) {
-    // below or at 50km/h
-    proximityRange = 300;  // meters
-  } else if (currentSpeed <= 70) {
-    // between 51 and 70km/h
-    proximityRange = 400;  // meters
-  } else {
-    // above 70km/h
-    proximityRange = 500;  // meters
+// Erase drive log sectors before the writer reaches them, so the UI pass
+// only ever writes pages
+void driveLogEraseTask(void *) {
+  for (;;) {
+    driveLog.eraseAhead();
+    taskDelayMs(DRIVE_LOG_ERASE_PERIOD_MS);
   }
+}
 
-  bool traffipaxFound = false;
+// One line per device: writes that went out / writes that were skipped
+void reportOutputStats() {
+  const OutputStats &led = rgb.getOutputStats();
+  const OutputStats &display = ledDriver.getOutputStats();
+  const OutputStats &sound = buzzer.getOutputStats();
 
-  for (int i = 0; i < sizeof(coordinates) / sizeof(coordinates[0]); i++) {
-    // Access lat + lon from flash memory
-    double lat = coordinates[i].lat;
-    double lon = coordinates[i].lon;
+  Serial.printf("outputs @%lus led %lu/%lu display %lu/%lu buzzer %lu/%lu\n", millis() / 1000,
+                (unsigned long)led.written, (unsigned long)led.elided,
+                (unsigned long)display.written, (unsigned long)display.elided,
+                (unsigned long)sound.written, (unsigned long)sound.elided);
+}
 
-    double distance = getDistance(currentLat, currentLon, lat, lon);
+// Fix age and fix-to-alert latency over the last samples (ms), and how
+// often the fix stream went stale
+void reportLatencyStats() {
+  const FixLatency &latency = detector.getLatency();
+  const RollingStats<32> &age = latency.getFixAge();
+  const RollingStats<16> &alert = latency.getAlertLatency();
+
+  Serial.printf("latency @%lus fix age p50 %.1f p95 %.1f max %.1f, alert p50 %.1f max %.1f (%lu), stale %lu\n",
+                millis() / 1000, age.percentile(50) / 1000.0, age.percentile(95) / 1000.0, age.max() / 1000.0,
+                alert.percentile(50) / 1000.0, alert.max() / 1000.0, (unsigned long)alert.getTotal(),
+                (unsigned long)latency.getStaleEvents());
+}
 
-    if (distance <= proximityRange) {
-      traffipaxFound = true;
+// Filter health: mean y^2 / S per axis (about 1 when the tuning fits the
+// receiver), RMS position innovation, rejected positions and restarts
+void reportKalmanStats() {
+  const GpsKalmanStats &stats = kalman.getStats();
+  uint32_t predicted = stats.updates - stats.resets;
+
+  if (predicted > 0) {
+    Serial.printf("kalman @%lus fixes %lu nis %.2f innovation %.2f m rejected %lu resets %lu\n", millis() / 1000,
+                  (unsigned long)stats.updates, stats.nisSumX100 / 200.0 / predicted,
+                  sqrt((double)stats.innovationSumSqCm2 / predicted) / 100.0,
+                  (unsigned long)stats.rejected, (unsigned long)stats.resets);
+  }
+  kalman.clearStats();
+}
 
-      if (!withinProxRange) {
-        withinProxRange = true;  // Prevent repeated alerts
+const BuzzerPattern *alertSoundPattern(AlertSound sound) {
+  switch (sound) {
+    case ALERT_SOUND_PROXIMITY: return &PROXIMITY_ALERT;
+    case ALERT_SOUND_OVERSPEED_SLOW: return &OVERSPEED_SLOW;
+    case ALERT_SOUND_OVERSPEED_MEDIUM: return &OVERSPEED_MEDIUM;
+    case ALERT_SOUND_OVERSPEED_FAST: return &OVERSPEED_FAST;
+    default: return nullptr;
+  }
+}
 
-        // Stop any speed warnings when entering traffipax proximity
-        stopSpeedWarnings();
+uint8_t alertSoundPriority(AlertSound sound) {
+  return sound == ALERT_SOUND_PROXIMITY ? BUZZER_PROXIMITY : BUZZER_OVERSPEED;
+}
 
-        // Start by turning leds off and begin flashing
-        rgb.allOff();
-        buzzerFlashTimer = millis();                    // Initialize buzzer timer
-        rgb.startWhiteFlashing(BUZZER_FLASH_INTERVAL);  // Start non-blocking white flash
-      }
+void stopAlertSound(AlertSound sound) {
+  const BuzzerPattern *pattern = alertSoundPattern(sound);
+  if (pattern != nullptr && buzzer.isPlaying(*pattern)) {
+    buzzer.stop(alertSoundPriority(sound));
+  }
+}
 
+// One-shot sounds on state transitions
+void playAlertCue(AlertCue cue) {
+  switch (cue) {
+    case ALERT_CUE_SIGNAL_FOUND:
+      signalSound(false);
+      break;
+    case ALERT_CUE_SIGNAL_LOST:
+      signalSound(true);
+      break;
+    case ALERT_CUE_PROXIMITY_EXIT:
+      // 2 second beep at 3700Hz, at alert priority so warnings do not cut it off
+      buzzer.play(PROXIMITY_EXIT, BUZZER_PROXIMITY);
+      break;
+    case ALERT_CUE_ZONE_ENTER:
+      buzzer.play(ZONE_ENTER, BUZZER_UI);
+      break;
+    default:
       break;
-    }
   }
+}
 
-  if (!traffipaxFound && withinProxRange) {
-    // We just left the proximity zone - play exit sound
-    withinProxRange = false;
-    justLeftProxRange = true;
-
-    // Stop flashing and switch back to GREEN
-    rgb.stopWhiteFlashing();  // Stop white flashing
-    rgb.setDigitalColor(false, true, false);
-
-    // Stop any buzzer activity
-    noTone(BUZZER);
+// Push the loaded profile into the alert bands and the overspeed beep gaps
+void applySpeedProfile() {
+  const SpeedProfile &profile = speedProfiles.get();
 
-    // Play the exit sound - 2 second beep at 3700Hz
-    tone(BUZZER, 3700, 2000);
-  } else if (!traffipaxFound && !withinProxRange) {
-    // Normal operation outside proximity - ensure GREEN is on (unless speed warning is active)
-    if (!isSpeedWarningActive && gps.hasFix() && !showingModeDisplay) {
-      rgb.setDigitalColor(false, true, false);
-    }
+  detector.getAlert().setOverspeedBands(profile.slowBandKmh, profile.mediumBandKmh);
+  OVERSPEED_SLOW_NOTES[0].gapMs = profile.slowGapMs;
+  OVERSPEED_MEDIUM_NOTES[0].gapMs = profile.mediumGapMs;
+  OVERSPEED_FAST_NOTES[0].gapMs = profile.fastGapMs;
 
-    // Reset the flag once we're out
-    justLeftProxRange = false;
+  if (speedLimitIndex >= profile.limitCount) {
+    speedLimitIndex = 0;
   }
 }
 
-// Function to handle buzzer flashing in sync with RGB
-void handleBuzzerFlashing() {
-  if (withinProxRange) {
-    unsigned long currentTime = millis();
+// Limit selected with the button (0 = automatic / none)
+int currentSpeedLimit() {
+  return speedProfiles.get().limitsKmh[speedLimitIndex];
+}
 
-    if (currentTime - buzzerFlashTimer >= BUZZER_FLASH_INTERVAL) {
-      if (buzzerFlashState) {
-        // Turn buzzer on and white LED on
-        tone(BUZZER, 3700, BUZZER_FLASH_INTERVAL);
-        rgb.setDigitalColor(true, true, true);  // White on
-      } else {
-        // Turn buzzer off and white LED off
-        noTone(BUZZER);
-        rgb.allOff();  // Off
-      }
+// Mode button edge (interrupt): timestamp the new level, active low
+void IRAM_ATTR modeButtonEdge() {
+  modeButton.onEdge(digitalRead(MODE_SW) == LOW, millis());
+}
 
-      buzzerFlashState = !buzzerFlashState;
-      buzzerFlashTimer = currentTime;
+// Act on the gestures decoded from the queued edges, nothing to do while idle
+void handleModeButton() {
+  if (modeButton.isIdle()) {
+    return;
+  }
+
+  uint8_t limitCount = speedProfiles.get().limitCount;
+  for (ButtonGesture gesture; (gesture = modeButton.poll(millis())) != BUTTON_NONE;) {
+    switch (gesture) {
+      case BUTTON_SHORT:
+        // Cycle through modes
+        speedLimitIndex = (speedLimitIndex + 1) % limitCount;
+        break;
+      case BUTTON_DOUBLE:
+        // Step back one mode
+        speedLimitIndex = (speedLimitIndex + limitCount - 1) % limitCount;
+        break;
+      case BUTTON_LONG:
+        // Reset to the first limit (no limit in the default profile)
+        speedLimitIndex = 0;
+        break;
+      default:
+        break;
     }
+    showModeIndication();
   }
 }
 
+// Show mode indication: the state machine shows the limit and blinks the LED
+// for 3 seconds, the chirp plays from here
+void showModeIndication() {
+  showingModeDisplay = true;
+  modeDisplayStartTime = millis();
+  modeDisplayEndTime = modeDisplayStartTime + 3000;  // Show for 3 seconds
+
+  if (USE_DRIVE_LOG) {
+    driveLog.logEvent(modeDisplayStartTime, LOG_EVENT_SPEED_LIMIT, currentSpeedLimit());
+    driveLog.sync();
+  }
+
+  // Speed warnings pause while the mode is shown, so they do not cut off the chirp
+  buzzer.stop(BUZZER_OVERSPEED);
+  buzzer.play(MODE_CHIRP, BUZZER_UI);
+}
+
 // Boot beeping sound with reduced intensity
 void bootUpSound() {
-  int baseFreq = 3300;
-  for (int i = 0; i < 3; i++) {
-    tone(BUZZER, baseFreq, 100);
-    delay(150);
-    baseFreq += 200;
-  }
-  noTone(BUZZER);
+  buzzer.play(BOOT_SOUND, BUZZER_UI);
 }
 
 // Function to play sound based on state
 void signalSound(bool isSearching) {
-  int freq = isSearching ? 2500 : 4000;
+  buzzer.play(isSearching ? SIGNAL_LOST_SOUND : SIGNAL_FOUND_SOUND, BUZZER_UI);
+}
+
+// Cycles per distance from the first camera to the next ones, double
+// haversine vs integer vs the unit vector chord test, and the largest
+// difference in meters
+void benchmarkGeodesy() {
+  const size_t count = 32;
+  int32_t latE6[count], lonE6[count];
+  for (size_t i = 0; i < count; i++) {
+    latE6[i] = toE6(coordinates[i].lat);
+    lonE6[i] = toE6(coordinates[i].lon);
+  }
+
+  volatile double doubleSum = 0;
+  volatile uint32_t fixedSum = 0;
+  uint32_t start = ESP.getCycleCount();
+  for (size_t i = 0; i < count; i++) {
+    doubleSum += getDistance(coordinates[0].lat, coordinates[0].lon, coordinates[i].lat, coordinates[i].lon);
+  }
+  uint32_t doubleCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (size_t i = 0; i < count; i++) {
+    fixedSum += geoDistanceM(latE6[0], lonE6[0], latE6[i], lonE6[i]);
+  }
+  uint32_t fixedCycles = ESP.getCycleCount() - start;
 
-  // Play two simple beeps
-  tone(BUZZER, freq, 100);
-  delay(150);
-  tone(BUZZER, freq, 100);
-  delay(150);
-  noTone(BUZZER);
+  // Per-camera cost of the radius test on unit vectors (forEachWithin)
+  GeoVector vectors[count];
+  for (size_t i = 0; i < count; i++) {
+    vectors[i] = geoVector(latE6[i], lonE6[i]);
+  }
+  volatile uint32_t chordHits = 0;
+  uint64_t limit = geoChordSqForMeters(1000);
+  start = ESP.getCycleCount();
+  for (size_t i = 0; i < count; i++) {
+    chordHits += geoChordSq(vectors[0], vectors[i]) <= limit;
+  }
+  uint32_t chordCycles = ESP.getCycleCount() - start;
+
+  double maxError = 0;
+  for (size_t i = 0; i < count; i++) {
+    double error = fabs(geoDistanceM(latE6[0], lonE6[0], latE6[i], lonE6[i])
+                        - getDistance(coordinates[0].lat, coordinates[0].lon, coordinates[i].lat, coordinates[i].lon));
+    if (error > maxError) maxError = error;
+  }
+
+  Serial.printf("geodesy cycles/distance double %lu integer %lu chord test %lu, max difference %.2f m\n",
+                (unsigned long)(doubleCycles / count), (unsigned long)(fixedCycles / count),
+                (unsigned long)(chordCycles / count), maxError);
 }
 
 // Function to convert degrees to radians
@@ -475,6 +771,7 @@ double toRadians(double degree) {
 }
 
 // Function to calculate distance between 2 latitude and longitude points
+// (double reference for benchmarkGeodesy)
 double getDistance(double lat1, double lon1, double lat2, double lon2) {
   // Convert latitudes and longitudes to radians
   lat1 = toRadians(lat1);
@@ -494,4 +791,67 @@ double getDistance(double lat1, double lon1, double lat2, double lon2) {
 
   // Distance in meters
   return R * c;
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------- Fix filter ----------------------------------------------
+
+// Feed a fresh fix to the Kalman filter (GPS stage); a lost fix ends the track.
+// The stats are reported from here too, so only the GPS stage touches the filter.
+void filterFix(const GpsFix &fix) {
+  if (!USE_KALMAN_FILTER) {
+    return;
+  }
+
+  if (fix.valid) {
+    int32_t course = fix.courseCdeg == GPS_COURSE_UNKNOWN ? -1 : fix.courseCdeg;
+    kalman.update(fix.latE6, fix.lonE6, fix.speedKmhX10, course, fix.timestampMs);
+  } else {
+    kalman.stop();
+  }
+
+  if (REPORT_KALMAN_STATS && millis() - lastKalmanStatsReport >= KALMAN_STATS_INTERVAL_MS) {
+    lastKalmanStatsReport = millis();
+    reportKalmanStats();
+  }
+}
+
+// The fix handed to the later stages: the filter estimate while it runs
+FilteredFix filteredFix(const GpsFix &fix) {
+  FilteredFix result = { fix, fix };
+
+  if (USE_KALMAN_FILTER && fix.valid && kalman.isRunning()) {
+    result.fix.latE6 = kalman.getLatE6();
+    result.fix.lonE6 = kalman.getLonE6();
+    result.fix.speedKmhX10 = kalman.getSpeedKmhX10();
+  }
+  return result;
+}
+
+// ---------------------------------------------- Warm start ----------------------------------------------
+
+// Keep the warm start record current and the system clock on GPS time (GPS stage)
+void trackWarmStart(const GpsFix &fix) {
+  if (!USE_WARM_START) {
+    return;
+  }
+
+  int64_t utcMs;
+  if (!gps.getUtcMs(utcMs)) {
+    utcMs = -1;
+  }
+  if (warmStart.update(fix, gps.getAltitudeDm(), utcMs, systemClockMs())) {
+    setSystemClockMs(utcMs);
+  }
+}
+
+// System clock in ms since 1970. Runs on across software resets and deep sleep.
+int64_t systemClockMs() {
+  timeval now;
+  gettimeofday(&now, nullptr);
+  return (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+void setSystemClockMs(int64_t ms) {
+  timeval now = { (time_t)(ms / 1000), (suseconds_t)(ms % 1000 * 1000) };
+  settimeofday(&now, nullptr);
+}
@@ -0,0 +1,13 @@
+// Alert zones: school zones, roadworks and low-emission areas as polygons.
+// zoneVertices[] holds the corners, { lat, lon }, zones[] one line per zone:
+// { kind, limit km/h (0 = none), first vertex, vertex count }. The corners
+// go around the zone in either direction and the last one connects back to
+// the first. Zones with fewer than 3 vertices are ignored.
+
+constexpr ZoneVertex zoneVertices[] = {
+  { 0, 0 }  // placeholder
+};
+
+constexpr AlertZone zones[] = {
+  { ZONE_NONE, 0, 0, 0 }  // placeholder, the layer is empty until zones are added
+};